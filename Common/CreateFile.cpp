@@ -79,8 +79,11 @@ int GetFileFormatFromExtension(const std::string &ext)
 
 int GuessFileFormatFromFileName(const std::string &fileName)
 {
-  std::string ext = SplitFileName(fileName)[2];
-  return GetFileFormatFromExtension(ext);
+  std::vector<std::string> split = SplitFileName(fileName);
+  // compressed MSH files (e.g. "mesh.msh.gz") are written on the fly
+  if(split[2] == ".gz" && SplitFileName(split[1])[2] == ".msh")
+    return FORMAT_MSH;
+  return GetFileFormatFromExtension(split[2]);
 }
 
 std::string GetDefaultFileName(int format)
@@ -225,11 +228,35 @@ void change_print_parameter(int frame)
   ParseString(CTX::instance()->print.parameterCommand);
 }
 
+// a compact mesh (see GModel::compactifyMesh) can only be saved by the MSH
+// (non-partitioned) and VTK writers: the other mesh writers only see the object
+// mesh, which has been deleted
+static bool compactMeshCannotBeSaved(int format)
+{
+  if(!GModel::current()->getCompactMesh()) return false;
+  switch(format){
+  case FORMAT_MSH:
+    if(!GModel::current()->getMeshPartitions().size() ||
+       CTX::instance()->mesh.mshFilePartitioned != 1) return false;
+    break;
+  case FORMAT_STL: case FORMAT_VRML: case FORMAT_PLY2: case FORMAT_UNV:
+  case FORMAT_MESH: case FORMAT_MAIL: case FORMAT_IR3: case FORMAT_BDF:
+  case FORMAT_DIFF: case FORMAT_INP: case FORMAT_CELUM: case FORMAT_SU2:
+  case FORMAT_P3D: case FORMAT_CGNS: case FORMAT_MED:
+    break;
+  default:
+    return false;
+  }
+  Msg::Error("Compact meshes can only be saved in MSH (one file) or VTK format");
+  return true;
+}
+
 void CreateOutputFile(const std::string &fileName, int format,
                       bool status, bool redraw)
 {
   std::string name = fileName;
   if(name.empty()) name = GetDefaultFileName(format);
+  if(compactMeshCannotBeSaved(format)) return;
 
   int oldFormat = CTX::instance()->print.fileFormat;
   CTX::instance()->print.fileFormat = format;
@@ -963,9 +963,18 @@ StringXNumber MeshOptions_Number[] = {
   { F|O, "ColorCarousel" , opt_mesh_color_carousel , 1. ,
     "Mesh coloring (0=by element type, 1=by elementary entity, 2=by physical "
     "entity, 3=by partition)" },
+  { F|O, "Compact" , opt_mesh_compact , 0. ,
+    "Convert the mesh into a compact, read-only representation before saving "
+    "it in batch mode (the mesh can then only be saved in MSH 2 or VTK format, "
+    "and cannot be partitioned)" },
   { F,   "CpuTime" , opt_mesh_cpu_time , 0. ,
     "CPU time (in seconds) for the generation of the current mesh (read-only)" },
 
+  { F|O, "DelaunayBatchSize3D" , opt_mesh_delaunay_batch_size_3d , 0. ,
+    "Number of points per thread inserted in each batch of the 3D Delaunay "
+    "refinement, the cavities of a batch being computed in parallel (0: insert "
+    "points one by one)" },
+
   { F|O, "DrawSkinOnly" , opt_mesh_draw_skin_only , 0. ,
     "Draw only the skin of 3D meshes?" },
   { F|O, "Dual" , opt_mesh_dual , 0. ,
@@ -1021,6 +1030,9 @@ StringXNumber MeshOptions_Number[] = {
   { F|O, "LineWidth" , opt_mesh_line_width , 1.0 ,
     "Display width of mesh lines (in pixels)" },
 
+  { F|O, "MaxNumThreads2D" , opt_mesh_max_num_threads_2d , 0. ,
+    "Maximum number of threads used to mesh surfaces in parallel (0: use the "
+    "number of OpenMP threads)" },
   { F|O, "MeshOnlyVisible" , opt_mesh_mesh_only_visible, 0. ,
     "Mesh only visible entities (experimental: use with caution!)" },
   { F|O, "MetisAlgorithm" , opt_mesh_partition_metis_algorithm, 1. ,
@@ -1035,6 +1047,12 @@ StringXNumber MeshOptions_Number[] = {
     "Minimum number of points used to mesh a circle" },
   { F|O, "MinimumCurvePoints" , opt_mesh_min_curv_points, 3. ,
     "Minimum number of points used to mesh a (non-straight) curve" },
+  { F|O, "MshFileBufferedRead" , opt_mesh_msh_file_buffered_read , 1. ,
+    "Read MSH files by large blocks: ASCII numbers are converted in parallel, and "
+    "binary files are mapped in memory (0: read number by number)" },
+  { F|O, "MshFileParallelWrite" , opt_mesh_msh_file_parallel_write , 1. ,
+    "Format nodes and elements in parallel when writing MSH files (the output is "
+    "identical to the sequential one)" },
   { F|O, "MshFileVersion" , opt_mesh_msh_file_version , 2.2 ,
     "Version of the MSH file format to use" },
   { F|O, "MshFilePartitioned" , opt_mesh_msh_file_partitioned , 0. ,
@@ -251,6 +251,8 @@ int GmshBatch()
     }
 #endif
 #endif
+    if(CTX::instance()->mesh.compact)
+      GModel::current()->compactifyMesh();
     std::string name = CTX::instance()->outputFileName;
     if(name.empty()){
       if(CTX::instance()->mesh.fileFormat == FORMAT_AUTO)
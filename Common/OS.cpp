@@ -27,8 +27,10 @@
 
 #if !defined(WIN32) || defined(__CYGWIN__)
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/time.h>
 #include <sys/resource.h>
+#include <sys/mman.h>
 #endif
 
 #if defined(WIN32)
@@ -42,6 +44,10 @@
 #include <fstream>
 #endif
 
+#if defined(HAVE_LIBZ)
+#include <zlib.h>
+#endif
+
 #include "GmshMessage.h"
 
 #if defined(WIN32) && !defined(__CYGWIN__)
@@ -170,6 +176,81 @@ FILE *Fopen(const char *f, const char *mode)
 #endif
 }
 
+// write-only streams with custom write functions (available with the GNU C
+// library and on BSD-derived systems)
+#if defined(__GLIBC__) || defined(__APPLE__)
+#define HAVE_CUSTOM_STREAMS
+
+#if defined(__GLIBC__)
+typedef ssize_t streamSize_t;
+typedef size_t streamLength_t;
+#else
+typedef int streamSize_t;
+typedef int streamLength_t;
+#endif
+
+static streamSize_t memoryWrite(void *cookie, const char *buf, streamLength_t size)
+{
+  ((std::string*)cookie)->append(buf, size);
+  return size;
+}
+
+static int memoryClose(void *cookie)
+{
+  return 0;
+}
+
+#if defined(HAVE_LIBZ)
+static streamSize_t gzipWrite(void *cookie, const char *buf, streamLength_t size)
+{
+  return gzwrite((gzFile)cookie, buf, (unsigned)size);
+}
+
+static int gzipClose(void *cookie)
+{
+  return (gzclose((gzFile)cookie) == Z_OK) ? 0 : EOF;
+}
+#endif
+
+static FILE *openCustomStream(void *cookie,
+                              streamSize_t (*write)(void*, const char*,
+                                                    streamLength_t),
+                              int (*close)(void*))
+{
+#if defined(__GLIBC__)
+  cookie_io_functions_t io = {0, write, 0, close};
+  FILE *fp = fopencookie(cookie, "w", io);
+#else
+  FILE *fp = funopen(cookie, 0, write, 0, close);
+#endif
+  if(fp) setvbuf(fp, 0, _IOFBF, 1 << 16);
+  return fp;
+}
+
+#endif
+
+FILE *FopenMemory(std::string *buffer)
+{
+#if defined(HAVE_CUSTOM_STREAMS)
+  return openCustomStream(buffer, memoryWrite, memoryClose);
+#else
+  return 0;
+#endif
+}
+
+FILE *FopenCompressed(const char *f, const char *mode)
+{
+#if defined(HAVE_CUSTOM_STREAMS) && defined(HAVE_LIBZ)
+  gzFile gz = gzopen(f, mode);
+  if(!gz) return 0;
+  FILE *fp = openCustomStream(gz, gzipWrite, gzipClose);
+  if(!fp) gzclose(gz);
+  return fp;
+#else
+  return 0;
+#endif
+}
+
 const char *GetEnvironmentVar(const char *var)
 {
 #if defined(WIN32) && !defined(__CYGWIN__)
@@ -341,6 +422,56 @@ int StatFile(const std::string &fileName)
   return ret;
 }
 
+const char *MapFile(const std::string &fileName, size_t &size)
+{
+  size = 0;
+#if defined(WIN32) && !defined(__CYGWIN__)
+  setwbuf(0, fileName.c_str());
+  HANDLE file = CreateFileW(wbuf[0], GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if(file == INVALID_HANDLE_VALUE) return 0;
+  LARGE_INTEGER fileSize;
+  if(!GetFileSizeEx(file, &fileSize) || !fileSize.QuadPart ||
+     (unsigned long long)fileSize.QuadPart > (size_t)-1){
+    CloseHandle(file);
+    return 0;
+  }
+  HANDLE mapping = CreateFileMapping(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(file);
+  if(!mapping) return 0;
+  // the view remains valid after the handles are closed
+  void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if(!data) return 0;
+  size = (size_t)fileSize.QuadPart;
+  return (const char*)data;
+#else
+  int fd = open(fileName.c_str(), O_RDONLY);
+  if(fd < 0) return 0;
+  struct stat buf;
+  if(fstat(fd, &buf) || buf.st_size <= 0){
+    close(fd);
+    return 0;
+  }
+  void *data = mmap(0, buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if(data == MAP_FAILED) return 0;
+  madvise(data, buf.st_size, MADV_SEQUENTIAL);
+  size = buf.st_size;
+  return (const char*)data;
+#endif
+}
+
+void UnmapFile(const char *data, size_t size)
+{
+  if(!data) return;
+#if defined(WIN32) && !defined(__CYGWIN__)
+  UnmapViewOfFile(data);
+#else
+  munmap((void*)data, size);
+#endif
+}
+
 int CreateSingleDir(const std::string &dirName)
 {
 #if defined(WIN32) && !defined(__CYGWIN__)
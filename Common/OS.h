@@ -21,6 +21,8 @@ int GetProcessId();
 std::string GetHostName();
 int UnlinkFile(const std::string &fileName);
 int StatFile(const std::string &fileName);
+const char *MapFile(const std::string &fileName, size_t &size);
+void UnmapFile(const char *data, size_t size);
 int KillProcess(int pid);
 int CreateSingleDir(const std::string &dirName);
 void CreatePath(const std::string &fullPath);
@@ -28,5 +30,11 @@ int SystemCall(const std::string &command, bool blocking=false);
 std::string GetCurrentWorkdir();
 void RedirectIOToConsole();
 FILE *Fopen(const char* f, const char *mode);
+// stream appending everything written to it in the given buffer (returns 0
+// if not available on this system)
+FILE *FopenMemory(std::string *buffer);
+// write-only stream compressed on the fly with zlib (returns 0 if not
+// available)
+FILE *FopenCompressed(const char *f, const char *mode);
 
 #endif
@@ -84,7 +84,16 @@ void *Octree_Search(double *pt, Octree *myOctree)
 {
   if(!myOctree) return 0;
   return searchElement(myOctree->root, pt, myOctree->info, 
-                       myOctree->function_BB, myOctree->function_inElement);
+                       myOctree->function_BB, myOctree->function_inElement,
+                       &myOctree->info->ptrToPrevElement);
+}
+
+void *Octree_SearchFrom(double *pt, Octree *myOctree, void **previous)
+{
+  if(!myOctree) return 0;
+  return searchElement(myOctree->root, pt, myOctree->info, 
+                       myOctree->function_BB, myOctree->function_inElement,
+                       previous);
 }
 
 void Octree_SearchAll(double *pt, Octree *myOctree, std::vector<void*> *output)
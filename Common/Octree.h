@@ -20,6 +20,10 @@ void Octree_Delete(Octree *);
 void Octree_Insert(void *, Octree *);
 void Octree_Arrange(Octree *);
 void *Octree_Search(double *, Octree *);
+// same as Octree_Search, but starts by testing the element *previous (which is
+// updated with the element found) instead of the last element found by the
+// octree: can be called concurrently with distinct "previous" pointers
+void *Octree_SearchFrom(double *, Octree *, void **previous);
 void Octree_SearchAll(double *, Octree *, std::vector<void *> *);
 
 #endif
@@ -280,13 +280,14 @@ int subdivideOctantBucket(octantBucket *_bucket, globalInfo *_globalPara)
 }
 
 void *searchElement(octantBucket *_buckets_head, double *_pt, globalInfo *_globalPara,
-                    BBFunction BBElement, InEleFunction xyzInElement)
+                    BBFunction BBElement, InEleFunction xyzInElement,
+                    void **_ptrToPrevElement)
 {
   int flag;
   octantBucket *ptrBucket;
   ELink ptr1;
   std::vector<void*>::iterator iter;
-  void * ptrToEle = _globalPara->ptrToPrevElement;
+  void * ptrToEle = *_ptrToPrevElement;
 
   if (ptrToEle) {
     flag = xyzInElementBB(_pt, ptrToEle, BBElement);
@@ -318,7 +319,7 @@ void *searchElement(octantBucket *_buckets_head, double *_pt, globalInfo *_globa
     if (flag == 1)
       flag = xyzInElement(ptr1->region, _pt);
     if (flag == 1) {
-      _globalPara->ptrToPrevElement = ptr1->region;
+      *_ptrToPrevElement = ptr1->region;
       return ptr1->region;
     }
     ptr1 = ptr1->next;
@@ -330,7 +331,7 @@ void *searchElement(octantBucket *_buckets_head, double *_pt, globalInfo *_globa
     if (flag == 1)
       flag = xyzInElement(*iter, _pt);
     if (flag == 1) {
-      _globalPara->ptrToPrevElement = *iter;
+      *_ptrToPrevElement = *iter;
       return *iter;
     }
   }
@@ -71,7 +71,7 @@ int checkElementInBucket(octantBucket *bucket, void * element);
 octantBucket *findElementBucket(octantBucket *buckets, double *pt);
 void *searchElement(octantBucket *buckets, double *pt, 
                     globalInfo *globalPara, BBFunction BBElement, 
-                    InEleFunction xyzInElement);
+                    InEleFunction xyzInElement, void **ptrToPrevElement);
 int xyzInElementBB(double *xyz, void *region, BBFunction BBElement);
 void insertOneBB(void *, double *, double *, octantBucket *);
 void *searchAllElements(octantBucket *_buckets_head, double *_pt, 
@@ -5309,6 +5309,20 @@ double opt_mesh_newton_convergence_test_xyz(OPT_ARGS_NUM)
   return CTX::instance()->mesh.NewtonConvergenceTestXYZ;
 }
 
+double opt_mesh_msh_file_buffered_read(OPT_ARGS_NUM)
+{
+  if(action & GMSH_SET)
+    CTX::instance()->mesh.mshFileBufferedRead = (int)val;
+  return CTX::instance()->mesh.mshFileBufferedRead;
+}
+
+double opt_mesh_msh_file_parallel_write(OPT_ARGS_NUM)
+{
+  if(action & GMSH_SET)
+    CTX::instance()->mesh.mshFileParallelWrite = (int)val;
+  return CTX::instance()->mesh.mshFileParallelWrite;
+}
+
 double opt_mesh_msh_file_version(OPT_ARGS_NUM)
 {
   if(action & GMSH_SET)
@@ -5624,6 +5638,20 @@ double opt_mesh_algo3d(OPT_ARGS_NUM)
   return CTX::instance()->mesh.algo3d;
 }
 
+double opt_mesh_delaunay_batch_size_3d(OPT_ARGS_NUM)
+{
+  if(action & GMSH_SET)
+    CTX::instance()->mesh.delaunayBatchSize3d = (int)val;
+  return CTX::instance()->mesh.delaunayBatchSize3d;
+}
+
+double opt_mesh_max_num_threads_2d(OPT_ARGS_NUM)
+{
+  if(action & GMSH_SET)
+    CTX::instance()->mesh.maxNumThreads2D = (int)val;
+  return CTX::instance()->mesh.maxNumThreads2D;
+}
+
 double opt_mesh_mesh_only_visible(OPT_ARGS_NUM)
 {
   if(action & GMSH_SET)
@@ -5834,6 +5862,13 @@ double opt_mesh_color_carousel(OPT_ARGS_NUM)
   return CTX::instance()->mesh.colorCarousel;
 }
 
+double opt_mesh_compact(OPT_ARGS_NUM)
+{
+  if(action & GMSH_SET)
+    CTX::instance()->mesh.compact = (int)val;
+  return CTX::instance()->mesh.compact;
+}
+
 double opt_mesh_switch_elem_tags(OPT_ARGS_NUM)
 {
   if(action & GMSH_SET)
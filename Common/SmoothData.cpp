@@ -21,6 +21,7 @@ xyzv::xyzv(const xyzv &other)
   scale_numvals = other.scale_numvals;  // Added by Trevor Strickler 07/10/2013
   nbvals = other.nbvals;
   nboccurences = other.nboccurences;
+  vals = 0;
   if(other.vals && other.nbvals) {
     vals = new double[other.nbvals];
     for(int i = 0; i < nbvals; i++)
@@ -38,6 +39,8 @@ xyzv &xyzv::operator = (const xyzv &other)
     scale_numvals = other.scale_numvals;  // Added by Trevor Strickler 07/10/2013
     nbvals = other.nbvals;
     nboccurences = other.nboccurences;
+    if(vals) delete [] vals;
+    vals = 0;
     if(other.vals && other.nbvals) {
       vals = new double[other.nbvals];
       for(int i = 0; i < nbvals; i++)
@@ -82,60 +85,85 @@ void xyzv::scale_update(double scale_inp)
 
 void smooth_data::add(double x, double y, double z, int n, double *vals)
 {
-  xyzv xyz(x, y, z);
-  std::set<xyzv, lessthanxyzv>::const_iterator it = c.find(xyz);
-  if(it == c.end()) {
-    xyz.update(n, vals);
-    c.insert(xyz);
+  int i = c.find(x, y, z);
+  if(i < 0) i = c.insert(xyzv(x, y, z));
+  c[i].update(n, vals);
+}
+
+void smooth_data::add(int numPoints, const double *xyz, int n,
+                      const double *vals)
+{
+  // match the points, and sort their indices by matched point (in the
+  // order in which they are given)
+  std::vector<int> match(numPoints);
+  for(int i = 0; i < numPoints; i++){
+    match[i] = c.find(xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2]);
+    if(match[i] < 0)
+      match[i] = c.insert(xyzv(xyz[3 * i], xyz[3 * i + 1], xyz[3 * i + 2]));
   }
-  else {
-    // we can do this because we know that it will not destroy the set
-    // ordering
-    xyzv *p = (xyzv *) & (*it);
-    p->update(n, vals);
+  int numPointsInHash = c.size();
+  std::vector<int> first(numPointsInHash + 1, 0), sorted(numPoints);
+  for(int i = 0; i < numPoints; i++) first[match[i] + 1]++;
+  for(int i = 0; i < numPointsInHash; i++) first[i + 1] += first[i];
+  std::vector<int> pos(first.begin(), first.end() - 1);
+  for(int i = 0; i < numPoints; i++) sorted[pos[match[i]]++] = i;
+
+  // average the values of each matched point with its previous average
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 1024)
+#endif
+  for(int j = 0; j < numPointsInHash; j++){
+    int num = first[j + 1] - first[j];
+    if(!num) continue;
+    xyzv &p = c[j];
+    if(!p.vals){
+      p.vals = new double[n];
+      p.nbvals = n;
+      p.nboccurences = 0;
+    }
+    else if(p.nbvals != n)
+      continue; // error
+    for(int k = 0; k < n; k++){
+      double sum = p.nboccurences ? p.vals[k] * p.nboccurences : 0.;
+      for(int i = first[j]; i < first[j + 1]; i++)
+        sum += vals[n * sorted[i] + k];
+      p.vals[k] = sum / (p.nboccurences + num);
+    }
+    p.nboccurences += num;
   }
 }
 
 //added by Trevor Strickler
 void smooth_data::add_scale(double x, double y, double z, double scale_val)
 {
-  xyzv xyz(x, y, z);
-  std::set<xyzv, lessthanxyzv>::const_iterator it = c.find(xyz);
-  if(it == c.end()){
-    xyz.scale_update(scale_val);
-    c.insert(xyz); 
-  }
-  else {
-    // we can do this because we know that it will not destroy the set
-    // ordering
-    xyzv *p = (xyzv *) & (*it);
-    p->scale_update(scale_val);
-  }
+  int i = c.find(x, y, z);
+  if(i < 0) i = c.insert(xyzv(x, y, z));
+  c[i].scale_update(scale_val);
 }
 
-bool smooth_data::get(double x, double y, double z, int n, double *vals)
+bool smooth_data::get(double x, double y, double z, int n, double *vals) const
 {
-  std::set<xyzv, lessthanxyzv>::const_iterator it = c.find(xyzv(x, y, z));
-  if(it == c.end())
+  int i = c.find(x, y, z);
+  if(i < 0)
     return false;
   for(int k = 0; k < n; k++)
-    vals[k] = it->vals[k];
+    vals[k] = c[i].vals[k];
   return true;
 }
 
 //added by Trevor Strickler
-bool smooth_data::get_scale(double x, double y, double z, double *scale_val)
+bool smooth_data::get_scale(double x, double y, double z, double *scale_val) const
 {
-  std::set<xyzv, lessthanxyzv>::const_iterator it = c.find(xyzv(x, y, z));
-  if(it == c.end())
+  int i = c.find(x, y, z);
+  if(i < 0)
     return false;
-  (*scale_val) = it->scaleValue;
+  (*scale_val) = c[i].scaleValue;
   return true;
 }
 
 void smooth_data::normalize()
 {
-  std::set<xyzv, lessthanxyzv>::iterator it = c.begin();
+  iter it = c.begin();
   while(it != c.end()){
     if(it->nbvals == 3) norme(it->vals);
     it++;
@@ -147,7 +175,7 @@ bool smooth_data::exportview(std::string filename)
   FILE *fp = Fopen(filename.c_str(), "w");
   if(!fp) return false;
   fprintf(fp, "View \"data\" {\n");
-  std::set<xyzv, lessthanxyzv>::iterator it = c.begin();
+  iter it = c.begin();
   while(it != c.end()){
     switch(it->nbvals){
     case 1:
@@ -225,33 +253,21 @@ void xyzn::update(char nx, char ny, char nz, float tol)
 void smooth_normals::add(double x, double y, double z,
                          double nx, double ny, double nz)
 {
-  xyzn xyz((float)x, (float)y, (float)z);
-  std::set<xyzn, lessthanxyzn>::const_iterator it = c.find(xyz);
-  if(it == c.end()) {
-    xyz.update(float2char((float)nx),
-               float2char((float)ny),
-               float2char((float)nz), tol);
-    c.insert(xyz);
-  }
-  else {
-    // we can do this because we know that it will not destroy the set
-    // ordering
-    xyzn *p = (xyzn *) & (*it);
-    p->update(float2char((float)nx),
+  int i = c.find((float)x, (float)y, (float)z);
+  if(i < 0) i = c.insert(xyzn((float)x, (float)y, (float)z));
+  c[i].update(float2char((float)nx),
               float2char((float)ny),
               float2char((float)nz), tol);
-  }
 }
 
 bool smooth_normals::get(double x, double y, double z,
                          double &nx, double &ny, double &nz)
 {
-  std::set<xyzn, lessthanxyzn>::const_iterator it =
-    c.find(xyzn((float)x, (float)y, (float)z));
+  int j = c.find((float)x, (float)y, (float)z);
 
-  if(it == c.end()) return false;
+  if(j < 0) return false;
 
-  xyzn *p = (xyzn *) & (*it);
+  xyzn *p = &c[j];
   for(unsigned int i = 0; i < p->n.size(); i++){
     if(fabs(p->angle(i, float2char((float)nx),
                      float2char((float)ny),
@@ -6,7 +6,9 @@
 #ifndef _SMOOTH_DATA_H_
 #define _SMOOTH_DATA_H_
 
-#include <set>
+#include <math.h>
+#include <string.h>
+#include <deque>
 #include <vector>
 #include <string>
 
@@ -31,35 +33,122 @@ struct xyzv {
 
 };
 
-struct lessthanxyzv {
-  bool operator () (const xyzv &p2, const xyzv &p1) const
+// Spatial hash of points, matching the points within a tolerance eps of each
+// other in all directions (T has coordinates x, y, z). The points are stored
+// in insertion order, and are bucketed in cubic cells of size 4 * eps: a point
+// is searched for in the cells overlapped by its tolerance box, usually a
+// single one. Lookups do not modify the hash, and can thus be done
+// concurrently.
+
+template <class T>
+class xyzHash {
+ private:
+  double _eps;
+  double _h; // size of the cells (0: exact matching)
+  std::deque<T> _points;
+  std::vector<int> _first, _next;
+  double _cell(double x) const
+  {
+    // (adding 0. turns -0. into 0.)
+    return (_h > 0. ? floor(x / _h) : x) + 0.;
+  }
+  unsigned int _bucket(double i, double j, double k) const
+  {
+    double c[3] = {i, j, k};
+    unsigned long long b[3];
+    memcpy(b, c, sizeof(c));
+    unsigned long long h = b[0] * 73856093ULL ^ b[1] * 19349663ULL ^
+      b[2] * 83492791ULL;
+    h ^= h >> 29;
+    return (unsigned int)h & (_first.size() - 1);
+  }
+  unsigned int _bucket(const T &p) const
+  {
+    return _bucket(_cell(p.x), _cell(p.y), _cell(p.z));
+  }
+  void _rehash(unsigned int numBuckets)
+  {
+    _first.assign(numBuckets, -1);
+    for(unsigned int i = 0; i < _points.size(); i++){
+      unsigned int b = _bucket(_points[i]);
+      _next[i] = _first[b];
+      _first[b] = i;
+    }
+  }
+ public:
+  typedef typename std::deque<T>::iterator iterator;
+  xyzHash(double eps) : _eps(eps), _h(4. * eps) {}
+  iterator begin(){ return _points.begin(); }
+  iterator end(){ return _points.end(); }
+  int size() const { return _points.size(); }
+  // index of the first point inserted within eps of (x, y, z), or -1
+  int find(double x, double y, double z) const
+  {
+    if(_points.empty()) return -1;
+    const double eps = _eps;
+    const double lo[3] = {_cell(x - eps), _cell(y - eps), _cell(z - eps)};
+    const int n[3] = {_cell(x + eps) > lo[0] ? 2 : 1,
+                      _cell(y + eps) > lo[1] ? 2 : 1,
+                      _cell(z + eps) > lo[2] ? 2 : 1};
+    int found = -1;
+    for(int i = 0; i < n[0]; i++){
+      for(int j = 0; j < n[1]; j++){
+        for(int k = 0; k < n[2]; k++){
+          int p = _first[_bucket(lo[0] + i, lo[1] + j, lo[2] + k)];
+          for(; p >= 0; p = _next[p]){
+            const T &q = _points[p];
+            if((found < 0 || p < found) && fabs(q.x - x) <= eps &&
+               fabs(q.y - y) <= eps && fabs(q.z - z) <= eps)
+              found = p;
+          }
+        }
+      }
+    }
+    return found;
+  }
+  // insert a point (which should not match any point already in the hash)
+  // and return its index
+  int insert(const T &p)
+  {
+    if(_points.empty()) _first.assign(1024, -1);
+    _points.push_back(p);
+    _next.push_back(-1);
+    if(_points.size() > _first.size())
+      _rehash(2 * _first.size());
+    else{
+      unsigned int b = _bucket(p);
+      _next.back() = _first[b];
+      _first[b] = _points.size() - 1;
+    }
+    return _points.size() - 1;
+  }
+  T &operator[](int i){ return _points[i]; }
+  const T &operator[](int i) const { return _points[i]; }
+  // remove all the points (the tolerance is kept)
+  void clear()
   {
-    if(p1.x - p2.x > xyzv::eps)
-      return true;
-    if(p1.x - p2.x < -xyzv::eps)
-      return false;
-    if(p1.y - p2.y > xyzv::eps)
-      return true;
-    if(p1.y - p2.y < -xyzv::eps)
-      return false;
-    if(p1.z - p2.z > xyzv::eps)
-      return true;
-    return false;
+    _points.clear();
+    _first.clear();
+    _next.clear();
   }
 };
 
 class smooth_data{
  private:
-  std::set<xyzv, lessthanxyzv> c;  
+  xyzHash<xyzv> c;
  public:
-  typedef std::set<xyzv, lessthanxyzv>::iterator iter;
+  typedef xyzHash<xyzv>::iterator iter;
   iter begin(){ return c.begin(); }
   iter end(){ return c.end(); }
-  smooth_data() {}
+  smooth_data() : c(xyzv::eps) {}
   void add(double x, double y, double z, int n, double *vals);
-  bool get(double x, double y, double z, int n, double *vals);
+  // add the n values of each of numPoints points (coordinates xyz[3 * i],
+  // xyz[3 * i + 1], xyz[3 * i + 2] and values vals[n * i]): the points are
+  // matched serially, and the values are then averaged in parallel
+  void add(int numPoints, const double *xyz, int n, const double *vals);
+  bool get(double x, double y, double z, int n, double *vals) const;
   void add_scale(double x, double y, double z, double scale_val);  // Trevor Strickler
-  bool get_scale(double x, double y, double z, double *scale_val); // Trevor Strickler
+  bool get_scale(double x, double y, double z, double *scale_val) const; // Trevor Strickler
   void normalize();
   bool exportview(std::string filename);
 };
@@ -84,30 +173,12 @@ struct xyzn
   void update(char n0, char n1, char n2, float tol);
 };
 
-struct lessthanxyzn
-{
-  bool operator () (const xyzn &p2, const xyzn &p1) const
-  {
-    if(p1.x - p2.x > xyzn::eps)
-      return true;
-    if(p1.x - p2.x < -xyzn::eps)
-      return false;
-    if(p1.y - p2.y > xyzn::eps)
-      return true;
-    if(p1.y - p2.y < -xyzn::eps)
-      return false;
-    if(p1.z - p2.z > xyzn::eps)
-      return true;
-    return false;
-  }
-};
-
 class smooth_normals{
  private:
   float tol;
-  std::set<xyzn, lessthanxyzn> c;  
+  xyzHash<xyzn> c;
  public:
-  smooth_normals(double angle) : tol((float)angle) {}
+  smooth_normals(double angle) : tol((float)angle), c(xyzn::eps) {}
   void add(double x, double y, double z, double nx, double ny, double nz);
   bool get(double x, double y, double z, double &nx, double &ny, double &nz);
 };
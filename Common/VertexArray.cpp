@@ -10,11 +10,12 @@
 #include "Context.h"
 #include "Numeric.h"
 
-template<int N> float ElementDataLessThan<N>::tolerance = 0.0F;
-float BarycenterLessThan::tolerance = 0.0F;
-
+// the barycenters of the elements are matched up to a tolerance relative to
+// the characteristic length of the scene
 VertexArray::VertexArray(int numVerticesPerElement, int numElements)
-  : _numVerticesPerElement(numVerticesPerElement)
+  : _numVerticesPerElement(numVerticesPerElement),
+    _data3Barycenters((float)(CTX::instance()->lc * 1.e-12)),
+    _barycenters((float)(CTX::instance()->lc * 1.e-12))
 {
   int nb = (numElements ? numElements : 1) * _numVerticesPerElement;
   _vertices.reserve(nb * 3);
@@ -55,6 +56,24 @@ void VertexArray::_addElement(MElement *ele)
   if(ele && CTX::instance()->pickElements) _elements.push_back(ele);
 }
 
+void VertexArray::_addBoundaryElement(const ElementData<3> &e)
+{
+  SPoint3 p = e.barycenter();
+  Barycenter pc(p.x(), p.y(), p.z());
+  int i = _data3Barycenters.find(pc.x, pc.y, pc.z);
+  if(i < 0){
+    _data3Barycenters.insert(pc);
+    _data3.push_back(e);
+    _data3Visible.push_back(true);
+  }
+  else if(_data3Visible[i])
+    _data3Visible[i] = false;
+  else{
+    _data3[i] = e;
+    _data3Visible[i] = true;
+  }
+}
+
 void VertexArray::add(double *x, double *y, double *z, SVector3 *n,
                       unsigned int *col, MElement *ele, bool unique, bool boundary)
 {
@@ -80,13 +99,7 @@ void VertexArray::add(double *x, double *y, double *z, SVector3 *n, unsigned cha
   int npe = getNumVerticesPerElement();
 
   if(boundary && npe == 3){
-    ElementData<3> e(x, y, z, n, r, g, b, a, ele);
-    ElementDataLessThan<3>::tolerance = (float)(CTX::instance()->lc * 1.e-12);
-    std::set<ElementData<3>, ElementDataLessThan<3> >::iterator it = _data3.find(e);
-    if(it == _data3.end())
-      _data3.insert(e);
-    else
-      _data3.erase(it);
+    _addBoundaryElement(ElementData<3>(x, y, z, n, r, g, b, a, ele));
     return;
   }
 
@@ -94,8 +107,7 @@ void VertexArray::add(double *x, double *y, double *z, SVector3 *n, unsigned cha
     Barycenter pc(0.0F, 0.0F, 0.0F);
     for(int i = 0; i < npe; i++)
       pc += Barycenter(x[i], y[i], z[i]);
-    BarycenterLessThan::tolerance = (float)(CTX::instance()->lc * 1.e-12);
-    if(_barycenters.find(pc) != _barycenters.end())
+    if(_barycenters.find(pc.x, pc.y, pc.z) >= 0)
       return;
     _barycenters.insert(pc);
   }
@@ -111,16 +123,19 @@ void VertexArray::add(double *x, double *y, double *z, SVector3 *n, unsigned cha
 void VertexArray::finalize()
 {
   if(_data3.size()){
-    std::set<ElementData<3>, ElementDataLessThan<3> >::iterator it = _data3.begin();
-    for(; it != _data3.end(); it++){
+    for(unsigned int j = 0; j < _data3.size(); j++){
+      if(!_data3Visible[j]) continue;
+      const ElementData<3> &e = _data3[j];
       for(int i = 0; i < 3; i++){
-        _addVertex(it->x(i), it->y(i), it->z(i));
-        _addNormal(it->nx(i), it->ny(i), it->nz(i));
-        _addColor(it->r(i), it->g(i), it->b(i), it->a(i));
-        _addElement(it->ele());
+        _addVertex(e.x(i), e.y(i), e.z(i));
+        _addNormal(e.nx(i), e.ny(i), e.nz(i));
+        _addColor(e.r(i), e.g(i), e.b(i), e.a(i));
+        _addElement(e.ele());
       }
     }
     _data3.clear();
+    _data3Visible.clear();
+    _data3Barycenters.clear();
   }
   _barycenters.clear();
 }
@@ -331,3 +346,36 @@ void VertexArray::merge(VertexArray* va)
                      va->lastElementPointer());
   }
 }
+
+void VertexArray::merge(VertexArray *va, bool unique)
+{
+  int npe = getNumVerticesPerElement();
+  int nv = va->_vertices.size() / 3;
+  bool normals = (int)va->_normals.size() == 3 * nv;
+  bool colors = (int)va->_colors.size() == 4 * nv;
+  bool elements = (int)va->_elements.size() == nv;
+  for(int i = 0; i < nv; i += npe){
+    if(unique){
+      Barycenter pc(0.0F, 0.0F, 0.0F);
+      for(int j = i; j < i + npe; j++)
+        pc += Barycenter(va->_vertices[3 * j], va->_vertices[3 * j + 1],
+                         va->_vertices[3 * j + 2]);
+      if(_barycenters.find(pc.x, pc.y, pc.z) >= 0)
+        continue;
+      _barycenters.insert(pc);
+    }
+    _vertices.insert(_vertices.end(), va->_vertices.begin() + 3 * i,
+                     va->_vertices.begin() + 3 * (i + npe));
+    if(normals)
+      _normals.insert(_normals.end(), va->_normals.begin() + 3 * i,
+                      va->_normals.begin() + 3 * (i + npe));
+    if(colors)
+      _colors.insert(_colors.end(), va->_colors.begin() + 4 * i,
+                     va->_colors.begin() + 4 * (i + npe));
+    if(elements)
+      _elements.insert(_elements.end(), va->_elements.begin() + i,
+                       va->_elements.begin() + i + npe);
+  }
+  for(unsigned int i = 0; i < va->_data3.size(); i++)
+    if(va->_data3Visible[i]) _addBoundaryElement(va->_data3[i]);
+}
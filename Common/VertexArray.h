@@ -6,10 +6,12 @@
 #ifndef _VERTEX_ARRAY_H_
 #define _VERTEX_ARRAY_H_
 
+#include <math.h>
 #include <vector>
 #include <set>
 #include "SVector3.h"
 #include "SBoundingBox3d.h"
+#include "SmoothData.h"
 
 class MElement;
 
@@ -71,69 +73,13 @@ class ElementData {
   }
 };
 
-template<int N>
-class ElementDataLessThan{
- public:
-  static float tolerance;
-  bool operator()(const ElementData<N> &e1, const ElementData<N> &e2) const
-  {
-    SPoint3 p1 = e1.barycenter();
-    SPoint3 p2 = e2.barycenter();
-    if(p1.x() - p2.x() >  tolerance) return true;
-    if(p1.x() - p2.x() < -tolerance) return false;
-    if(p1.y() - p2.y() >  tolerance) return true;
-    if(p1.y() - p2.y() < -tolerance) return false;
-    if(p1.z() - p2.z() >  tolerance) return true;
-    return false;
-  }
-};
-
-class Barycenter {
- private:
-  float _x, _y, _z;
- public:
-  Barycenter(double x, double y, double z)
-    : _x((float)x), _y((float)y), _z((float)z){}
-  inline float x() const { return _x; }
-  inline float y() const { return _y; }
-  inline float z() const { return _z; }
-  void operator+=(const Barycenter &p){ _x += p.x(); _y += p.y(); _z += p.z(); }
-};
-
-class BarycenterLessThan{
- public:
-  static float tolerance;
-  bool operator()(const Barycenter &p1, const Barycenter &p2) const
-  {
-    if(p1.x() - p2.x() >  tolerance) return true;
-    if(p1.x() - p2.x() < -tolerance) return false;
-    if(p1.y() - p2.y() >  tolerance) return true;
-    if(p1.y() - p2.y() < -tolerance) return false;
-    if(p1.z() - p2.z() >  tolerance) return true;
-    return false;
-  }
-};
-
-class BarycenterHash {
- public:
-  std::size_t operator()(const Barycenter &b) const
-  {
-    return (std::size_t)(b.x() + b.y() + b.z());
-  }
+struct Barycenter {
+  float x, y, z;
+  Barycenter(double xx, double yy, double zz)
+    : x((float)xx), y((float)yy), z((float)zz){}
+  void operator+=(const Barycenter &p){ x += p.x; y += p.y; z += p.z; }
 };
 
-class BarycenterEqual {
- public:
-  bool operator ()(const Barycenter &a, const Barycenter &b) const
-  {
-    return (fabs(a.x()-b.x()) < BarycenterLessThan::tolerance &&
-            fabs(a.y()-b.y()) < BarycenterLessThan::tolerance &&
-            fabs(a.z()-b.z()) < BarycenterLessThan::tolerance);
-  }
-};
-
-//#include <tr1/unordered_set>
-
 class VertexArray{
  private:
   int _numVerticesPerElement;
@@ -141,9 +87,13 @@ class VertexArray{
   std::vector<char> _normals;
   std::vector<unsigned char> _colors;
   std::vector<MElement*> _elements;
-  std::set<ElementData<3>, ElementDataLessThan<3> > _data3;
-  std::set<Barycenter, BarycenterLessThan> _barycenters;
-  //std::tr1::unordered_set<Barycenter, BarycenterHash, BarycenterEqual> _barycenters;
+  // boundary triangles (stored with their barycenter until the arrays are
+  // finalized, and removed if another one with the same barycenter is
+  // added)
+  std::vector<ElementData<3> > _data3;
+  std::vector<bool> _data3Visible;
+  xyzHash<Barycenter> _data3Barycenters;
+  xyzHash<Barycenter> _barycenters;
 
   // add stuff in the arrays
   void _addVertex(float x, float y, float z);
@@ -151,6 +101,7 @@ class VertexArray{
   void _addColor(unsigned char r, unsigned char g, unsigned char b,
                  unsigned char a);
   void _addElement(MElement *ele);
+  void _addBoundaryElement(const ElementData<3> &e);
  public:
   VertexArray(int numVerticesPerElement, int numElements);
   ~VertexArray(){}
@@ -208,6 +159,13 @@ class VertexArray{
                           double &xmax, double &ymax, double &zmax);
   // merge another vertex array into this one
   void merge(VertexArray *va);
+  // merge the elements of another vertex array (not finalized) into this
+  // one, as if they were added in the same order with add(): they are only
+  // merged if unique is not set or if no element with the same barycenter is
+  // present, and the boundary elements of va are merged with the boundary
+  // elements of this array (this allows to fill separate arrays from several
+  // threads)
+  void merge(VertexArray *va, bool unique);
 };
 
 #endif
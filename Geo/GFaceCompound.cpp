@@ -1518,23 +1518,27 @@ void GFaceCompound::parametrize(iterationStep step, typeOfMapping tom) const
     lsys = new linearSystemCSRTaucs<double>;
 #elif defined(HAVE_PETSC)
     lsys = new linearSystemPETSc<double>;
-#elif defined(HAVE_GMM)
+#elif defined(HAVE_GMM) && defined(HAVE_MUMPS)
     linearSystemGmm<double> *lsysb = new linearSystemGmm<double>;
     lsysb->setGmres(1);
     lsys = lsysb;
 #else
-    lsys = new linearSystemFull<double>;
+    linearSystemCSRKrylov<double> *lsysb = new linearSystemCSRKrylov<double>;
+    lsysb->setGmres(1);
+    lsys = lsysb;
 #endif
   }
   else{
 #if defined(HAVE_PETSC)
     lsys = new linearSystemPETSc<double>;
-#elif defined(HAVE_GMM)
+#elif defined(HAVE_GMM) && defined(HAVE_MUMPS)
     linearSystemGmm<double> *lsysb = new linearSystemGmm<double>;
     lsysb->setGmres(1);
     lsys = lsysb;
 #else
-    lsys = new linearSystemFull<double>;
+    linearSystemCSRKrylov<double> *lsysb = new linearSystemCSRKrylov<double>;
+    lsysb->setGmres(1);
+    lsys = lsysb;
 #endif
   }
 
@@ -1798,12 +1802,14 @@ bool GFaceCompound::parametrize_conformal(int iter, MVertex *v1, MVertex *v2) co
   lsys = new linearSystemCSRTaucs<double>;
 #elif defined(HAVE_PETSC)
   lsys = new linearSystemPETSc<double>;
-#elif defined(HAVE_GMM)
+#elif defined(HAVE_GMM) && defined(HAVE_MUMPS)
   linearSystemGmm<double> *lsysb = new linearSystemGmm<double>;
   lsysb->setGmres(1);
   lsys = lsysb;
 #else
-  lsys = new linearSystemFull<double>;
+  linearSystemCSRKrylov<double> *lsysb = new linearSystemCSRKrylov<double>;
+  lsysb->setGmres(1);
+  lsys = lsysb;
 #endif
 
   dofManager<double> myAssembler(lsys);
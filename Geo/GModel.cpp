@@ -23,6 +23,8 @@
 #include "MPyramid.h"
 #include "MElementCut.h"
 #include "MElementOctree.h"
+#include "compactMesh.h"
+#include "MEntityPool.h"
 #include "discreteRegion.h"
 #include "discreteFace.h"
 #include "discreteEdge.h"
@@ -58,15 +60,23 @@
 
 std::vector<GModel*> GModel::list;
 int GModel::_current = -1;
+int GModel::_numberingEpoch = 0;
 
 GModel::GModel(std::string name)
   : _maxVertexNum(0), _maxElementNum(0),
     _checkPointedMaxVertexNum(0), _checkPointedMaxElementNum(0),
-    _name(name), _visible(1), _octree(0), _geo_internals(0),
-    _occ_internals(0), _acis_internals(0), _fm_internals(0),
+    _name(name), _visible(1), _octree(0), _compactMesh(0), _meshPool(0),
+    _geo_internals(0), _occ_internals(0), _acis_internals(0), _fm_internals(0),
     _factory(0), _fields(0), _currentMeshEntity(0), normals(0)
 {
   partitionSize[0] = 0; partitionSize[1] = 0;
+#if defined(HAVE_MESH_POOL)
+  _meshPool = new MEntityPool();
+#endif
+#if defined(_OPENMP)
+#pragma omp atomic
+#endif
+  _numberingEpoch++;
 
   // hide all other models
   for(unsigned int i = 0; i < list.size(); i++)
@@ -114,6 +124,9 @@ GModel::~GModel()
 #endif
   if(_factory)
     delete _factory;
+#if defined(HAVE_MESH_POOL)
+  MEntityPool::destroy(_meshPool);
+#endif
 }
 
 GModel *GModel::current(int index)
@@ -171,6 +184,112 @@ GModel *GModel::findByName(const std::string &name, const std::string &fileName)
   return 0;
 }
 
+// block of consecutive vertex or element numbers reserved by a thread: the
+// numbers next, ..., end - 1 are free in the model "model", as long as its max
+// numbers were not reset since the reservation
+struct numberBlock {
+  GModel *model;
+  int epoch, next, end;
+};
+
+static numberBlock _vertexBlock = {0, -1, 0, 0};
+static numberBlock _elementBlock = {0, -1, 0, 0};
+#if defined(_OPENMP)
+#pragma omp threadprivate(_vertexBlock, _elementBlock)
+#endif
+
+// all the updates of the max numbers go through the same critical section, so
+// that a number reserved by a thread can never be handed out again by a
+// concurrent update
+static int reserveNumbers(int &maxNum, int numBlock)
+{
+  int first;
+#if defined(_OPENMP)
+#pragma omp critical(GModelNumbering)
+#endif
+  { first = maxNum; maxNum += numBlock; }
+  return first + 1;
+}
+
+static void raiseNumber(int &maxNum, int num)
+{
+#if defined(_OPENMP)
+#pragma omp critical(GModelNumbering)
+#endif
+  maxNum = std::max(maxNum, num);
+}
+
+static void resetNumber(int &maxNum, int num, int &epoch)
+{
+#if defined(_OPENMP)
+#pragma omp critical(GModelNumbering)
+#endif
+  {
+    maxNum = num;
+#if defined(_OPENMP)
+#pragma omp atomic
+#endif
+    epoch++;
+  }
+}
+
+static int newNumber(GModel *m, int &maxNum, int &epoch, numberBlock &b)
+{
+  // outside parallel regions the numbers are kept consecutive
+  if(Msg::GetNumThreads() == 1) return reserveNumbers(maxNum, 1);
+  int e;
+#if defined(_OPENMP)
+#pragma omp atomic read
+#endif
+  e = epoch;
+  if(b.model != m || b.epoch != e || b.next == b.end){
+    const int blockSize = 256;
+    b.model = m;
+    b.epoch = e;
+    b.next = reserveNumbers(maxNum, blockSize);
+    b.end = b.next + blockSize;
+  }
+  return b.next++;
+}
+
+int GModel::getNewVertexNumber()
+{
+  return newNumber(this, _maxVertexNum, _numberingEpoch, _vertexBlock);
+}
+
+int GModel::getNewElementNumber()
+{
+  return newNumber(this, _maxElementNum, _numberingEpoch, _elementBlock);
+}
+
+void GModel::updateMaxVertexNumber(int num)
+{
+  raiseNumber(_maxVertexNum, num);
+}
+
+void GModel::updateMaxElementNumber(int num)
+{
+  raiseNumber(_maxElementNum, num);
+}
+
+void GModel::setMaxVertexNumber(int num)
+{
+  resetNumber(_maxVertexNum, num, _numberingEpoch);
+}
+
+void GModel::setMaxElementNumber(int num)
+{
+  resetNumber(_maxElementNum, num, _numberingEpoch);
+}
+
+void GModel::releaseLastVertexNumber(int num)
+{
+  // inside parallel regions the numbers of the other threads are interleaved,
+  // so the number is simply left unused
+  if(Msg::GetNumThreads() != 1) return;
+  if(num == _maxVertexNum) setMaxVertexNumber(num - 1);
+}
+
 void GModel::destroy(bool keepName)
 {
   if(!keepName){
@@ -178,9 +297,12 @@ void GModel::destroy(bool keepName)
     _fileNames.clear();
   }
 
-  _maxVertexNum = _maxElementNum = 0;
+  setMaxVertexNumber(0);
+  setMaxElementNumber(0);
   _checkPointedMaxVertexNum = _checkPointedMaxElementNum = 0;
 
+  deleteCompactMesh();
+
   for(riter it = firstRegion(); it != lastRegion(); ++it)
     delete *it;
   regions.clear();
@@ -206,6 +328,11 @@ void GModel::destroy(bool keepName)
   vertices.clear();
 
   destroyMeshCaches();
+#if defined(HAVE_MESH_POOL)
+  // return the unused memory of the mesh entity pools
+  _meshPool->release();
+  MEntityPool::releaseShared();
+#endif
 
   if(normals) delete normals;
   normals = 0;
@@ -238,6 +365,40 @@ void GModel::deleteMesh()
   for(viter it = firstVertex(); it != lastVertex();++it)
     (*it)->deleteMesh();
   destroyMeshCaches();
+  deleteCompactMesh();
+#if defined(HAVE_MESH_POOL)
+  // return the unused memory of the mesh entity pools
+  _meshPool->release();
+  MEntityPool::releaseShared();
+#endif
+}
+
+bool GModel::compactifyMesh()
+{
+  if(_compactMesh) return true;
+  if(!compactMesh::canCompact(this)) return false;
+
+  Msg::StatusBar(true, "Compactifying mesh...");
+  double t1 = Cpu();
+  compactMesh *cm = new compactMesh(this);
+  deleteMesh();
+  // the periodic vertex correspondences have been copied in the compact mesh
+  std::vector<GEntity*> entities;
+  getEntities(entities);
+  for(unsigned int i = 0; i < entities.size(); i++)
+    entities[i]->correspondingVertices.clear();
+  _compactMesh = cm;
+  double t2 = Cpu();
+  Msg::StatusBar(true, "Done compactifying mesh (%g s, %d nodes, %d elements "
+                 "in %g Mb)", t2 - t1, cm->getNumNodes(), cm->getNumElements(),
+                 cm->getMemoryUsage() / 1024. / 1024.);
+  return true;
+}
+
+void GModel::deleteCompactMesh()
+{
+  delete _compactMesh;
+  _compactMesh = 0;
 }
 
 bool GModel::empty() const
@@ -532,6 +693,8 @@ SBoundingBox3d GModel::bounds(bool aroundVisible)
 int GModel::mesh(int dimension)
 {
 #if defined(HAVE_MESH)
+  // the object mesh is generated again from scratch
+  deleteCompactMesh();
   GenerateMesh(this, dimension);
   return true;
 #else
@@ -33,6 +33,8 @@ class discreteFace;
 class discreteRegion;
 class MElementOctree;
 class GModelFactory;
+class compactMesh;
+class MEntityPool;
 
 // A geometric model. The model is a "not yet" non-manifold B-Rep.
 class GModel
@@ -56,6 +58,9 @@ class GModel
 
   // the maximum vertex and element id number in the mesh
   int _maxVertexNum, _maxElementNum;
+  // incremented each time the max vertex/element numbers of a model are
+  // reset, which invalidates the blocks of numbers reserved by the threads
+  static int _numberingEpoch;
   int _checkPointedMaxVertexNum, _checkPointedMaxElementNum;
  protected:
   // the name of the model
@@ -83,6 +88,13 @@ class GModel
   // an octree for fast mesh element lookup
   MElementOctree *_octree;
 
+  // compact representation of the mesh, if the mesh has been compactified
+  compactMesh *_compactMesh;
+
+  // memory pool of the mesh vertices and elements created when meshing or
+  // reading the model (if Gmsh is compiled with HAVE_MESH_POOL)
+  MEntityPool *_meshPool;
+
   // Geo (Gmsh native) model internal data
   GEO_Internals *_geo_internals;
   void _createGEOInternals();
@@ -184,8 +196,25 @@ class GModel
   // get/set global vertex/element num
   int getMaxVertexNumber(){ return _maxVertexNum; }
   int getMaxElementNumber(){ return _maxElementNum; }
-  void setMaxVertexNumber(int num){ _maxVertexNum = num; }
-  void setMaxElementNumber(int num){ _maxElementNum = num; }
+  void setMaxVertexNumber(int num);
+  void setMaxElementNumber(int num);
+
+  // get a new (unused) vertex/element number. This is thread-safe: outside
+  // parallel regions each number is taken in a short critical section (so
+  // that the numbers stay consecutive), while inside a parallel region each
+  // thread takes its numbers without locking from a block of consecutive
+  // numbers, only entering the critical section to reserve a new block (the
+  // numbers left unused in the blocks are simply skipped)
+  int getNewVertexNumber();
+  int getNewElementNumber();
+
+  // raise the max vertex/element number to num if it is smaller
+  void updateMaxVertexNumber(int num);
+  void updateMaxElementNumber(int num);
+
+  // give back the number of the last created vertex if it is still the max
+  // vertex number (only done outside parallel regions)
+  void releaseLastVertexNumber(int num);
   void checkPointMaxNumbers()
   {
     _checkPointedMaxVertexNum = _maxVertexNum;
@@ -203,6 +232,23 @@ class GModel
   //delete the mesh stored in entities and call destroMeshCaches
   void deleteMesh();
 
+  // convert the mesh into a compact, read-only representation, and delete
+  // the mesh vertices and elements (returns false if the mesh cannot be
+  // represented in compact form). This is only done on demand (see the
+  // Mesh.Compact option), since the compact mesh can only be saved in MSH 2
+  // or VTK format: the other writers, the partitioners, the views and the
+  // graphics only see the (deleted) object mesh
+  bool compactifyMesh();
+  // get the compact representation of the mesh, if the mesh has been
+  // compactified
+  compactMesh *getCompactMesh(){ return _compactMesh; }
+  // delete the compact representation of the mesh (this is done when the mesh
+  // is deleted, generated or read again)
+  void deleteCompactMesh();
+  // get the memory pool of the mesh vertices and elements of the model (null
+  // if Gmsh is compiled without HAVE_MESH_POOL)
+  MEntityPool *getMeshPool(){ return _meshPool; }
+
   // access internal CAD representations
   GEO_Internals *getGEOInternals(){ return _geo_internals; }
   OCC_Internals *getOCCInternals(){ return _occ_internals; }
@@ -16,6 +16,11 @@
 #include "MPrism.h"
 #include "MPyramid.h"
 #include "StringUtils.h"
+#include "Context.h"
+#include "mshAsciiReader.h"
+#include "mshBinaryReader.h"
+#include "mshParallelWriter.h"
+#include "compactMesh.h"
 
 void writeMSHPeriodicNodes(FILE *fp, std::vector<GEntity*> &entities)
 {
@@ -85,6 +90,13 @@ int GModel::readMSH(const std::string &name)
     return 0;
   }
 
+  // the compact mesh (if any) would not contain the new mesh
+  deleteCompactMesh();
+#if defined(HAVE_MESH_POOL)
+  // allocate the new mesh in the pool of the model
+  MEntityPool::scope poolScope(_meshPool);
+#endif
+
   char str[256] = "";
 
   // detect prehistoric MSH files
@@ -189,35 +201,35 @@ int GModel::readMSH(const std::string &name)
       _vertexVectorCache.clear();
       int maxVertex = -1;
       minVertex = numVertices + 1;
+      double t1 = GetTimeInSeconds();
+      bool buffered = CTX::instance()->mesh.mshFileBufferedRead;
+      mshAsciiReader ascii(fp, buffered);
+      mshBinaryReader bin(fp, name, swap, binary && buffered);
       for(int i = 0; i < numVertices; i++) {
         int num, entity, dim;
         double xyz[3];
         MVertex *vertex = 0;
         if(!binary){
-          if(fscanf(fp, "%d %lf %lf %lf %d", &num, &xyz[0], &xyz[1], &xyz[2],
-                    &entity) != 5) {
+          if(!ascii.get(num) || !ascii.get(xyz, 3) || !ascii.get(entity)){
             fclose(fp);
             return 0;
           }
         }
         else{
-          if(fread(&num, sizeof(int), 1, fp) != 1){ fclose(fp); return 0; }
-          if(swap) SwapBytes((char*)&num, sizeof(int), 1);
-          if(fread(xyz, sizeof(double), 3, fp) != 3){ fclose(fp); return 0; }
-          if(swap) SwapBytes((char*)xyz, sizeof(double), 3);
-          if(fread(&entity, sizeof(int), 1, fp) != 1){ fclose(fp); return 0; }
-          if(swap) SwapBytes((char*)&entity, sizeof(int), 1);
+          if(!bin.get(&num, 1) || !bin.get(xyz, 3) || !bin.get(&entity, 1)){
+            fclose(fp);
+            return 0;
+          }
         }
         if(!entity){
           vertex = new MVertex(xyz[0], xyz[1], xyz[2], 0, num);
         }
         else{
           if(!binary){
-            if(fscanf(fp, "%d", &dim) != 1){ fclose(fp); return 0; }
+            if(!ascii.get(dim)){ fclose(fp); return 0; }
           }
           else{
-            if(fread(&dim, sizeof(int), 1, fp) != 1){ fclose(fp); return 0; }
-            if(swap) SwapBytes((char*)&dim, sizeof(int), 1);
+            if(!bin.get(&dim, 1)){ fclose(fp); return 0; }
           }
           switch(dim){
           case 0:
@@ -233,11 +245,10 @@ int GModel::readMSH(const std::string &name)
               GEdge *ge = getEdgeByTag(entity);
               double u;
               if(!binary){
-                if(fscanf(fp, "%lf", &u) != 1){ fclose(fp); return 0; }
+                if(!ascii.get(u)){ fclose(fp); return 0; }
               }
               else{
-                if(fread(&u, sizeof(double), 1, fp) != 1){ fclose(fp); return 0; }
-                if(swap) SwapBytes((char*)&u, sizeof(double), 1);
+                if(!bin.get(&u, 1)){ fclose(fp); return 0; }
               }
               vertex = new MEdgeVertex(xyz[0], xyz[1], xyz[2], ge, u, -1.0, num);
             }
@@ -247,11 +258,10 @@ int GModel::readMSH(const std::string &name)
               GFace *gf = getFaceByTag(entity);
               double uv[2];
               if(!binary){
-                if(fscanf(fp, "%lf %lf", &uv[0], &uv[1]) != 2){ fclose(fp); return 0; }
+                if(!ascii.get(uv, 2)){ fclose(fp); return 0; }
               }
               else{
-                if(fread(uv, sizeof(double), 2, fp) != 2){ fclose(fp); return 0; }
-                if(swap) SwapBytes((char*)uv, sizeof(double), 2);
+                if(!bin.get(uv, 2)){ fclose(fp); return 0; }
               }
               vertex = new MFaceVertex(xyz[0], xyz[1], xyz[2], gf, uv[0], uv[1], num);
             }
@@ -261,14 +271,10 @@ int GModel::readMSH(const std::string &name)
               GRegion *gr = getRegionByTag(entity);
               double uvw[3];
               if(!binary){
-                if(fscanf(fp, "%lf %lf %lf", &uvw[0], &uvw[1], &uvw[2]) != 2){
-                  fclose(fp);
-                  return 0;
-                }
+                if(!ascii.get(uvw, 3)){ fclose(fp); return 0; }
               }
               else{
-                if(fread(uvw, sizeof(double), 3, fp) != 3){ fclose(fp); return 0; }
-                if(swap) SwapBytes((char*)uvw, sizeof(double), 3);
+                if(!bin.get(uvw, 3)){ fclose(fp); return 0; }
               }
               vertex = new MVertex(xyz[0], xyz[1], xyz[2], gr, num);
             }
@@ -287,6 +293,8 @@ int GModel::readMSH(const std::string &name)
         if(numVertices > 100000)
           Msg::ProgressMeter(i + 1, numVertices, true, "Reading nodes");
       }
+      bin.updateFilePosition();
+      Msg::Debug("Done reading nodes (%g s)", GetTimeInSeconds() - t1);
       // if the vertex numbering is dense, transfer the map into a vector to
       // speed up element creation
       if((int)_vertexMapCache.size() == numVertices &&
@@ -312,38 +320,26 @@ int GModel::readMSH(const std::string &name)
       if(sscanf(str, "%d", &numElements) != 1){ fclose(fp); return 0; }
       Msg::Info("%d elements", numElements);
       Msg::ResetProgressMeter();
+      double t1 = GetTimeInSeconds();
+      bool buffered = CTX::instance()->mesh.mshFileBufferedRead;
+      mshAsciiReader ascii(fp, buffered);
+      mshBinaryReader bin(fp, name, swap, binary && buffered);
       for(int i = 0; i < numElements; i++) {
-        int num, type, entity, numData;
-        if(!binary){
-          if(fscanf(fp, "%d %d %d %d", &num, &type, &entity, &numData) != 4){
-            fclose(fp);
-            return 0;
-          }
-        }
-        else{
-          if(fread(&num, sizeof(int), 1, fp) != 1){ fclose(fp); return 0; }
-          if(swap) SwapBytes((char*)&num, sizeof(int), 1);
-          if(fread(&type, sizeof(int), 1, fp) != 1){ fclose(fp); return 0; }
-          if(swap) SwapBytes((char*)&type, sizeof(int), 1);
-          if(fread(&entity, sizeof(int), 1, fp) != 1){ fclose(fp); return 0; }
-          if(swap) SwapBytes((char*)&entity, sizeof(int), 1);
-          if(fread(&numData, sizeof(int), 1, fp) != 1){ fclose(fp); return 0; }
-          if(swap) SwapBytes((char*)&numData, sizeof(int), 1);
+        int header[4];
+        if((!binary && !ascii.get(header, 4)) || (binary && !bin.get(header, 4))){
+          fclose(fp);
+          return 0;
         }
+        int num = header[0], type = header[1], entity = header[2];
+        int numData = header[3];
         std::vector<int> data;
         if(numData > 0){
           data.resize(numData);
           if(!binary){
-            for(int j = 0; j < numData; j++){
-              if(fscanf(fp, "%d", &data[j]) != 1){ fclose(fp); return 0; }
-            }
+            if(!ascii.get(&data[0], numData)){ fclose(fp); return 0; }
           }
           else{
-            if((int) fread(&data[0], sizeof(int), numData, fp) != numData){
-              fclose(fp);
-              return 0;
-            }
-            if(swap) SwapBytes((char*)&data[0], sizeof(int), numData);
+            if(!bin.get(&data[0], numData)){ fclose(fp); return 0; }
           }
         }
         MElementFactory f;
@@ -364,6 +360,8 @@ int GModel::readMSH(const std::string &name)
         if(numElements > 100000)
           Msg::ProgressMeter(i + 1, numElements, true, "Reading elements");
       }
+      bin.updateFilePosition();
+      Msg::Debug("Done reading elements (%g s)", GetTimeInSeconds() - t1);
     }
 
     // Post-processing sections
@@ -449,34 +447,75 @@ static void writeElementMSH(FILE *fp, GModel *model, MElement *ele, bool binary,
     ele->writeMSH(fp, binary, elementary);
 }
 
+template<class T>
+class elementWriterMSH {
+ private:
+  GModel *_model;
+  GEntity *_ge;
+  std::vector<T*> &_ele;
+  int _saveSinglePartition;
+  bool _binary;
+ public:
+  elementWriterMSH(GModel *model, GEntity *ge, std::vector<T*> &ele,
+                   int saveSinglePartition, bool binary)
+    : _model(model), _ge(ge), _ele(ele), _saveSinglePartition(saveSinglePartition),
+      _binary(binary) {}
+  void operator()(FILE *fp, std::size_t i)
+  {
+    if(_saveSinglePartition && _ele[i]->getPartition() != _saveSinglePartition)
+      return;
+    writeElementMSH(fp, _model, _ele[i], _binary, _ge->tag());
+  }
+};
+
 template<class T>
 static void writeElementsMSH(FILE *fp, GModel *model, GEntity *ge, std::vector<T*> &ele,
                              bool saveAll, int saveSinglePartition, bool binary)
 {
   if(!saveAll && ge->physicals.empty()) return;
 
-  for(unsigned int i = 0; i < ele.size(); i++){
-    if(saveSinglePartition && ele[i]->getPartition() != saveSinglePartition)
-      continue;
-    writeElementMSH(fp, model, ele[i], binary, ge->tag());
-  }
+  elementWriterMSH<T> writer(model, ge, ele, saveSinglePartition, binary);
+  if(CTX::instance()->mesh.mshFileParallelWrite)
+    writeMSHInParallel(fp, ele.size(), writer);
+  else
+    for(unsigned int i = 0; i < ele.size(); i++) writer(fp, i);
 }
 
+class vertexWriterMSH {
+ private:
+  std::vector<MVertex*> &_v;
+  bool _binary, _saveParametric;
+  double _scalingFactor;
+ public:
+  vertexWriterMSH(std::vector<MVertex*> &v, bool binary, bool saveParametric,
+                  double scalingFactor)
+    : _v(v), _binary(binary), _saveParametric(saveParametric),
+      _scalingFactor(scalingFactor) {}
+  void operator()(FILE *fp, std::size_t i)
+  {
+    _v[i]->writeMSH(fp, _binary, _saveParametric, _scalingFactor);
+  }
+};
+
 int GModel::writeMSH(const std::string &name, double version, bool binary,
                      bool saveAll, bool saveParametric,
                      double scalingFactor, int elementStartNum,
                      int saveSinglePartition, bool multipleView)
 {
+  if(getCompactMesh()){
+    if(version < 2 || version >= 3 || saveParametric || saveSinglePartition)
+      Msg::Warning("Compact meshes are saved in MSH 2.2 format, without "
+                   "parametric coordinates or partition selection");
+    return getCompactMesh()->writeMSH(name, binary, saveAll, scalingFactor,
+                                      elementStartNum, multipleView);
+  }
+
   if(version < 3)
     return _writeMSH2(name, version, binary, saveAll, saveParametric,
                       scalingFactor, elementStartNum, saveSinglePartition,
                       multipleView);
 
-  FILE *fp;
-  if(multipleView)
-    fp = Fopen(name.c_str(), binary ? "ab" : "a");
-  else
-    fp = Fopen(name.c_str(), binary ? "wb" : "w");
+  FILE *fp = fopenMSH(name, binary, multipleView);
   if(!fp){
     Msg::Error("Unable to open file '%s'", name.c_str());
     return 0;
@@ -542,9 +581,15 @@ int GModel::writeMSH(const std::string &name, double version, bool binary,
 
   fprintf(fp, "$Nodes\n");
   fprintf(fp, "%d\n", numVertices);
-  for(unsigned int i = 0; i < entities.size(); i++)
-    for(unsigned int j = 0; j < entities[i]->mesh_vertices.size(); j++)
-      entities[i]->mesh_vertices[j]->writeMSH(fp, binary, saveParametric, scalingFactor);
+  for(unsigned int i = 0; i < entities.size(); i++){
+    vertexWriterMSH writer(entities[i]->mesh_vertices, binary, saveParametric,
+                           scalingFactor);
+    if(CTX::instance()->mesh.mshFileParallelWrite)
+      writeMSHInParallel(fp, entities[i]->mesh_vertices.size(), writer);
+    else
+      for(unsigned int j = 0; j < entities[i]->mesh_vertices.size(); j++)
+        writer(fp, j);
+  }
 
   if(binary) fprintf(fp, "\n");
   fprintf(fp, "$EndNodes\n");
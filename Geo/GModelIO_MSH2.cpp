@@ -26,12 +26,15 @@
 #include "GmshMessage.h"
 #include "Context.h"
 #include "OS.h"
+#include "mshAsciiReader.h"
+#include "mshBinaryReader.h"
+#include "mshParallelWriter.h"
 
 #define FAST_ELEMENTS 1
 
 extern void writeMSHPeriodicNodes (FILE *fp, std::vector<GEntity*> &entities);
 
-static bool getVertices(int num, int *indices, std::map<int, MVertex*> &map,
+static bool getVertices(int num, const int *indices, std::map<int, MVertex*> &map,
                         std::vector<MVertex*> &vertices)
 {
   for(int i = 0; i < num; i++){
@@ -45,7 +48,7 @@ static bool getVertices(int num, int *indices, std::map<int, MVertex*> &map,
   return true;
 }
 
-static bool getVertices(int num, int *indices, std::vector<MVertex*> &vec,
+static bool getVertices(int num, const int *indices, std::vector<MVertex*> &vec,
                         std::vector<MVertex*> &vertices, int minVertex = 0)
 {
   for(int i = 0; i < num; i++){
@@ -256,43 +259,38 @@ int GModel::_readMSH2(const std::string &name)
       vertexMap.clear();
       minVertex = numVertices + 1;
       int maxVertex = -1;
+      double t1 = GetTimeInSeconds();
+      bool buffered = CTX::instance()->mesh.mshFileBufferedRead;
+      mshAsciiReader ascii(fp, buffered);
+      mshBinaryReader bin(fp, name, swap, binary && buffered);
       for(int i = 0; i < numVertices; i++) {
         int num;
         double xyz[3], uv[2];
         MVertex *newVertex = 0;
         if (!parametric){
           if(!binary){
-            if (fscanf(fp, "%d %lf %lf %lf", &num, &xyz[0], &xyz[1], &xyz[2]) != 4){
-              fclose(fp);
-              return 0;
-            }
+            if(!ascii.get(num) || !ascii.get(xyz, 3)){ fclose(fp); return 0; }
           }
           else{
-            if(fread(&num, sizeof(int), 1, fp) != 1){ fclose(fp); return 0; }
-            if(swap) SwapBytes((char*)&num, sizeof(int), 1);
-            if(fread(xyz, sizeof(double), 3, fp) != 3){ fclose(fp); return 0; }
-            if(swap) SwapBytes((char*)xyz, sizeof(double), 3);
+            if(!bin.get(&num, 1) || !bin.get(xyz, 3)){ fclose(fp); return 0; }
           }
           newVertex = new MVertex(xyz[0], xyz[1], xyz[2], 0, num);
         }
         else{
           int iClasDim, iClasTag;
           if(!binary){
-            if (fscanf(fp, "%d %lf %lf %lf %d %d", &num, &xyz[0], &xyz[1], &xyz[2],
-                       &iClasDim, &iClasTag) != 6){
+            if(!ascii.get(num) || !ascii.get(xyz, 3) || !ascii.get(iClasDim) ||
+               !ascii.get(iClasTag)){
               fclose(fp);
               return 0;
             }
           }
           else{
-            if(fread(&num, sizeof(int), 1, fp) != 1){ fclose(fp); return 0; }
-            if(swap) SwapBytes((char*)&num, sizeof(int), 1);
-            if(fread(xyz, sizeof(double), 3, fp) != 3){ fclose(fp); return 0; }
-            if(swap) SwapBytes((char*)xyz, sizeof(double), 3);
-            if(fread(&iClasDim, sizeof(int), 1, fp) != 1){ fclose(fp); return 0; }
-            if(swap) SwapBytes((char*)&iClasDim, sizeof(int), 1);
-            if(fread(&iClasTag, sizeof(int), 1, fp) != 1){ fclose(fp); return 0; }
-            if(swap) SwapBytes((char*)&iClasTag, sizeof(int), 1);
+            if(!bin.get(&num, 1) || !bin.get(xyz, 3) || !bin.get(&iClasDim, 1) ||
+               !bin.get(&iClasTag, 1)){
+              fclose(fp);
+              return 0;
+            }
           }
           if (iClasDim == 0){
             GVertex *gv = getVertexByTag(iClasTag);
@@ -302,22 +300,20 @@ int GModel::_readMSH2(const std::string &name)
           else if (iClasDim == 1){
             GEdge *ge = getEdgeByTag(iClasTag);
             if(!binary){
-              if (fscanf(fp, "%lf", &uv[0]) != 1){ fclose(fp); return 0; }
+              if(!ascii.get(uv[0])){ fclose(fp); return 0; }
             }
             else{
-              if(fread(uv, sizeof(double), 1, fp) != 1){ fclose(fp); return 0; }
-              if(swap) SwapBytes((char*)uv, sizeof(double), 1);
+              if(!bin.get(uv, 1)){ fclose(fp); return 0; }
             }
             newVertex = new MEdgeVertex(xyz[0], xyz[1], xyz[2], ge, uv[0], -1.0, num);
           }
           else if (iClasDim == 2){
             GFace *gf = getFaceByTag(iClasTag);
             if(!binary){
-              if (fscanf(fp, "%lf %lf", &uv[0], &uv[1]) != 2){ fclose(fp); return 0; }
+              if(!ascii.get(uv, 2)){ fclose(fp); return 0; }
             }
             else{
-              if(fread(uv, sizeof(double), 2, fp) != 2){ fclose(fp); return 0; }
-              if(swap) SwapBytes((char*)uv, sizeof(double), 2);
+              if(!bin.get(uv, 2)){ fclose(fp); return 0; }
             }
             newVertex = new MFaceVertex(xyz[0], xyz[1], xyz[2], gf, uv[0], uv[1], num);
           }
@@ -334,6 +330,8 @@ int GModel::_readMSH2(const std::string &name)
         if(numVertices > 100000)
           Msg::ProgressMeter(i + 1, numVertices, true, "Reading nodes");
       }
+      bin.updateFilePosition();
+      Msg::Debug("Done reading nodes (%g s)", GetTimeInSeconds() - t1);
       // If the vertex numbering is dense, transfer the map into a
       // vector to speed up element creation
       if((int)vertexMap.size() == numVertices &&
@@ -367,14 +365,16 @@ int GModel::_readMSH2(const std::string &name)
       sscanf(str, "%d", &numElements);
       Msg::Info("%d elements", numElements);
       Msg::ResetProgressMeter();
+      double t1 = GetTimeInSeconds();
       if(!binary){
+        mshAsciiReader ascii(fp, CTX::instance()->mesh.mshFileBufferedRead);
         for(int i = 0; i < numElements; i++) {
           int num, type, physical = 0, elementary = 0, partition = 0, parent = 0;
           int dom1 = 0, dom2 = 0, numVertices;
           std::vector<short> ghosts;
           if(version <= 1.0){
-            if(fscanf(fp, "%d %d %d %d %d", &num, &type, &physical, &elementary,
-                      &numVertices) != 5){
+            if(!ascii.get(num) || !ascii.get(type) || !ascii.get(physical) ||
+               !ascii.get(elementary) || !ascii.get(numVertices)){
               fclose(fp);
               return 0;
             }
@@ -382,11 +382,14 @@ int GModel::_readMSH2(const std::string &name)
           }
           else{
             int numTags;
-            if(fscanf(fp, "%d %d %d", &num, &type, &numTags) != 3){ fclose(fp); return 0; }
+            if(!ascii.get(num) || !ascii.get(type) || !ascii.get(numTags)){
+              fclose(fp);
+              return 0;
+            }
             int numPartitions = 0;
             for(int j = 0; j < numTags; j++){
               int tag;
-              if(fscanf(fp, "%d", &tag) != 1){ fclose(fp); return 0; }
+              if(!ascii.get(tag)){ fclose(fp); return 0; }
               if(j == 0) physical = tag;
               else if(j == 1) elementary = tag;
               else if(version < 2.2 && j == 2) partition = tag;
@@ -397,7 +400,7 @@ int GModel::_readMSH2(const std::string &name)
                 parent = tag;
               else if(j == 3 + numPartitions && (numTags == 5 + numPartitions)) {
                 dom1 = tag; j++;
-                if(fscanf(fp, "%d", &dom2) != 1){ fclose(fp); return 0; }
+                if(!ascii.get(dom2)){ fclose(fp); return 0; }
               }
             }
             if(!(numVertices = MElement::getInfoMSH(type))) {
@@ -405,16 +408,14 @@ int GModel::_readMSH2(const std::string &name)
                 fclose(fp);
                 return 0;
               }
-              if(fscanf(fp, "%d", &numVertices) != 1){ fclose(fp); return 0; }
+              if(!ascii.get(numVertices)){ fclose(fp); return 0; }
             }
           }
           int *indices = new int[numVertices];
-          for(int j = 0; j < numVertices; j++){
-            if(fscanf(fp, "%d", &indices[j]) != 1){
-              delete [] indices;
-              fclose(fp);
-              return 0;
-            }
+          if(!ascii.get(indices, numVertices)){
+            delete [] indices;
+            fclose(fp);
+            return 0;
           }
           std::vector<MVertex*> vertices;
           if(vertexVector.size()){
@@ -514,24 +515,22 @@ int GModel::_readMSH2(const std::string &name)
         }
       }
       else{
+        mshBinaryReader bin(fp, name, swap, CTX::instance()->mesh.mshFileBufferedRead);
         int numElementsPartial = 0;
         while(numElementsPartial < numElements){
           int header[3];
-          if(fread(header, sizeof(int), 3, fp) != 3){ fclose(fp); return 0; }
-          if(swap) SwapBytes((char*)header, sizeof(int), 3);
+          if(!bin.get(header, 3)){ fclose(fp); return 0; }
           int type = header[0];
           int numElms = header[1];
           int numTags = header[2];
           int numVertices = MElement::getInfoMSH(type);
-          unsigned int n = 1 + numTags + numVertices;
-          int *data = new int[n];
+          std::size_t n = 1 + numTags + numVertices;
+          // the whole block of elements is accessed at once (in place if the
+          // file is mapped in memory)
+          const int *block = bin.get<int>(n * numElms);
+          if(!block){ fclose(fp); return 0; }
           for(int i = 0; i < numElms; i++) {
-            if(fread(data, sizeof(int), n, fp) != n){
-              delete [] data;
-              fclose(fp);
-              return 0;
-            }
-            if(swap) SwapBytes((char*)data, sizeof(int), n);
+            const int *data = &block[i * n];
             int num = data[0];
             int physical = (numTags > 0) ? data[1] : 0;
             int elementary = (numTags > 1) ? data[2] : 0;
@@ -542,18 +541,16 @@ int GModel::_readMSH2(const std::string &name)
               (version >= 2.2 && numPartitions && numTags > 3 + numPartitions) ||
               (version >= 2.2 && !numPartitions && numTags > 2) ?
               data[numTags] : 0;
-            int *indices = &data[numTags + 1];
+            const int *indices = &data[numTags + 1];
             std::vector<MVertex*> vertices;
             if(vertexVector.size()){
               if(!getVertices(numVertices, indices, vertexVector, vertices, minVertex)){
-                delete [] data;
                 fclose(fp);
                 return 0;
               }
             }
             else{
               if(!getVertices(numVertices, indices, vertexMap, vertices)){
-                delete [] data;
                 fclose(fp);
                 return 0;
               }
@@ -606,10 +603,11 @@ int GModel::_readMSH2(const std::string &name)
               Msg::ProgressMeter(numElementsPartial + i + 1, numElements, true,
                                  "Reading elements");
           }
-          delete [] data;
           numElementsPartial += numElms;
         }
+        bin.updateFilePosition();
       }
+      Msg::Debug("Done reading elements (%g s)", GetTimeInSeconds() - t1);
 #if (FAST_ELEMENTS==1)
       for(int i = 0; i < 10; i++)
         elements[i].clear();
@@ -694,11 +692,14 @@ int GModel::_readMSH2(const std::string &name)
   return postpro ? 2 : 1;
 }
 
+// write the records of an element, numbered from firstNum (one record if
+// saveAll, one per physical group otherwise)
 template<class T>
-static void writeElementMSH(FILE *fp, GModel *model, T *ele, bool saveAll,
-                            double version, bool binary, int &num, int elementary,
-                            std::vector<int> &physicals, int parentNum = 0,
-                            int dom1Num = 0, int dom2Num = 0)
+static void writeElementRecordsMSH(FILE *fp, GModel *model, T *ele, bool saveAll,
+                                   double version, bool binary, int firstNum,
+                                   int elementary, std::vector<int> &physicals,
+                                   int parentNum = 0, int dom1Num = 0,
+                                   int dom2Num = 0)
 {
   std::vector<short> ghosts;
   if(model->getGhostCells().size()){
@@ -711,16 +712,27 @@ static void writeElementMSH(FILE *fp, GModel *model, T *ele, bool saveAll,
   }
 
   if(saveAll)
-    ele->writeMSH2(fp, version, binary, ++num, elementary, 0,
+    ele->writeMSH2(fp, version, binary, firstNum, elementary, 0,
                    parentNum, dom1Num, dom2Num, &ghosts);
   else{
     if(parentNum) parentNum = parentNum - physicals.size() + 1;
     for(unsigned int j = 0; j < physicals.size(); j++){
-      ele->writeMSH2(fp, version, binary, ++num, elementary, physicals[j],
+      ele->writeMSH2(fp, version, binary, firstNum + j, elementary, physicals[j],
                      parentNum, dom1Num, dom2Num, &ghosts);
       if(parentNum) parentNum++;
     }
   }
+}
+
+template<class T>
+static void writeElementMSH(FILE *fp, GModel *model, T *ele, bool saveAll,
+                            double version, bool binary, int &num, int elementary,
+                            std::vector<int> &physicals, int parentNum = 0,
+                            int dom1Num = 0, int dom2Num = 0)
+{
+  writeElementRecordsMSH(fp, model, ele, saveAll, version, binary, num + 1,
+                         elementary, physicals, parentNum, dom1Num, dom2Num);
+  num += saveAll ? 1 : physicals.size();
 
   model->setMeshElementIndex(ele, num); // should really be a multimap...
 
@@ -728,6 +740,50 @@ static void writeElementMSH(FILE *fp, GModel *model, T *ele, bool saveAll,
     num += ele->getNumChildren() - 1;
 }
 
+// writes the records of a vector of elements with consecutive numbers
+// starting at startNum + 1, for use with writeMSHInParallel
+template<class T>
+class elementWriterMSH2 {
+ private:
+  GModel *_model;
+  std::vector<T*> &_ele;
+  bool _saveAll, _binary;
+  double _version;
+  int _startNum, _numRecords, _elementary;
+  std::vector<int> &_physicals;
+ public:
+  elementWriterMSH2(GModel *model, std::vector<T*> &ele, bool saveAll,
+                    double version, bool binary, int startNum, int elementary,
+                    std::vector<int> &physicals)
+    : _model(model), _ele(ele), _saveAll(saveAll), _binary(binary),
+      _version(version), _startNum(startNum),
+      _numRecords(saveAll ? 1 : physicals.size()), _elementary(elementary),
+      _physicals(physicals) {}
+  void operator()(FILE *fp, std::size_t i)
+  {
+    writeElementRecordsMSH(fp, _model, _ele[i], _saveAll, _version, _binary,
+                           _startNum + (int)i * _numRecords + 1, _elementary,
+                           _physicals);
+  }
+};
+
+// elements can be formatted in parallel if their numbers do not depend on
+// each other, i.e. if they are all saved and do not reference other elements
+template<class T>
+static bool canWriteElementsInParallel(std::vector<T*> &ele,
+                                       int saveSinglePartition)
+{
+  if(!CTX::instance()->mesh.mshFileParallelWrite || CTX::instance()->mesh.saveTri)
+    return false;
+  for(unsigned int i = 0; i < ele.size(); i++){
+    if(saveSinglePartition && ele[i]->getPartition() != saveSinglePartition)
+      return false;
+    if(ele[i]->getDomain(0) || ele[i]->getParent())
+      return false;
+  }
+  return true;
+}
+
 template<class T>
 static void writeElementsMSH(FILE *fp, GModel *model, std::vector<T*> &ele,
                              bool saveAll, int saveSinglePartition, double version,
@@ -757,6 +813,18 @@ static void writeElementsMSH(FILE *fp, GModel *model, std::vector<T*> &ele,
     return;
   }
 
+  if(canWriteElementsInParallel(ele, saveSinglePartition)){
+    elementWriterMSH2<T> writer(model, ele, saveAll, version, binary, num,
+                                elementary, physicals);
+    writeMSHInParallel(fp, ele.size(), writer);
+    int numRecords = saveAll ? 1 : physicals.size();
+    for(unsigned int i = 0; i < ele.size(); i++){
+      num += numRecords;
+      model->setMeshElementIndex(ele[i], num);
+    }
+    return;
+  }
+
   for(unsigned int i = 0; i < ele.size(); i++){
     if(saveSinglePartition && ele[i]->getPartition() != saveSinglePartition)
       continue;
@@ -771,6 +839,22 @@ static void writeElementsMSH(FILE *fp, GModel *model, std::vector<T*> &ele,
   }
 }
 
+class vertexWriterMSH2 {
+ private:
+  std::vector<MVertex*> &_v;
+  bool _binary, _saveParametric;
+  double _scalingFactor;
+ public:
+  vertexWriterMSH2(std::vector<MVertex*> &v, bool binary, bool saveParametric,
+                   double scalingFactor)
+    : _v(v), _binary(binary), _saveParametric(saveParametric),
+      _scalingFactor(scalingFactor) {}
+  void operator()(FILE *fp, std::size_t i)
+  {
+    _v[i]->writeMSH2(fp, _binary, _saveParametric, _scalingFactor);
+  }
+};
+
 static int getNumElementsMSH(GEntity *ge, bool saveAll, int saveSinglePartition)
 {
   int n = 0, p = saveAll ? 1 : ge->physicals.size();
@@ -856,11 +940,7 @@ int GModel::_writeMSH2(const std::string &name, double version, bool binary,
                        int elementStartNum, int saveSinglePartition, bool multipleView)
 {
 
-  FILE *fp;
-  if(multipleView)
-    fp = Fopen(name.c_str(), binary ? "ab" : "a");
-  else
-    fp = Fopen(name.c_str(), binary ? "wb" : "w");
+  FILE *fp = fopenMSH(name, binary, multipleView);
   if(!fp){
     Msg::Error("Unable to open file '%s'", name.c_str());
     return 0;
@@ -913,10 +993,15 @@ int GModel::_writeMSH2(const std::string &name, double version, bool binary,
 
   std::vector<GEntity*> entities;
   getEntities(entities);
-  for(unsigned int i = 0; i < entities.size(); i++)
-    for(unsigned int j = 0; j < entities[i]->mesh_vertices.size(); j++)
-      entities[i]->mesh_vertices[j]->writeMSH2(fp, binary, saveParametric,
-                                               scalingFactor);
+  for(unsigned int i = 0; i < entities.size(); i++){
+    vertexWriterMSH2 writer(entities[i]->mesh_vertices, binary, saveParametric,
+                            scalingFactor);
+    if(CTX::instance()->mesh.mshFileParallelWrite)
+      writeMSHInParallel(fp, entities[i]->mesh_vertices.size(), writer);
+    else
+      for(unsigned int j = 0; j < entities[i]->mesh_vertices.size(); j++)
+        writer(fp, j);
+  }
 
   if(binary) fprintf(fp, "\n");
 
@@ -14,10 +14,15 @@
 #include "MPrism.h"
 #include "MPyramid.h"
 #include "StringUtils.h"
+#include "compactMesh.h"
 
 int GModel::writeVTK(const std::string &name, bool binary, bool saveAll,
                      double scalingFactor, bool bigEndian)
 {
+  if(getCompactMesh())
+    return getCompactMesh()->writeVTK(name, binary, saveAll, scalingFactor,
+                                      bigEndian);
+
   FILE *fp = Fopen(name.c_str(), binary ? "wb" : "w");
   if(!fp){
     Msg::Error("Unable to open file '%s'", name.c_str());
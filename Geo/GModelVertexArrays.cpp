@@ -183,11 +183,14 @@ static void addSmoothNormals(GEntity *e, std::vector<T*> &elements)
   }
 }
 
+// add the elements [begin, end[ in the arrays lines and triangles (if not
+// null); duplicates are only removed if unique is set
 template<class T>
 static void addElementsInArrays(GEntity *e, std::vector<T*> &elements,
-                                bool edges, bool faces)
+                                int begin, int end, VertexArray *lines,
+                                VertexArray *triangles, bool unique)
 {
-  for(unsigned int i = 0; i < elements.size(); i++){
+  for(int i = begin; i < end; i++){
     MElement *ele = elements[i];
 
     if(!isElementVisible(ele) || ele->getDim() < 1) continue;
@@ -201,8 +204,8 @@ static void addElementsInArrays(GEntity *e, std::vector<T*> &elements,
     SPoint3 pc(0., 0., 0.);
     if(CTX::instance()->mesh.explode != 1.) pc = ele->barycenter();
 
-    if(edges){
-      bool unique = e->dim() > 1 && !CTX::instance()->pickElements;
+    if(lines){
+      bool uniqueLines = unique && e->dim() > 1 && !CTX::instance()->pickElements;
       for(int j = 0; j < ele->getNumEdgesRep(curved); j++){
         double x[2], y[2], z[2];
         SVector3 n[2];
@@ -217,12 +220,12 @@ static void addElementsInArrays(GEntity *e, std::vector<T*> &elements,
         if(e->dim() == 2 && CTX::instance()->mesh.smoothNormals)
           for(int k = 0; k < 2; k++)
             e->model()->normals->get(x[k], y[k], z[k], n[k][0], n[k][1], n[k][2]);
-        e->va_lines->add(x, y, z, n, col, ele, unique);
+        lines->add(x, y, z, n, col, ele, uniqueLines);
       }
     }
 
-    if(faces){
-      bool unique = e->dim() > 2 && !CTX::instance()->pickElements;
+    if(triangles){
+      bool uniqueTriangles = unique && e->dim() > 2 && !CTX::instance()->pickElements;
       bool skin = e->dim() > 2 && CTX::instance()->mesh.drawSkinOnly;
       for(int j = 0; j < ele->getNumFacesRep(curved); j++){
         double x[3], y[3], z[3];
@@ -238,12 +241,55 @@ static void addElementsInArrays(GEntity *e, std::vector<T*> &elements,
         if(e->dim() == 2 && CTX::instance()->mesh.smoothNormals)
           for(int k = 0; k < 3; k++)
             e->model()->normals->get(x[k], y[k], z[k], n[k][0], n[k][1], n[k][2]);
-        e->va_triangles->add(x, y, z, n, col, ele, unique, skin);
+        triangles->add(x, y, z, n, col, ele, uniqueTriangles, skin);
       }
     }
   }
 }
 
+template<class T>
+static void addElementsInArrays(GEntity *e, std::vector<T*> &elements,
+                                bool edges, bool faces)
+{
+  VertexArray *lines = edges ? e->va_lines : 0;
+  VertexArray *triangles = faces ? e->va_triangles : 0;
+  int numElements = elements.size();
+  int numThreads = Msg::GetMaxThreads();
+  if(numThreads < 2 || numElements < 10000){
+    addElementsInArrays(e, elements, 0, numElements, lines, triangles, true);
+    return;
+  }
+
+  // fill one pair of arrays per thread, with a contiguous range of elements,
+  // and merge them in order (the duplicates are removed when merging)
+  std::vector<VertexArray*> threadLines(numThreads, (VertexArray*)0);
+  std::vector<VertexArray*> threadTriangles(numThreads, (VertexArray*)0);
+#if defined(_OPENMP)
+#pragma omp parallel
+#endif
+  {
+    const int thread = Msg::GetThreadNum();
+    const int nt = Msg::GetNumThreads();
+    const int begin = (long)numElements * thread / nt;
+    const int end = (long)numElements * (thread + 1) / nt;
+    if(lines) threadLines[thread] = new VertexArray(2, end - begin);
+    if(triangles) threadTriangles[thread] = new VertexArray(3, end - begin);
+    addElementsInArrays(e, elements, begin, end, threadLines[thread],
+                        threadTriangles[thread], false);
+  }
+  for(int i = 0; i < numThreads; i++){
+    if(lines && threadLines[i]){
+      lines->merge(threadLines[i], e->dim() > 1 && !CTX::instance()->pickElements);
+      delete threadLines[i];
+    }
+    if(triangles && threadTriangles[i]){
+      triangles->merge(threadTriangles[i],
+                       e->dim() > 2 && !CTX::instance()->pickElements);
+      delete threadTriangles[i];
+    }
+  }
+}
+
 class initMeshGEdge {
  private:
   int _estimateNumLines(GEdge *e)
@@ -410,6 +456,11 @@ void GModel::fillVertexArrays()
 {
   if(!getVisibility() || !CTX::instance()->mesh.changed) return;
 
+  if(getCompactMesh()){
+    Msg::Error("Compact meshes cannot be displayed");
+    return;
+  }
+
   Msg::Debug("Mesh has changed: reinitializing vertex arrays");
 
   int status = getMeshStatus();
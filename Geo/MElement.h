@@ -44,6 +44,10 @@ class MElement
  public :
   MElement(int num=0, int part=0);
   virtual ~MElement(){}
+#if defined(HAVE_MESH_POOL)
+  void *operator new(size_t size){ return MEntityPool::allocate(size); }
+  void operator delete(void *p, size_t size){ MEntityPool::deallocate(p, size); }
+#endif
 
   // set/get the tolerance for isInside() test
   static void setTolerance(const double tol){ _isInsideTolerance = tol; }
@@ -52,6 +56,9 @@ class MElement
   // return the tag of the element
   virtual int getNum() const { return _num; }
 
+  // force the immutable number (this should normally never be used)
+  void forceNum(int num);
+
   // return the geometrical dimension of the element
   virtual int getDim() const = 0;
 
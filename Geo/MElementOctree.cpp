@@ -3,10 +3,12 @@
 // See the LICENSE.txt file for license information. Please report all
 // bugs and problems to the public mailing list <gmsh@geuz.org>.
 
+#include <algorithm>
+#include <set>
 #include "GModel.h"
 #include "MElement.h"
 #include "MElementOctree.h"
-#include "Octree.h"
+#include "BasisFactory.h"
 #include "Context.h"
 
 void MElementBB(void *a, double *min, double *max)
@@ -31,22 +33,6 @@ void MElementBB(void *a, double *min, double *max)
   }
 }
 
-static void MElementCentroid(void *a, double *x)
-{
-  MElement *e = (MElement*)a;
-  MVertex *v = e->getVertex(0);
-  int n = e->getNumVertices();
-  x[0] = v->x(); x[1] = v->y(); x[2] = v->z();
-  for(int i = 1; i < n; i++) {
-    v = e->getVertex(i);
-    x[0] += v->x(); x[1] += v->y(); x[2] += v->z();
-  }
-  double oc = 1. / (double)n;
-  x[0] *= oc;
-  x[1] *= oc;
-  x[2] *= oc;
-}
-
 int MElementInEle(void *a, double *x)
 {
   MElement *e = (MElement*)a;
@@ -57,71 +43,164 @@ int MElementInEle(void *a, double *x)
 
 MElementOctree::MElementOctree(GModel *m) : _gm(m)
 {
-  SBoundingBox3d bb = m->bounds();
-  // make bounding box larger up to (absolute) geometrical tolerance
-  double eps = CTX::instance()->geom.tolerance;
-  SPoint3 bbmin = bb.min(), bbmax = bb.max(), bbeps(eps, eps, eps);
-  bbmin -= bbeps;
-  bbmax += bbeps;
-  double min[3] = {bbmin.x(), bbmin.y(), bbmin.z()};
-  double size[3] = {bbmax.x() - bbmin.x(),
-                    bbmax.y() - bbmin.y(),
-                    bbmax.z() - bbmin.z()};
-  const int maxElePerBucket = 100; // memory vs. speed trade-off
-  _octree = Octree_Create(maxElePerBucket, min, size,
-                          MElementBB, MElementCentroid, MElementInEle);
+  std::vector<MElement*> elements;
   std::vector<GEntity*> entities;
   m->getEntities(entities);
   // do not add Gvertex non-associated to any GEdge
   for(unsigned int i = 0; i < entities.size(); i++){
-      for(unsigned int j = 0; j < entities[i]->getNumMeshElements(); j++){
-	if (entities[i]->dim() == 0){
-	  GVertex *gv = dynamic_cast<GVertex*>(entities[i]);
-	  if (gv && gv->edges().size() > 0){
-	    Octree_Insert(entities[i]->getMeshElement(j), _octree);
-	  }
-	}
-	else
-	  Octree_Insert(entities[i]->getMeshElement(j), _octree);
+    if(entities[i]->dim() == 0){
+      GVertex *gv = dynamic_cast<GVertex*>(entities[i]);
+      if(!gv || gv->edges().empty()) continue;
     }
+    for(unsigned int j = 0; j < entities[i]->getNumMeshElements(); j++)
+      elements.push_back(entities[i]->getMeshElement(j));
   }
-  //exit(1);
-  Octree_Arrange(_octree);
+  _build(elements);
 }
 
 MElementOctree::MElementOctree(std::vector<MElement*> &v) : _gm(0), _elems(v)
 {
-  SBoundingBox3d bb;
-  for (unsigned int i = 0; i < v.size(); i++){
-    for(int j = 0; j < v[i]->getNumVertices(); j++){
-      //if (!_gm) _gm = v[i]->getVertex(j)->onWhat()->model();
-      bb += SPoint3(v[i]->getVertex(j)->x(),
-                    v[i]->getVertex(j)->y(),
-                    v[i]->getVertex(j)->z());
+  _build(v);
+}
+
+MElementOctree::~MElementOctree()
+{
+}
+
+class centroidLessThan {
+ private:
+  const std::vector<double> &_centroid;
+  int _axis;
+ public:
+  centroidLessThan(const std::vector<double> &centroid, int axis)
+    : _centroid(centroid), _axis(axis) {}
+  bool operator()(int a, int b) const
+  {
+    return _centroid[3 * a + _axis] < _centroid[3 * b + _axis];
+  }
+};
+
+void MElementOctree::_build(std::vector<MElement*> &elements)
+{
+  const int n = elements.size();
+  std::vector<double> bbox(6 * n), centroid(3 * n);
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+  for(int i = 0; i < n; i++){
+    double *b = &bbox[6 * i];
+    MElementBB(elements[i], b, b + 3);
+    for(int j = 0; j < 3; j++) centroid[3 * i + j] = 0.5 * (b[j] + b[3 + j]);
+  }
+
+  std::vector<int> index(n);
+  for(int i = 0; i < n; i++) index[i] = i;
+  _nodes.clear();
+  if(n) _nodes.reserve(2 * n);
+  if(n) _buildNode(index, bbox, centroid, 0, n);
+
+  // store the elements and their bounding boxes in the order of the leaves
+  _leafElements.resize(n);
+  _leafBoxes.resize(6 * n);
+  for(int i = 0; i < n; i++){
+    _leafElements[i] = elements[index[i]];
+    std::copy(&bbox[6 * index[i]], &bbox[6 * index[i]] + 6, &_leafBoxes[6 * i]);
+  }
+
+#if defined(_OPENMP)
+  // make sure the function spaces used to locate points in the elements are
+  // created before any concurrent query
+  std::set<int> types;
+  for(int i = 0; i < n; i++)
+    if(types.insert(_leafElements[i]->getTypeForMSH()).second)
+      BasisFactory::preload(_leafElements[i]->getTypeForMSH());
+#endif
+}
+
+int MElementOctree::_buildNode(std::vector<int> &index,
+                               const std::vector<double> &bbox,
+                               const std::vector<double> &centroid,
+                               int begin, int end)
+{
+  const int maxElePerLeaf = 4; // memory vs. speed trade-off
+  node nd;
+  double cmin[3], cmax[3];
+  for(int j = 0; j < 3; j++){
+    nd.min[j] = bbox[6 * index[begin] + j];
+    nd.max[j] = bbox[6 * index[begin] + 3 + j];
+    cmin[j] = cmax[j] = centroid[3 * index[begin] + j];
+  }
+  for(int i = begin + 1; i < end; i++){
+    const double *b = &bbox[6 * index[i]], *c = &centroid[3 * index[i]];
+    for(int j = 0; j < 3; j++){
+      nd.min[j] = std::min(nd.min[j], b[j]);
+      nd.max[j] = std::max(nd.max[j], b[3 + j]);
+      cmin[j] = std::min(cmin[j], c[j]);
+      cmax[j] = std::max(cmax[j], c[j]);
     }
   }
-  // make bounding box larger up to (absolute) geometrical tolerance
-  double eps = CTX::instance()->geom.tolerance;
-  SPoint3 bbmin = bb.min(), bbmax = bb.max(), bbeps(eps, eps, eps);
-  bbmin -= bbeps;
-  bbmax += bbeps;
-  double min[3] = {bbmin.x(), bbmin.y(), bbmin.z()};
-  double size[3] = {bbmax.x() - bbmin.x(),
-                    bbmax.y() - bbmin.y(),
-                    bbmax.z() - bbmin.z()};
-  const int maxElePerBucket = 100; // memory vs. speed trade-off
-  _octree = Octree_Create(maxElePerBucket, min, size,
-                          MElementBB, MElementCentroid, MElementInEle);
-  for (unsigned int i = 0; i < v.size(); i++)
-    Octree_Insert(v[i], _octree);
-  Octree_Arrange(_octree);
+  int axis = 0;
+  for(int j = 1; j < 3; j++)
+    if(cmax[j] - cmin[j] > cmax[axis] - cmin[axis]) axis = j;
+
+  const int current = _nodes.size();
+  if(end - begin <= maxElePerLeaf || cmax[axis] == cmin[axis]){
+    nd.first = begin;
+    nd.count = end - begin;
+    _nodes.push_back(nd);
+    return current;
+  }
+  nd.first = -1;
+  nd.count = 0;
+  _nodes.push_back(nd);
+  // median split along the largest extent of the centroids
+  const int middle = (begin + end) / 2;
+  std::nth_element(index.begin() + begin, index.begin() + middle,
+                   index.begin() + end, centroidLessThan(centroid, axis));
+  _buildNode(index, bbox, centroid, begin, middle);
+  _nodes[current].first = _buildNode(index, bbox, centroid, middle, end);
+  return current;
 }
 
-MElementOctree::~MElementOctree()
+static inline bool pointInBox(const double *P, const double *min,
+                              const double *max)
 {
-  Octree_Delete(_octree);
+  return (P[0] >= min[0] && P[0] <= max[0] &&
+          P[1] >= min[1] && P[1] <= max[1] &&
+          P[2] >= min[2] && P[2] <= max[2]);
 }
 
+MElement *MElementOctree::_search(double *P, int dim,
+                                  std::vector<MElement*> *all) const
+{
+  if(_nodes.empty()) return 0;
+  // the tree is balanced, so its depth is bounded by log2 of the number of
+  // elements
+  int stack[128], top = 0;
+  stack[top++] = 0;
+  while(top){
+    const int i = stack[--top];
+    const node &nd = _nodes[i];
+    if(!pointInBox(P, nd.min, nd.max)) continue;
+    if(nd.count){
+      for(int k = nd.first; k < nd.first + nd.count; k++){
+        const double *b = &_leafBoxes[6 * k];
+        if(!pointInBox(P, b, b + 3)) continue;
+        MElement *e = _leafElements[k];
+        if(dim != -1 && e->getDim() != dim) continue;
+        if(MElementInEle(e, P)){
+          if(!all) return e;
+          all->push_back(e);
+        }
+      }
+    }
+    else{
+      stack[top++] = nd.first;
+      stack[top++] = i + 1;
+    }
+  }
+  return 0;
+}
 
 std::vector<MElement *> MElementOctree::findAll(double x, double y, double z,
                                                 int dim, bool strict)
@@ -130,13 +209,8 @@ std::vector<MElement *> MElementOctree::findAll(double x, double y, double z,
   double tolIncr = 10.;
 
   double P[3] = {x, y, z};
-  std::vector<void*> v;
   std::vector<MElement*> e;
-  Octree_SearchAll(P, _octree,&v);
-  for (std::vector<void*>::iterator it = v.begin(); it != v.end(); ++it) {
-    MElement *el = (MElement*) *it;
-    if (dim == -1 || el->getDim() == dim)e.push_back(el);
-  }
+  _search(P, dim, &e);
   if (e.empty() && !strict && _gm) {
     double initialTol = MElement::getTolerance();
     double tol = initialTol;
@@ -187,23 +261,10 @@ std::vector<MElement *> MElementOctree::findAll(double x, double y, double z,
   return e;
 }
 
-MElement *MElementOctree::find(double x, double y, double z, int dim, bool strict) const
+MElement *MElementOctree::_searchAgain(double *P, int dim) const
 {
-  double P[3] = {x, y, z};
-  MElement *e = (MElement*)Octree_Search(P, _octree);
-  if (e && (dim == -1 || e->getDim() == dim))
-    return e;
-  std::vector<void*> l;
-  if (e && e->getDim() != dim) {
-    Octree_SearchAll(P, _octree, &l);
-    for (std::vector<void*>::iterator it = l.begin(); it != l.end(); it++) {
-      MElement *el = (MElement*) *it;
-      if (el->getDim() == dim) {
-        return el;
-      }
-    }
-  }
-  if (!strict && _gm) {
+  MElement *e;
+  if (_gm) {
     double initialTol = MElement::getTolerance();
     double tol = initialTol;
     while (tol < 1.){
@@ -226,7 +287,7 @@ MElement *MElementOctree::find(double x, double y, double z, int dim, bool stric
     MElement::setTolerance(initialTol);
     //Msg::Warning("Point %g %g %g not found",x,y,z);
   }
-  else if (!strict && !_gm){
+  else {
     double initialTol = MElement::getTolerance();
     double tol = initialTol;
     while (tol < 0.1){
@@ -247,3 +308,34 @@ MElement *MElementOctree::find(double x, double y, double z, int dim, bool stric
   }
   return NULL;
 }
+
+MElement *MElementOctree::find(double x, double y, double z, int dim, bool strict) const
+{
+  double P[3] = {x, y, z};
+  MElement *e = _search(P, dim, 0);
+  if (e || strict) return e;
+  return _searchAgain(P, dim);
+}
+
+void MElementOctree::find(const std::vector<SPoint3> &points,
+                          std::vector<MElement*> &elements,
+                          int dim, bool strict) const
+{
+  const int n = points.size();
+  elements.resize(n);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 256)
+#endif
+  for(int i = 0; i < n; i++){
+    double P[3] = {points[i].x(), points[i].y(), points[i].z()};
+    elements[i] = _search(P, dim, 0);
+  }
+  if(strict) return;
+  // the search with increased tolerances modifies the global element
+  // tolerance, and is thus performed sequentially
+  for(int i = 0; i < n; i++){
+    if(elements[i]) continue;
+    double P[3] = {points[i].x(), points[i].y(), points[i].z()};
+    elements[i] = _searchAgain(P, dim);
+  }
+}
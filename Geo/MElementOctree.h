@@ -7,23 +7,47 @@
 #define _MELEMENT_OCTREE_
 
 #include <vector>
+#include "SPoint3.h"
 
-class Octree;
 class GModel;
 class MElement;
 
+// Element locator based on a bounding volume hierarchy, built in bulk from the
+// (tolerance-enlarged) bounding boxes of the elements. Strict queries do not
+// modify the locator nor any global state and can thus be performed
+// concurrently. Non-strict queries that fail are retried with increasing
+// values of the global MElement tolerance, and must not be performed
+// concurrently with any other query (the batch find does these retries
+// sequentially).
 class MElementOctree{
  private:
-  Octree *_octree;
+  // node of the hierarchy: leaves store "count" elements starting at "first"
+  // in _leafElements; internal nodes (count == 0) have their first child stored
+  // right after them and their second child at index "first"
+  struct node {
+    double min[3], max[3];
+    int first, count;
+  };
+  std::vector<node> _nodes;
+  std::vector<MElement*> _leafElements;
+  std::vector<double> _leafBoxes;
   GModel *_gm;
   std::vector<MElement*> _elems;
+  void _build(std::vector<MElement*> &elements);
+  int _buildNode(std::vector<int> &index, const std::vector<double> &bbox,
+                 const std::vector<double> &centroid, int begin, int end);
+  MElement *_search(double *P, int dim, std::vector<MElement*> *all) const;
+  MElement *_searchAgain(double *P, int dim) const;
  public:
   MElementOctree(GModel *);
   MElementOctree(std::vector<MElement*> &);
   ~MElementOctree();
   MElement *find(double x, double y, double z, int dim = -1, bool strict = false) const;
-  Octree *getInternalOctree(){ return _octree; }
   std::vector<MElement *> findAll(double x, double y, double z, int dim, bool strict = false);
+  // locates a batch of points (in parallel if OpenMP is available); elements
+  // are set to 0 for points that could not be located
+  void find(const std::vector<SPoint3> &points, std::vector<MElement*> &elements,
+            int dim = -1, bool strict = false) const;
 };
 
 #endif
@@ -0,0 +1,335 @@
+// Gmsh - Copyright (C) 1997-2014 C. Geuzaine, J.-F. Remacle
+//
+// See the LICENSE.txt file for license information. Please report all
+// bugs and problems to the public mailing list <gmsh@geuz.org>.
+
+#include <stdlib.h>
+#include <new>
+#include <vector>
+#include <algorithm>
+#if defined(WIN32) && !defined(__CYGWIN__)
+#include <malloc.h>
+#endif
+#include "GmshConfig.h"
+#include "MEntityPool.h"
+
+// objects are allocated by size classes of 16, 32, ..., 512 bytes; larger
+// objects are allocated with the global operator new
+static const size_t granularity = 16;
+static const size_t numClasses = 32;
+// the chunks are aligned on their size, so that the chunk of an object is
+// found by masking its address: each chunk starts with a header (padded to
+// the granularity) giving the pool the chunk belongs to
+static const size_t chunkSize = 1 << 18;
+
+struct chunkHeader{
+  MEntityPool *pool;
+};
+
+static char *allocateChunk()
+{
+#if defined(WIN32) && !defined(__CYGWIN__)
+  return (char*)_aligned_malloc(chunkSize, chunkSize);
+#else
+  void *chunk = 0;
+  if(posix_memalign(&chunk, chunkSize, chunkSize)) return 0;
+  return (char*)chunk;
+#endif
+}
+
+static void freeChunk(char *chunk)
+{
+#if defined(WIN32) && !defined(__CYGWIN__)
+  _aligned_free(chunk);
+#else
+  free(chunk);
+#endif
+}
+
+static char *getChunk(void *o)
+{
+  return (char*)((size_t)o & ~(chunkSize - 1));
+}
+
+// end of the space of a chunk that can hold objects of size s
+static char *getChunkEnd(char *chunk, size_t s)
+{
+  return chunk + granularity + ((chunkSize - granularity) / s) * s;
+}
+
+struct pooledObject{
+  pooledObject *next;
+};
+
+struct threadPool{
+  // freed objects, and free space in the last chunk, for each size class
+  pooledObject *freeList[numClasses];
+  char *current[numClasses], *end[numClasses];
+  // the chunks, and the size class of each chunk
+  std::vector<char*> chunks;
+  std::vector<size_t> chunkClasses;
+  // number of objects allocated minus number of objects freed by the thread
+  // (objects can be freed by another thread than the one that allocated them)
+  long numObjects;
+  threadPool(){ reset(); }
+  ~threadPool(){ reset(); }
+  void reset()
+  {
+    for(size_t i = 0; i < numClasses; i++){
+      freeList[i] = 0;
+      current[i] = end[i] = 0;
+    }
+    for(unsigned int i = 0; i < chunks.size(); i++) freeChunk(chunks[i]);
+    chunks.clear();
+    chunkClasses.clear();
+    numObjects = 0;
+  }
+};
+
+// the parts of the pools used by the thread, identified by the ids of the
+// pools (the ids are never reused, so that the entries of deleted pools are
+// never matched); the last used pool comes first
+typedef std::vector<std::pair<unsigned long, threadPool*> > threadCache;
+static threadCache *_cache = 0;
+#if defined(_OPENMP)
+#pragma omp threadprivate(_cache)
+#endif
+
+static unsigned long _numPools = 0;
+static MEntityPool *_currentPool = 0, *_defaultPool = 0;
+static std::vector<MEntityPool*> _orphanPools;
+
+MEntityPool::MEntityPool()
+{
+#if defined(_OPENMP)
+#pragma omp critical(MEntityPoolList)
+#endif
+  _id = ++_numPools;
+}
+
+MEntityPool::~MEntityPool()
+{
+  for(unsigned int i = 0; i < _threads.size(); i++) delete _threads[i];
+}
+
+threadPool *MEntityPool::_getThreadPool()
+{
+  if(!_cache) _cache = new threadCache();
+  threadCache &c = *_cache;
+  for(unsigned int i = 0; i < c.size(); i++){
+    if(c[i].first == _id){
+      if(i) std::swap(c[i], c[0]);
+      return c[0].second;
+    }
+  }
+  threadPool *p = new threadPool();
+#if defined(_OPENMP)
+#pragma omp critical(MEntityPoolList)
+#endif
+  _threads.push_back(p);
+  c.push_back(std::make_pair(_id, p));
+  std::swap(c.back(), c[0]);
+  return p;
+}
+
+static MEntityPool *getCurrentPool()
+{
+  if(_currentPool) return _currentPool;
+  if(!_defaultPool){
+#if defined(_OPENMP)
+#pragma omp critical(MEntityPoolDefault)
+#endif
+    if(!_defaultPool) _defaultPool = new MEntityPool();
+  }
+  return _defaultPool;
+}
+
+void *MEntityPool::allocate(size_t size)
+{
+  size_t c = (size + granularity - 1) / granularity;
+  if(!c || c > numClasses) return ::operator new(size);
+  c--;
+  MEntityPool *pool = getCurrentPool();
+  threadPool *p = pool->_getThreadPool();
+  p->numObjects++;
+  if(p->freeList[c]){
+    pooledObject *o = p->freeList[c];
+    p->freeList[c] = o->next;
+    return o;
+  }
+  size_t s = (c + 1) * granularity;
+  if(p->current[c] == p->end[c]){
+    char *chunk = allocateChunk();
+    if(!chunk){
+      p->numObjects--;
+      throw std::bad_alloc();
+    }
+    ((chunkHeader*)chunk)->pool = pool;
+    p->chunks.push_back(chunk);
+    p->chunkClasses.push_back(c);
+    p->current[c] = chunk + granularity;
+    p->end[c] = getChunkEnd(chunk, s);
+  }
+  void *o = p->current[c];
+  p->current[c] += s;
+  return o;
+}
+
+void MEntityPool::deallocate(void *o, size_t size)
+{
+  if(!o) return;
+  size_t c = (size + granularity - 1) / granularity;
+  if(!c || c > numClasses){
+    ::operator delete(o);
+    return;
+  }
+  c--;
+  // the object goes back to the pool it was allocated in, whichever the
+  // current pool
+  threadPool *p = ((chunkHeader*)getChunk(o))->pool->_getThreadPool();
+  p->numObjects--;
+  pooledObject *f = (pooledObject*)o;
+  f->next = p->freeList[c];
+  p->freeList[c] = f;
+}
+
+// a chunk of the pool, with the part of it that was already carved
+struct chunkRef{
+  char *chunk, *begin, *end;
+  size_t size;
+  long numFree;
+  bool operator<(const chunkRef &other) const { return chunk < other.chunk; }
+};
+
+static int findChunk(const std::vector<chunkRef> &chunks, void *o)
+{
+  chunkRef r;
+  r.chunk = getChunk(o);
+  std::vector<chunkRef>::const_iterator it =
+    std::lower_bound(chunks.begin(), chunks.end(), r);
+  if(it == chunks.end() || it->chunk != r.chunk) return -1;
+  return it - chunks.begin();
+}
+
+bool MEntityPool::release()
+{
+  // the objects of a chunk can be recycled in the free lists of any thread of
+  // the pool (an object freed by another thread goes to the free list of that
+  // thread), so the free objects of all the threads are counted per chunk:
+  // the chunks whose carved objects are all free are returned to the system,
+  // the others are kept
+  std::vector<chunkRef> chunks;
+  for(unsigned int i = 0; i < _threads.size(); i++){
+    threadPool *p = _threads[i];
+    for(unsigned int j = 0; j < p->chunks.size(); j++){
+      size_t c = p->chunkClasses[j], s = (c + 1) * granularity;
+      chunkRef r;
+      r.chunk = p->chunks[j];
+      r.begin = r.chunk + granularity;
+      r.end = getChunkEnd(r.chunk, s);
+      if(p->current[c] >= r.begin && p->current[c] <= r.end)
+        r.end = p->current[c];
+      r.size = s;
+      r.numFree = 0;
+      chunks.push_back(r);
+    }
+  }
+  std::sort(chunks.begin(), chunks.end());
+
+  for(unsigned int i = 0; i < _threads.size(); i++)
+    for(size_t c = 0; c < numClasses; c++)
+      for(pooledObject *o = _threads[i]->freeList[c]; o; o = o->next){
+        int k = findChunk(chunks, o);
+        if(k >= 0) chunks[k].numFree++;
+      }
+
+  std::vector<char> unused(chunks.size(), 0);
+  bool all = true;
+  for(unsigned int k = 0; k < chunks.size(); k++){
+    unused[k] = (chunks[k].numFree * (long)chunks[k].size ==
+                 chunks[k].end - chunks[k].begin);
+    if(!unused[k]) all = false;
+  }
+
+  // remove the objects of the unused chunks from the free lists of all the
+  // threads, before any chunk is freed
+  for(unsigned int i = 0; i < _threads.size(); i++){
+    threadPool *p = _threads[i];
+    for(size_t c = 0; c < numClasses; c++){
+      pooledObject **prev = &p->freeList[c];
+      while(*prev){
+        int k = findChunk(chunks, *prev);
+        if(k >= 0 && unused[k])
+          *prev = (*prev)->next;
+        else
+          prev = &(*prev)->next;
+      }
+    }
+  }
+
+  // free the unused chunks
+  for(unsigned int i = 0; i < _threads.size(); i++){
+    threadPool *p = _threads[i];
+    unsigned int n = 0;
+    for(unsigned int j = 0; j < p->chunks.size(); j++){
+      int k = findChunk(chunks, p->chunks[j]);
+      size_t c = p->chunkClasses[j], s = (c + 1) * granularity;
+      if(k >= 0 && !unused[k]){
+        p->chunks[n] = p->chunks[j];
+        p->chunkClasses[n] = c;
+        n++;
+        continue;
+      }
+      if(p->current[c] >= p->chunks[j] + granularity &&
+         p->current[c] <= getChunkEnd(p->chunks[j], s))
+        p->current[c] = p->end[c] = 0;
+      freeChunk(p->chunks[j]);
+    }
+    p->chunks.resize(n);
+    p->chunkClasses.resize(n);
+  }
+  return all;
+}
+
+void MEntityPool::getStatistics(long &numObjects, size_t &memory) const
+{
+  numObjects = 0;
+  memory = 0;
+  for(unsigned int i = 0; i < _threads.size(); i++){
+    numObjects += _threads[i]->numObjects;
+    memory += _threads[i]->chunks.size() * chunkSize;
+  }
+}
+
+void MEntityPool::destroy(MEntityPool *pool)
+{
+  if(!pool) return;
+  if(pool == _currentPool) _currentPool = 0;
+  if(pool->release())
+    delete pool;
+  else
+    _orphanPools.push_back(pool);
+}
+
+void MEntityPool::releaseShared()
+{
+  if(_defaultPool) _defaultPool->release();
+  unsigned int n = 0;
+  for(unsigned int i = 0; i < _orphanPools.size(); i++){
+    if(_orphanPools[i]->release())
+      delete _orphanPools[i];
+    else
+      _orphanPools[n++] = _orphanPools[i];
+  }
+  _orphanPools.resize(n);
+}
+
+MEntityPool::scope::scope(MEntityPool *pool) : _previous(_currentPool)
+{
+  if(pool) _currentPool = pool;
+}
+
+MEntityPool::scope::~scope()
+{
+  _currentPool = _previous;
+}
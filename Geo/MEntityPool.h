@@ -0,0 +1,58 @@
+// Gmsh - Copyright (C) 1997-2014 C. Geuzaine, J.-F. Remacle
+//
+// See the LICENSE.txt file for license information. Please report all
+// bugs and problems to the public mailing list <gmsh@geuz.org>.
+
+#ifndef _MENTITY_POOL_H_
+#define _MENTITY_POOL_H_
+
+#include <stddef.h>
+#include <vector>
+
+struct threadPool;
+
+// Memory pool for mesh vertices and elements (used by MVertex::operator new
+// and MElement::operator new if Gmsh is compiled with HAVE_MESH_POOL). Small
+// objects are carved out of large chunks by size classes, and freed objects
+// are recycled; each thread has its own part of the pool, so allocations do
+// not lock.
+//
+// Each model owns a pool, in which the mesh entities created while the model
+// is meshed or read are allocated (see MEntityPool::scope); the other mesh
+// entities are allocated in a default pool. Each chunk records the pool it
+// belongs to, so that an object can be freed by any thread and in any scope,
+// and the memory of a model can be returned to the system as soon as its
+// mesh is deleted, independently of the other models.
+class MEntityPool{
+ private:
+  unsigned long _id;
+  std::vector<threadPool*> _threads;
+  ~MEntityPool();
+  threadPool *_getThreadPool();
+ public:
+  MEntityPool();
+  // return to the system the chunks of the pool in which no object is alive
+  // anymore (returns false if some chunks are still in use); must be called
+  // outside parallel regions
+  bool release();
+  // get the number of live objects and the memory held by the pool
+  void getStatistics(long &numObjects, size_t &memory) const;
+  // delete the pool, or keep it until all its objects are freed if some are
+  // still alive (e.g. if they were moved to another model)
+  static void destroy(MEntityPool *pool);
+  // release the default pool and the pools kept alive by destroy()
+  static void releaseShared();
+  static void *allocate(size_t size);
+  static void deallocate(void *p, size_t size);
+  // allocate the mesh entities created during the lifetime of a scope object
+  // in the given pool (scopes must be created outside parallel regions)
+  class scope{
+   private:
+    MEntityPool *_previous;
+   public:
+    scope(MEntityPool *pool);
+    ~scope();
+  };
+};
+
+#endif
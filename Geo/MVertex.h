@@ -9,9 +9,11 @@
 #include <stdio.h>
 #include <set>
 #include <map>
+#include "GmshConfig.h"
 #include "SPoint2.h"
 #include "SPoint3.h"
 #include "MVertexBoundaryLayerData.h"
+#include "MEntityPool.h"
 
 class GEntity;
 class GEdge;
@@ -51,6 +53,10 @@ class MVertex{
   MVertex(double x, double y, double z, GEntity *ge=0, int num=0);
   virtual ~MVertex(){}
   void deleteLast();
+#if defined(HAVE_MESH_POOL)
+  void *operator new(size_t size){ return MEntityPool::allocate(size); }
+  void operator delete(void *p, size_t size){ MEntityPool::deallocate(p, size); }
+#endif
 
   // get/set the visibility flag
   virtual char getVisibility(){ return _visible; }
@@ -0,0 +1,506 @@
+// Gmsh - Copyright (C) 1997-2014 C. Geuzaine, J.-F. Remacle
+//
+// See the LICENSE.txt file for license information. Please report all
+// bugs and problems to the public mailing list <gmsh@geuz.org>.
+
+#include <stdlib.h>
+#include "GmshMessage.h"
+#include "GModel.h"
+#include "MElement.h"
+#include "Context.h"
+#include "StringUtils.h"
+#include "mshParallelWriter.h"
+#include "compactMesh.h"
+
+bool compactMesh::canCompact(GModel *model)
+{
+  if(model->getGhostCells().size()){
+    Msg::Error("Cannot compact a mesh with ghost cells");
+    return false;
+  }
+  std::vector<GEntity*> entities;
+  model->getEntities(entities);
+  // all the element nodes must be classified on an entity
+  for(unsigned int i = 0; i < entities.size(); i++)
+    for(unsigned int j = 0; j < entities[i]->getNumMeshElements(); j++){
+      MElement *e = entities[i]->getMeshElement(j);
+      for(int k = 0; k < e->getNumVertices(); k++)
+        e->getVertex(k)->setIndex(-1);
+    }
+  for(unsigned int i = 0; i < entities.size(); i++)
+    for(unsigned int j = 0; j < entities[i]->mesh_vertices.size(); j++)
+      entities[i]->mesh_vertices[j]->setIndex(0);
+  for(unsigned int i = 0; i < entities.size(); i++){
+    for(unsigned int j = 0; j < entities[i]->getNumMeshElements(); j++){
+      MElement *e = entities[i]->getMeshElement(j);
+      int type = e->getTypeForMSH();
+      if(!type || type == MSH_POLYG_ || type == MSH_POLYH_ ||
+         type == MSH_POLYG_B || e->getNumChildren() || e->getParent() ||
+         e->ownsParent() || e->getDomain(0)){
+        Msg::Error("Cannot compact a mesh with polygons, polyhedra, parent "
+                   "or domain elements");
+        return false;
+      }
+      for(int k = 0; k < e->getNumVertices(); k++){
+        if(e->getVertex(k)->getIndex() < 0){
+          Msg::Error("Cannot compact a mesh with unclassified nodes");
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+// find the permutation p such that v2[i] = v1[p[i]] (empty if identity)
+static void getPermutation(const std::vector<MVertex*> &v1,
+                           const std::vector<MVertex*> &v2, std::vector<int> &p)
+{
+  p.resize(v1.size());
+  bool identity = true;
+  for(unsigned int i = 0; i < v2.size(); i++){
+    p[i] = std::find(v1.begin(), v1.end(), v2[i]) - v1.begin();
+    if(p[i] != (int)i) identity = false;
+  }
+  if(identity) p.clear();
+}
+
+compactMesh::compactMesh(GModel *model) : _numElements(0)
+{
+  std::vector<GEntity*> entities;
+  model->getEntities(entities);
+
+  int numNodes = 0;
+  for(unsigned int i = 0; i < entities.size(); i++)
+    numNodes += entities[i]->mesh_vertices.size();
+  _x.reserve(numNodes);
+  _y.reserve(numNodes);
+  _z.reserve(numNodes);
+  _nodeNumbers.reserve(numNodes);
+
+  // nodes are numbered in the order of the entities (the mesh vertex indices
+  // are used to store the node positions)
+  _entities.resize(entities.size());
+  for(unsigned int i = 0; i < entities.size(); i++){
+    entityMesh &em = _entities[i];
+    em.entity = entities[i];
+    em.firstNode = _x.size();
+    em.numNodes = entities[i]->mesh_vertices.size();
+    for(unsigned int j = 0; j < entities[i]->mesh_vertices.size(); j++){
+      MVertex *v = entities[i]->mesh_vertices[j];
+      v->setIndex(_x.size());
+      _x.push_back(v->x());
+      _y.push_back(v->y());
+      _z.push_back(v->z());
+      _nodeNumbers.push_back(v->getNum());
+    }
+  }
+
+  for(unsigned int i = 0; i < entities.size(); i++){
+    entityMesh &em = _entities[i];
+    GEntity *ge = entities[i];
+    for(unsigned int j = 0; j < ge->getNumMeshElements(); j++){
+      MElement *e = ge->getMeshElement(j);
+      int n = e->getNumVertices();
+      if(em.blocks.empty() || em.blocks.back().typeMSH != e->getTypeForMSH()){
+        em.blocks.push_back(elementBlock());
+        elementBlock &b = em.blocks.back();
+        b.family = e->getType();
+        b.typeMSH = e->getTypeForMSH();
+        b.typeVTK = e->getTypeForVTK();
+        b.numNodes = n;
+        std::vector<MVertex*> v(n), r(n);
+        for(int k = 0; k < n; k++) v[k] = e->getVertex(k);
+        e->reverse();
+        for(int k = 0; k < n; k++) r[k] = e->getVertex(k);
+        e->reverse();
+        getPermutation(v, r, b.orderReversed);
+        for(int k = 0; k < n; k++) r[k] = e->getVertexVTK(k);
+        getPermutation(v, r, b.orderVTK);
+      }
+      elementBlock &b = em.blocks.back();
+      b.numbers.push_back(e->getNum());
+      for(int k = 0; k < n; k++)
+        b.nodes.push_back(e->getVertex(k)->getIndex());
+      if(e->getPartition() && b.partitions.empty())
+        b.partitions.resize(b.numbers.size() - 1, 0);
+      if(b.partitions.size())
+        b.partitions.push_back(e->getPartition());
+      _numElements++;
+    }
+    for(std::map<MVertex*, MVertex*>::iterator it =
+          ge->correspondingVertices.begin();
+        it != ge->correspondingVertices.end(); it++){
+      em.periodicNodes.push_back(it->first->getIndex());
+      em.periodicNodes.push_back(it->second->getIndex());
+    }
+  }
+}
+
+size_t compactMesh::getMemoryUsage() const
+{
+  size_t mem = (_x.capacity() + _y.capacity() + _z.capacity()) * sizeof(double) +
+    (_nodeNumbers.capacity() + _nodeIndex.capacity() + _elementIndex.capacity() +
+     _nodePosition.capacity() + _elementPosition.capacity()) * sizeof(int);
+  for(unsigned int i = 0; i < _entities.size(); i++){
+    const entityMesh &em = _entities[i];
+    mem += sizeof(entityMesh) + em.periodicNodes.capacity() * sizeof(int);
+    for(unsigned int j = 0; j < em.blocks.size(); j++){
+      const elementBlock &b = em.blocks[j];
+      mem += sizeof(elementBlock) + b.partitions.capacity() * sizeof(short) +
+        (b.numbers.capacity() + b.nodes.capacity() + b.orderReversed.capacity() +
+         b.orderVTK.capacity()) * sizeof(int);
+    }
+  }
+  return mem;
+}
+
+// index the nodes of the saved elements in a continuous sequence, as
+// GModel::indexMeshVertices() does, and return the number of saved nodes
+int compactMesh::_indexNodes(bool saveAll)
+{
+  _nodeIndex.assign(_x.size(), 0);
+  for(unsigned int i = 0; i < _entities.size(); i++){
+    const entityMesh &em = _entities[i];
+    if(!saveAll && em.entity->physicals.empty()) continue;
+    for(unsigned int j = 0; j < em.blocks.size(); j++)
+      for(unsigned int k = 0; k < em.blocks[j].nodes.size(); k++)
+        _nodeIndex[em.blocks[j].nodes[k]] = 1;
+  }
+  int index = 0;
+  for(unsigned int i = 0; i < _nodeIndex.size(); i++)
+    if(_nodeIndex[i]) _nodeIndex[i] = ++index;
+  return index;
+}
+
+class compactNodeWriterMSH {
+ private:
+  const std::vector<double> &_x, &_y, &_z;
+  const std::vector<int> &_index;
+  bool _binary;
+  double _scalingFactor;
+ public:
+  compactNodeWriterMSH(const std::vector<double> &x,
+                       const std::vector<double> &y,
+                       const std::vector<double> &z,
+                       const std::vector<int> &index, bool binary,
+                       double scalingFactor)
+    : _x(x), _y(y), _z(z), _index(index), _binary(binary),
+      _scalingFactor(scalingFactor) {}
+  void operator()(FILE *fp, std::size_t i)
+  {
+    if(!_index[i]) return;
+    if(!_binary){
+      fprintf(fp, "%d %.16g %.16g %.16g\n", _index[i], _x[i] * _scalingFactor,
+              _y[i] * _scalingFactor, _z[i] * _scalingFactor);
+    }
+    else{
+      fwrite(&_index[i], sizeof(int), 1, fp);
+      double data[3] = {_x[i] * _scalingFactor, _y[i] * _scalingFactor,
+                        _z[i] * _scalingFactor};
+      fwrite(data, sizeof(double), 3, fp);
+    }
+  }
+};
+
+// writes the records of the elements of a block in ASCII, with consecutive
+// numbers starting at startNum + 1
+class compactElementWriterMSH {
+ private:
+  const compactMesh::elementBlock &_b;
+  const std::vector<int> &_index, &_physicals;
+  bool _saveAll;
+  int _elementary, _startNum, _numRecords;
+ public:
+  compactElementWriterMSH(const compactMesh::elementBlock &b,
+                          const std::vector<int> &index,
+                          const std::vector<int> &physicals, bool saveAll,
+                          int elementary, int startNum)
+    : _b(b), _index(index), _physicals(physicals), _saveAll(saveAll),
+      _elementary(elementary),
+      _startNum(startNum), _numRecords(saveAll ? 1 : physicals.size()) {}
+  void operator()(FILE *fp, std::size_t i)
+  {
+    const int *nodes = &_b.nodes[i * _b.numNodes];
+    int partition = _b.partitions.empty() ? 0 : _b.partitions[i];
+    for(int r = 0; r < _numRecords; r++){
+      int physical = _saveAll ? 0 : _physicals[r];
+      fprintf(fp, "%d %d", _startNum + (int)i * _numRecords + r + 1, _b.typeMSH);
+      if(!partition)
+        fprintf(fp, " 2 %d %d", abs(physical), _elementary);
+      else
+        fprintf(fp, " 4 %d %d 1 %d", abs(physical), _elementary, partition);
+      bool reversed = (physical < 0 && _b.orderReversed.size());
+      for(int k = 0; k < _b.numNodes; k++)
+        fprintf(fp, " %d", _index[nodes[reversed ? _b.orderReversed[k] : k]]);
+      fprintf(fp, "\n");
+    }
+  }
+};
+
+int compactMesh::writeMSH(const std::string &name, bool binary, bool saveAll,
+                          double scalingFactor, int elementStartNum,
+                          bool multipleView)
+{
+  FILE *fp = fopenMSH(name, binary, multipleView);
+  if(!fp){
+    Msg::Error("Unable to open file '%s'", name.c_str());
+    return 0;
+  }
+
+  GModel *model = _entities.size() ? _entities[0].entity->model() : 0;
+  if(!model || model->noPhysicalGroups()) saveAll = true;
+
+  int numNodes = _indexNodes(saveAll);
+  int numElements = 0;
+  for(unsigned int i = 0; i < _entities.size(); i++){
+    const entityMesh &em = _entities[i];
+    int numRecords = saveAll ? 1 : em.entity->physicals.size();
+    for(unsigned int j = 0; j < em.blocks.size(); j++)
+      numElements += numRecords * em.blocks[j].getNumElements();
+  }
+
+  fprintf(fp, "$MeshFormat\n");
+  fprintf(fp, "%g %d %d\n", 2.2, binary ? 1 : 0, (int)sizeof(double));
+  if(binary){
+    int one = 1;
+    fwrite(&one, sizeof(int), 1, fp);
+    fprintf(fp, "\n");
+  }
+  fprintf(fp, "$EndMeshFormat\n");
+
+  if(model && model->numPhysicalNames()){
+    fprintf(fp, "$PhysicalNames\n");
+    fprintf(fp, "%d\n", model->numPhysicalNames());
+    for(GModel::piter it = model->firstPhysicalName();
+        it != model->lastPhysicalName(); it++)
+      fprintf(fp, "%d %d \"%s\"\n", it->first.first, it->first.second,
+              it->second.c_str());
+    fprintf(fp, "$EndPhysicalNames\n");
+  }
+
+  fprintf(fp, "$Nodes\n");
+  fprintf(fp, "%d\n", numNodes);
+  compactNodeWriterMSH nodeWriter(_x, _y, _z, _nodeIndex, binary, scalingFactor);
+  if(CTX::instance()->mesh.mshFileParallelWrite)
+    writeMSHInParallel(fp, _x.size(), nodeWriter);
+  else
+    for(unsigned int i = 0; i < _x.size(); i++) nodeWriter(fp, i);
+  if(binary) fprintf(fp, "\n");
+  fprintf(fp, "$EndNodes\n");
+
+  fprintf(fp, "$Elements\n");
+  fprintf(fp, "%d\n", numElements);
+
+  // elements are saved by family, in the same order as in
+  // GModel::_writeMSH2()
+  const int families[8] = {TYPE_PNT, TYPE_LIN, TYPE_TRI, TYPE_QUA, TYPE_TET,
+                           TYPE_HEX, TYPE_PRI, TYPE_PYR};
+  _elementIndex.assign(_numElements, 0);
+  int num = elementStartNum;
+  for(int f = 0; f < 8; f++){
+    int pos = 0;
+    for(unsigned int i = 0; i < _entities.size(); i++){
+      const entityMesh &em = _entities[i];
+      std::vector<int> &physicals = em.entity->physicals;
+      int elementary = em.entity->tag();
+      int numRecords = saveAll ? 1 : physicals.size();
+      for(unsigned int j = 0; j < em.blocks.size(); j++){
+        const elementBlock &b = em.blocks[j];
+        int ne = b.getNumElements();
+        if(b.family != families[f] || !numRecords){
+          pos += ne;
+          continue;
+        }
+        if(!binary){
+          compactElementWriterMSH writer(b, _nodeIndex, physicals, saveAll,
+                                         elementary, num);
+          if(CTX::instance()->mesh.mshFileParallelWrite)
+            writeMSHInParallel(fp, ne, writer);
+          else
+            for(int k = 0; k < ne; k++) writer(fp, k);
+        }
+        else{
+          int numTags = b.partitions.empty() ? 2 : 4;
+          int header[3] = {b.typeMSH, ne * numRecords, numTags};
+          fwrite(header, sizeof(int), 3, fp);
+          std::vector<int> data(1 + numTags + b.numNodes);
+          for(int k = 0; k < ne; k++){
+            const int *nodes = &b.nodes[k * b.numNodes];
+            for(int r = 0; r < numRecords; r++){
+              int physical = saveAll ? 0 : physicals[r];
+              bool reversed = (physical < 0 && b.orderReversed.size());
+              data[0] = num + k * numRecords + r + 1;
+              data[1] = abs(physical);
+              data[2] = elementary;
+              if(numTags == 4){
+                data[3] = 1;
+                data[4] = b.partitions[k];
+              }
+              for(int l = 0; l < b.numNodes; l++)
+                data[1 + numTags + l] =
+                  _nodeIndex[nodes[reversed ? b.orderReversed[l] : l]];
+              fwrite(&data[0], sizeof(int), data.size(), fp);
+            }
+          }
+        }
+        for(int k = 0; k < ne; k++)
+          _elementIndex[pos + k] = num + (k + 1) * numRecords;
+        num += ne * numRecords;
+        pos += ne;
+      }
+    }
+  }
+
+  if(binary) fprintf(fp, "\n");
+  fprintf(fp, "$EndElements\n");
+
+  int count = 0;
+  for(unsigned int i = 0; i < _entities.size(); i++)
+    if(_entities[i].entity->meshMaster() != _entities[i].entity->tag()) count++;
+  if(count){
+    fprintf(fp, "$Periodic\n");
+    fprintf(fp, "%d\n", count);
+    for(unsigned int i = 0; i < _entities.size(); i++){
+      GEntity *ge = _entities[i].entity;
+      if(ge->meshMaster() == ge->tag()) continue;
+      const std::vector<int> &p = _entities[i].periodicNodes;
+      fprintf(fp, "%d %d %d\n", ge->dim(), ge->tag(), abs(ge->meshMaster()));
+      fprintf(fp, "%d\n", (int)p.size() / 2);
+      for(unsigned int j = 0; j < p.size(); j += 2)
+        fprintf(fp, "%d %d\n", _nodeIndex[p[j]], _nodeIndex[p[j + 1]]);
+    }
+    fprintf(fp, "$EndPeriodic\n");
+  }
+
+  fclose(fp);
+  return 1;
+}
+
+int compactMesh::writeVTK(const std::string &name, bool binary, bool saveAll,
+                          double scalingFactor, bool bigEndian)
+{
+  FILE *fp = Fopen(name.c_str(), binary ? "wb" : "w");
+  if(!fp){
+    Msg::Error("Unable to open file '%s'", name.c_str());
+    return 0;
+  }
+
+  GModel *model = _entities.size() ? _entities[0].entity->model() : 0;
+  if(!model || model->noPhysicalGroups()) saveAll = true;
+
+  int numNodes = _indexNodes(saveAll);
+
+  fprintf(fp, "# vtk DataFile Version 2.0\n");
+  fprintf(fp, "%s, Created by Gmsh\n", model ? model->getName().c_str() : "");
+  if(binary)
+    fprintf(fp, "BINARY\n");
+  else
+    fprintf(fp, "ASCII\n");
+  fprintf(fp, "DATASET UNSTRUCTURED_GRID\n");
+
+  fprintf(fp, "POINTS %d double\n", numNodes);
+  for(unsigned int i = 0; i < _x.size(); i++){
+    if(!_nodeIndex[i]) continue;
+    double data[3] = {_x[i] * scalingFactor, _y[i] * scalingFactor,
+                      _z[i] * scalingFactor};
+    if(binary){
+      // VTK always expects big endian binary data
+      if(!bigEndian) SwapBytes((char*)data, sizeof(double), 3);
+      fwrite(data, sizeof(double), 3, fp);
+    }
+    else
+      fprintf(fp, "%.16g %.16g %.16g\n", data[0], data[1], data[2]);
+  }
+  fprintf(fp, "\n");
+
+  std::vector<const elementBlock*> blocks;
+  int numElements = 0, totalNumInt = 0;
+  for(unsigned int i = 0; i < _entities.size(); i++){
+    const entityMesh &em = _entities[i];
+    if(!saveAll && em.entity->physicals.empty()) continue;
+    for(unsigned int j = 0; j < em.blocks.size(); j++){
+      const elementBlock &b = em.blocks[j];
+      if(!b.typeVTK) continue;
+      blocks.push_back(&b);
+      numElements += b.getNumElements();
+      totalNumInt += b.getNumElements() * (b.numNodes + 1);
+    }
+  }
+
+  fprintf(fp, "CELLS %d %d\n", numElements, totalNumInt);
+  std::vector<int> data;
+  for(unsigned int i = 0; i < blocks.size(); i++){
+    const elementBlock &b = *blocks[i];
+    data.resize(b.numNodes + 1);
+    data[0] = b.numNodes;
+    for(int k = 0; k < b.getNumElements(); k++){
+      const int *nodes = &b.nodes[k * b.numNodes];
+      for(int l = 0; l < b.numNodes; l++)
+        data[l + 1] = _nodeIndex[nodes[b.orderVTK.size() ? b.orderVTK[l] : l]] - 1;
+      if(binary){
+        if(!bigEndian) SwapBytes((char*)&data[0], sizeof(int), data.size());
+        fwrite(&data[0], sizeof(int), data.size(), fp);
+        if(!bigEndian) SwapBytes((char*)&data[0], sizeof(int), 1);
+      }
+      else{
+        fprintf(fp, "%d", data[0]);
+        for(int l = 0; l < b.numNodes; l++) fprintf(fp, " %d", data[l + 1]);
+        fprintf(fp, "\n");
+      }
+    }
+  }
+  fprintf(fp, "\n");
+
+  fprintf(fp, "CELL_TYPES %d\n", numElements);
+  for(unsigned int i = 0; i < blocks.size(); i++){
+    int type = blocks[i]->typeVTK;
+    if(binary && !bigEndian) SwapBytes((char*)&type, sizeof(int), 1);
+    for(int k = 0; k < blocks[i]->getNumElements(); k++){
+      if(binary)
+        fwrite(&type, sizeof(int), 1, fp);
+      else
+        fprintf(fp, "%d\n", type);
+    }
+  }
+
+  fclose(fp);
+  return 1;
+}
+
+void compactMesh::_buildPositions(const std::vector<int> &numbers,
+                                  std::vector<int> &positions)
+{
+  int maxNum = 0;
+  for(unsigned int i = 0; i < numbers.size(); i++)
+    maxNum = std::max(maxNum, numbers[i]);
+  positions.assign(maxNum + 1, -1);
+  for(unsigned int i = 0; i < numbers.size(); i++)
+    if(numbers[i] >= 0) positions[numbers[i]] = i;
+}
+
+int compactMesh::getNodeIndexByNumber(int num)
+{
+  if(_nodePosition.empty()) _buildPositions(_nodeNumbers, _nodePosition);
+  if(num < 0 || num >= (int)_nodePosition.size() || _nodePosition[num] < 0 ||
+     _nodeIndex.empty())
+    return 0;
+  return _nodeIndex[_nodePosition[num]];
+}
+
+int compactMesh::getElementIndexByNumber(int num)
+{
+  if(_elementPosition.empty()){
+    std::vector<int> numbers;
+    numbers.reserve(_numElements);
+    for(unsigned int i = 0; i < _entities.size(); i++)
+      for(unsigned int j = 0; j < _entities[i].blocks.size(); j++)
+        numbers.insert(numbers.end(), _entities[i].blocks[j].numbers.begin(),
+                       _entities[i].blocks[j].numbers.end());
+    _buildPositions(numbers, _elementPosition);
+  }
+  if(num < 0 || num >= (int)_elementPosition.size() ||
+     _elementPosition[num] < 0 || _elementIndex.empty())
+    return 0;
+  return _elementIndex[_elementPosition[num]];
+}
@@ -0,0 +1,85 @@
+// Gmsh - Copyright (C) 1997-2014 C. Geuzaine, J.-F. Remacle
+//
+// See the LICENSE.txt file for license information. Please report all
+// bugs and problems to the public mailing list <gmsh@geuz.org>.
+
+#ifndef _COMPACT_MESH_H_
+#define _COMPACT_MESH_H_
+
+#include <stddef.h>
+#include <string>
+#include <vector>
+
+class GModel;
+class GEntity;
+
+// A compact, read-only representation of the mesh of a model: the node
+// coordinates are stored in flat arrays, and the elements of each entity are
+// stored by blocks of elements of the same type, as arrays of node
+// indices. This takes a fraction of the memory used by the MVertex and
+// MElement objects, which can be deleted once the compact mesh is built (see
+// GModel::compactifyMesh()).
+class compactMesh{
+ public:
+  // consecutive elements of the same type in an entity
+  struct elementBlock{
+    // the element family (TYPE_TRI, ...) and the MSH and VTK element types
+    int family, typeMSH, typeVTK, numNodes;
+    // node permutations giving the reversed element and the VTK ordering
+    // (empty if they are the identity)
+    std::vector<int> orderReversed, orderVTK;
+    // element numbers, node indices (numNodes per element) and partitions
+    // (empty if no element of the block is in a partition)
+    std::vector<int> numbers, nodes;
+    std::vector<short> partitions;
+    int getNumElements() const { return (int)numbers.size(); }
+  };
+  // the mesh of an entity, with its nodes firstNode, ..., firstNode +
+  // numNodes - 1
+  struct entityMesh{
+    GEntity *entity;
+    int firstNode, numNodes;
+    std::vector<elementBlock> blocks;
+    // pairs of (slave, master) periodic nodes
+    std::vector<int> periodicNodes;
+  };
+ private:
+  std::vector<double> _x, _y, _z;
+  std::vector<int> _nodeNumbers;
+  std::vector<entityMesh> _entities;
+  int _numElements;
+  // indices of the nodes and elements in the last file written (0 if not
+  // saved)
+  std::vector<int> _nodeIndex, _elementIndex;
+  // positions of the nodes and elements given their number (built on demand)
+  std::vector<int> _nodePosition, _elementPosition;
+  int _indexNodes(bool saveAll);
+  void _buildPositions(const std::vector<int> &numbers,
+                       std::vector<int> &positions);
+ public:
+  // check if the mesh of the model can be represented in compact form (it
+  // must only contain standard elements: no polygons/polyhedra, parent or
+  // domain elements, or ghost cells)
+  static bool canCompact(GModel *model);
+  compactMesh(GModel *model);
+  int getNumNodes() const { return (int)_x.size(); }
+  int getNumElements() const { return _numElements; }
+  double x(int i) const { return _x[i]; }
+  double y(int i) const { return _y[i]; }
+  double z(int i) const { return _z[i]; }
+  int getNodeNumber(int i) const { return _nodeNumbers[i]; }
+  const std::vector<entityMesh> &getEntities() const { return _entities; }
+  // memory used by the compact mesh, in bytes
+  size_t getMemoryUsage() const;
+  // save the mesh in MSH (version 2.2) or VTK format
+  int writeMSH(const std::string &name, bool binary, bool saveAll,
+               double scalingFactor, int elementStartNum, bool multipleView);
+  int writeVTK(const std::string &name, bool binary, bool saveAll,
+               double scalingFactor, bool bigEndian);
+  // get the index of a node or an element in the last file written, given
+  // its number (returns 0 if it was not saved)
+  int getNodeIndexByNumber(int num);
+  int getElementIndexByNumber(int num);
+};
+
+#endif
@@ -0,0 +1,177 @@
+// Gmsh - Copyright (C) 1997-2014 C. Geuzaine, J.-F. Remacle
+//
+// See the LICENSE.txt file for license information. Please report all
+// bugs and problems to the public mailing list <gmsh@geuz.org>.
+
+#include <string.h>
+#include <stdlib.h>
+#include <string>
+#include <algorithm>
+#include "mshAsciiReader.h"
+#include "GmshMessage.h"
+
+static inline bool isSpace(char c)
+{
+  return (c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' ||
+          c == '\f');
+}
+
+static inline bool isDigit(char c)
+{
+  return (c >= '0' && c <= '9');
+}
+
+static bool slowAsciiToDouble(const char *s, const char *end, double &val)
+{
+  std::string str(s, end);
+  char *last;
+  val = strtod(str.c_str(), &last);
+  return (last != str.c_str() && *last == '\0');
+}
+
+bool mshAsciiToDouble(const char *s, const char *end, double &val)
+{
+  // powers of ten that are exactly representable as doubles
+  static const double p10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+    1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+  const char *p = s;
+  bool neg = false;
+  if(p < end && (*p == '-' || *p == '+')) neg = (*p++ == '-');
+
+  // accumulate (at most 19) significant digits in an integer mantissa
+  unsigned long long m = 0;
+  int numSignificant = 0, numDigits = 0, e10 = 0;
+  for(; p < end && isDigit(*p); p++, numDigits++){
+    if(numSignificant == 19) return slowAsciiToDouble(s, end, val);
+    m = 10 * m + (*p - '0');
+    if(m) numSignificant++;
+  }
+  if(p < end && *p == '.'){
+    for(p++; p < end && isDigit(*p); p++, numDigits++){
+      if(numSignificant == 19) return slowAsciiToDouble(s, end, val);
+      m = 10 * m + (*p - '0');
+      if(m) numSignificant++;
+      e10--;
+    }
+  }
+  if(!numDigits) return slowAsciiToDouble(s, end, val); // inf, nan, ...
+  if(p < end && (*p == 'e' || *p == 'E')){
+    p++;
+    bool eneg = false;
+    if(p < end && (*p == '-' || *p == '+')) eneg = (*p++ == '-');
+    int e = 0, numExpDigits = 0;
+    for(; p < end && isDigit(*p); p++, numExpDigits++)
+      if(e < 10000) e = 10 * e + (*p - '0');
+    if(!numExpDigits) return false;
+    e10 += eneg ? -e : e;
+  }
+  if(p != end) return slowAsciiToDouble(s, end, val);
+
+  if(!m){
+    val = neg ? -0. : 0.;
+    return true;
+  }
+  // if both the mantissa and the power of ten are exact, a single
+  // multiplication or division gives the correctly rounded result (this is
+  // always the case for integers, and for most coordinates written with
+  // "%.16g")
+  if(m <= (1ULL << 53) && e10 >= -22 && e10 <= 22){
+    double d = (double)m;
+    d = (e10 < 0) ? d / p10[-e10] : d * p10[e10];
+    val = neg ? -d : d;
+    return true;
+  }
+  return slowAsciiToDouble(s, end, val);
+}
+
+// convert all the whitespace-separated numbers in [s, end); stops at the
+// first invalid number and returns false
+static bool asciiToDoubles(const char *s, const char *end,
+                           std::vector<double> &values)
+{
+  values.reserve(values.size() + (end - s) / 8);
+  while(1){
+    while(s < end && isSpace(*s)) s++;
+    if(s == end) return true;
+    const char *t = s;
+    while(t < end && !isSpace(*t)) t++;
+    double val;
+    if(!mshAsciiToDouble(s, t, val)) return false;
+    values.push_back(val);
+    s = t;
+  }
+}
+
+mshAsciiReader::mshAsciiReader(FILE *fp, bool buffered, std::size_t blockSize)
+  : _fp(fp), _buffered(buffered), _end(false), _blockSize(blockSize),
+    _current(0)
+{
+}
+
+bool mshAsciiReader::_readBlock()
+{
+  _values.clear();
+  _current = 0;
+  while(_values.empty() && !_end) _convertBlock();
+  return !_values.empty();
+}
+
+void mshAsciiReader::_convertBlock()
+{
+  // _text contains the last (possibly incomplete) number of the previous
+  // block: append the new data to it
+  std::size_t carry = _text.size();
+  _text.resize(carry + _blockSize);
+  std::size_t n = fread(&_text[carry], sizeof(char), _blockSize, _fp);
+  std::size_t size = carry + n, last = size;
+  char *dollar = n ? (char*)memchr(&_text[carry], '$', n) : 0;
+  if(dollar){
+    // end of the section: give back everything from the '$' on
+    last = dollar - &_text[0];
+    fseek(_fp, -(long)(size - last), SEEK_CUR);
+    _end = true;
+  }
+  else if(n < _blockSize){
+    _end = true;
+  }
+  else{
+    while(last > 0 && !isSpace(_text[last - 1])) last--;
+  }
+  const char *text = last ? &_text[0] : 0;
+
+  // split the block at whitespace boundaries and convert each chunk in its own
+  // thread
+  int nt = (last > (1 << 16)) ? std::max(1, Msg::GetMaxThreads()) : 1;
+  std::vector<std::size_t> bounds(nt + 1, 0);
+  bounds[nt] = last;
+  for(int i = 1; i < nt; i++){
+    std::size_t b = std::max(bounds[i - 1], (last / nt) * i);
+    while(b < last && !isSpace(text[b])) b++;
+    bounds[i] = b;
+  }
+  std::vector<std::vector<double> > values(nt);
+  std::vector<char> ok(nt, 1);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static, 1)
+#endif
+  for(int i = 0; i < nt; i++)
+    ok[i] = asciiToDoubles(text + bounds[i], text + bounds[i + 1], values[i]);
+
+  std::size_t numValues = 0;
+  for(int i = 0; i < nt; i++) numValues += values[i].size();
+  _values.reserve(numValues);
+  for(int i = 0; i < nt; i++){
+    _values.insert(_values.end(), values[i].begin(), values[i].end());
+    if(!ok[i]){
+      _end = true;
+      break;
+    }
+  }
+  // keep the incomplete number for the next block
+  if(_end)
+    _text.clear();
+  else
+    _text.erase(_text.begin(), _text.begin() + last);
+}
@@ -0,0 +1,55 @@
+// Gmsh - Copyright (C) 1997-2014 C. Geuzaine, J.-F. Remacle
+//
+// See the LICENSE.txt file for license information. Please report all
+// bugs and problems to the public mailing list <gmsh@geuz.org>.
+
+#ifndef _MSH_ASCII_READER_H_
+#define _MSH_ASCII_READER_H_
+
+#include <stdio.h>
+#include <vector>
+
+// Reads the numbers stored in a section of an ASCII MSH file. In buffered
+// mode, the file is read by large blocks, which are split at whitespace
+// boundaries and converted in parallel with a hand-written number parser;
+// otherwise every number is read with fscanf (the historical behavior). In
+// both cases reading stops before the next line starting with '$', so that
+// the file pointer is left at the end of the section.
+class mshAsciiReader {
+ private:
+  FILE *_fp;
+  bool _buffered, _end;
+  std::size_t _blockSize, _current;
+  std::vector<char> _text;
+  std::vector<double> _values;
+  void _convertBlock();
+  bool _readBlock();
+ public:
+  mshAsciiReader(FILE *fp, bool buffered, std::size_t blockSize = 1 << 23);
+  inline bool get(double &val)
+  {
+    if(!_buffered) return fscanf(_fp, "%lf", &val) == 1;
+    if(_current == _values.size() && !_readBlock()) return false;
+    val = _values[_current++];
+    return true;
+  }
+  inline bool get(int &val)
+  {
+    if(!_buffered) return fscanf(_fp, "%d", &val) == 1;
+    if(_current == _values.size() && !_readBlock()) return false;
+    val = (int)_values[_current];
+    return _values[_current++] == (double)val;
+  }
+  template <class T> bool get(T *val, int n)
+  {
+    for(int i = 0; i < n; i++)
+      if(!get(val[i])) return false;
+    return true;
+  }
+};
+
+// Fast conversion of the number stored in [s, end): returns false if the
+// characters do not represent a valid number
+bool mshAsciiToDouble(const char *s, const char *end, double &val);
+
+#endif
@@ -0,0 +1,51 @@
+// Gmsh - Copyright (C) 1997-2014 C. Geuzaine, J.-F. Remacle
+//
+// See the LICENSE.txt file for license information. Please report all
+// bugs and problems to the public mailing list <gmsh@geuz.org>.
+
+#include "mshBinaryReader.h"
+#include "OS.h"
+
+// 64 bit file positions (mapped files can be larger than 2Gb)
+static bool tellFile(FILE *fp, std::size_t &pos)
+{
+#if defined(WIN32) && !defined(__CYGWIN__)
+  __int64 p = _ftelli64(fp);
+#else
+  off_t p = ftello(fp);
+#endif
+  if(p < 0) return false;
+  pos = (std::size_t)p;
+  return true;
+}
+
+static void seekFile(FILE *fp, std::size_t pos)
+{
+#if defined(WIN32) && !defined(__CYGWIN__)
+  _fseeki64(fp, (__int64)pos, SEEK_SET);
+#else
+  fseeko(fp, (off_t)pos, SEEK_SET);
+#endif
+}
+
+mshBinaryReader::mshBinaryReader(FILE *fp, const std::string &fileName,
+                                 bool swap, bool mapped)
+  : _fp(fp), _swap(swap), _data(0), _size(0), _offset(0)
+{
+  if(!mapped) return;
+  _data = MapFile(fileName, _size);
+  if(_data && (!tellFile(_fp, _offset) || _offset > _size)){
+    UnmapFile(_data, _size);
+    _data = 0;
+  }
+}
+
+mshBinaryReader::~mshBinaryReader()
+{
+  UnmapFile(_data, _size);
+}
+
+void mshBinaryReader::updateFilePosition()
+{
+  if(_data) seekFile(_fp, _offset);
+}
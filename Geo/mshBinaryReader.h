@@ -0,0 +1,68 @@
+// Gmsh - Copyright (C) 1997-2014 C. Geuzaine, J.-F. Remacle
+//
+// See the LICENSE.txt file for license information. Please report all
+// bugs and problems to the public mailing list <gmsh@geuz.org>.
+
+#ifndef _MSH_BINARY_READER_H_
+#define _MSH_BINARY_READER_H_
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "StringUtils.h"
+
+// Reads the binary records of a section of an MSH file. In mapped mode, the
+// file is mapped in memory and the records are accessed in place (bytes are
+// only swapped, in bulk, if the endianness of the file requires it);
+// otherwise, or if the file cannot be mapped, the records are read with
+// fread. In mapped mode, updateFilePosition() must be called before the file
+// is read again through the file pointer.
+class mshBinaryReader {
+ private:
+  FILE *_fp;
+  bool _swap;
+  const char *_data;
+  std::size_t _size, _offset;
+  std::vector<char> _buffer;
+ public:
+  mshBinaryReader(FILE *fp, const std::string &fileName, bool swap,
+                  bool mapped);
+  ~mshBinaryReader();
+  bool mapped() const { return _data != 0; }
+  void updateFilePosition();
+  // copy the next n values into val
+  template <class T> bool get(T *val, std::size_t n)
+  {
+    if(!_data){
+      if(fread(val, sizeof(T), n, _fp) != n) return false;
+    }
+    else{
+      if(_offset + n * sizeof(T) > _size) return false;
+      memcpy(val, _data + _offset, n * sizeof(T));
+      _offset += n * sizeof(T);
+    }
+    if(_swap) SwapBytes((char*)val, sizeof(T), n);
+    return true;
+  }
+  // access the next n values: the returned pointer points directly into the
+  // mapped file if possible, or to an internal buffer (valid until the next
+  // call) otherwise
+  template <class T> const T *get(std::size_t n)
+  {
+    if(_data && !_swap && !((std::size_t)(_data + _offset) % sizeof(T))){
+      if(_offset + n * sizeof(T) > _size) return 0;
+      const T *val = (const T*)(_data + _offset);
+      _offset += n * sizeof(T);
+      return val;
+    }
+    _buffer.resize(n * sizeof(T) + sizeof(T));
+    // align the buffer on the size of T
+    T *val = (T*)(&_buffer[0] + (sizeof(T) - (std::size_t)&_buffer[0] %
+                                 sizeof(T)) % sizeof(T));
+    if(!get(val, n)) return 0;
+    return val;
+  }
+};
+
+#endif
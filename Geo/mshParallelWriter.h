@@ -0,0 +1,79 @@
+// Gmsh - Copyright (C) 1997-2014 C. Geuzaine, J.-F. Remacle
+//
+// See the LICENSE.txt file for license information. Please report all
+// bugs and problems to the public mailing list <gmsh@geuz.org>.
+
+#ifndef _MSH_PARALLEL_WRITER_H_
+#define _MSH_PARALLEL_WRITER_H_
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "OS.h"
+#include "GmshMessage.h"
+
+// Produces the same output as "for(i = 0; i < n; i++) write(fp, i);", but
+// chunks of consecutive indices are formatted in parallel into thread-local
+// memory buffers, which are then written in order into fp. write(fp, i) must
+// only depend on i (and not modify shared data).
+template <class W>
+void writeMSHInParallel(FILE *fp, std::size_t n, W &write,
+                        std::size_t chunkSize = 10000)
+{
+  int nt = Msg::GetMaxThreads();
+  std::vector<std::string> buffers(nt);
+  if(nt > 1 && n > chunkSize){
+    FILE *test = FopenMemory(&buffers[0]);
+    if(test) fclose(test);
+    else nt = 1;
+  }
+  if(nt < 2 || n <= chunkSize){
+    for(std::size_t i = 0; i < n; i++) write(fp, i);
+    return;
+  }
+  std::vector<char> failed(nt);
+  for(std::size_t start = 0; start < n; start += nt * chunkSize){
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static, 1)
+#endif
+    for(int t = 0; t < nt; t++){
+      buffers[t].clear();
+      std::size_t begin = start + t * chunkSize;
+      std::size_t end = std::min(begin + chunkSize, n);
+      FILE *mem = (begin < end) ? FopenMemory(&buffers[t]) : 0;
+      failed[t] = (begin < end && !mem);
+      if(!mem) continue;
+      for(std::size_t i = begin; i < end; i++) write(mem, i);
+      fclose(mem);
+    }
+    for(int t = 0; t < nt; t++){
+      if(failed[t]){
+        std::size_t begin = start + t * chunkSize;
+        std::size_t end = std::min(begin + chunkSize, n);
+        for(std::size_t i = begin; i < end; i++) write(fp, i);
+      }
+      else if(buffers[t].size())
+        fwrite(buffers[t].data(), sizeof(char), buffers[t].size(), fp);
+    }
+  }
+}
+
+// Opens an MSH file for writing: if the file name ends with ".gz", the file
+// is compressed on the fly, which requires zlib and custom streams (the
+// function returns 0 if the file cannot be compressed, instead of writing an
+// uncompressed ".gz" file)
+inline FILE *fopenMSH(const std::string &name, bool binary, bool append)
+{
+  const char *mode = append ? (binary ? "ab" : "a") : (binary ? "wb" : "w");
+  if(name.size() > 3 && name.compare(name.size() - 3, 3, ".gz") == 0){
+    FILE *fp = FopenCompressed(name.c_str(), append ? "ab" : "wb");
+    if(!fp)
+      Msg::Error("Compressed output not available: save '%s' without the "
+                 "'.gz' extension", name.c_str());
+    return fp;
+  }
+  return Fopen(name.c_str(), mode);
+}
+
+#endif
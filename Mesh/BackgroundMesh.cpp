@@ -309,7 +309,7 @@ static double LC_MVertex_CURV(GEntity *ge, double U, double V)
 
 SMetric3 LC_MVertex_CURV_ANISO(GEntity *ge, double U, double V)
 {
-  bool iso_surf = CTX::instance()->mesh.lcFromCurvature == 2;
+  bool iso_surf = backgroundMesh::getLcFromCurvature() == 2;
 
   switch(ge->dim()){
   case 0: return metric_based_on_surface_curvature((const GVertex *)ge, iso_surf);
@@ -369,7 +369,7 @@ double BGM_MeshSize(GEntity *ge, double U, double V,
 
   // lc from curvature
   double l3 = MAX_LC;
-  if(CTX::instance()->mesh.lcFromCurvature && ge->dim() < 3)
+  if(backgroundMesh::getLcFromCurvature() && ge->dim() < 3)
     l3 = LC_MVertex_CURV(ge, U, V);
 
   // lc from fields
@@ -377,7 +377,12 @@ double BGM_MeshSize(GEntity *ge, double U, double V,
   FieldManager *fields = ge->model()->getFields();
   if(fields->getBackgroundField() > 0){
     Field *f = fields->get(fields->getBackgroundField());
-    if(f) l4 = (*f)(X, Y, Z, ge);
+    if(f){
+      const bool stats = Field::gatherStatistics();
+      double t1 = stats ? GetTimeInSeconds() : 0.;
+      l4 = (*f)(X, Y, Z, ge);
+      if(stats) f->addEvaluation(GetTimeInSeconds() - t1);
+    }
   }
 
   // take the minimum, then constrain by lcMin and lcMax
@@ -426,18 +431,21 @@ SMetric3 BGM_MeshMetric(GEntity *ge,
   if(fields->getBackgroundField() > 0){
     Field *f = fields->get(fields->getBackgroundField());
     if(f) {
+      const bool stats = Field::gatherStatistics();
+      double t1 = stats ? GetTimeInSeconds() : 0.;
       SMetric3 l4;
       if (!f->isotropic()) (*f)(X, Y, Z, l4, ge);
       else {
         const double L = (*f)(X, Y, Z, ge);
         l4 = SMetric3(1/(L*L));
       }
+      if(stats) f->addEvaluation(GetTimeInSeconds() - t1);
       m1 = intersection(l4, m0);
     }
   }
 
   // Intersect with metrics from curvature if applicable
-  SMetric3 m = (CTX::instance()->mesh.lcFromCurvature && ge->dim() < 3) ?
+  SMetric3 m = (backgroundMesh::getLcFromCurvature() && ge->dim() < 3) ?
       intersection(m1, LC_MVertex_CURV_ANISO(ge, U, V)) : m1;
 
   return m;
@@ -454,6 +462,18 @@ bool Extend2dMeshIn3dVolumes()
   return CTX::instance()->mesh.lcExtendFromBoundary ? true : false;
 }
 
+static backgroundMesh *_current = 0;
+static double _sizeFactor = 1.0;
+static int _lcFromCurvature = -1;
+#if defined(_OPENMP)
+#pragma omp threadprivate(_current, _sizeFactor, _lcFromCurvature)
+#endif
+
+backgroundMesh *backgroundMesh::current()
+{
+  return _current;
+}
+
 void backgroundMesh::set(GFace *gf)
 {
   if (_current) delete _current;
@@ -472,7 +492,27 @@ void backgroundMesh::unset()
   _current = 0;
 }
 
-double backgroundMesh::sizeFactor = 1.0;
+void backgroundMesh::setSizeFactor(double s)
+{
+  _sizeFactor = s;
+}
+
+double backgroundMesh::getSizeFactor()
+{
+  return _sizeFactor;
+}
+
+void backgroundMesh::setLcFromCurvature(int val)
+{
+  _lcFromCurvature = val;
+}
+
+int backgroundMesh::getLcFromCurvature()
+{
+  return (_lcFromCurvature < 0) ? CTX::instance()->mesh.lcFromCurvature :
+    _lcFromCurvature;
+}
+
 backgroundMesh::backgroundMesh(GFace *_gf, bool cfd)
 #if defined(HAVE_ANN)
   : _octree(0), uv_kdtree(0), nodes(0), angle_nodes(0), angle_kdtree(0)
@@ -837,21 +877,21 @@ void backgroundMesh::updateSizes(GFace *_gf)
     MVertex *v = _2Dto3D[itv->first];
     double lc;
     if (v->onWhat()->dim() == 0){
-      lc = sizeFactor * BGM_MeshSize(v->onWhat(), 0,0,v->x(),v->y(),v->z());
+      lc = _sizeFactor * BGM_MeshSize(v->onWhat(), 0,0,v->x(),v->y(),v->z());
     }
     else if (v->onWhat()->dim() == 1){
       double u;
       v->getParameter(0, u);
-      lc = sizeFactor * BGM_MeshSize(v->onWhat(), u, 0, v->x(), v->y(), v->z());
+      lc = _sizeFactor * BGM_MeshSize(v->onWhat(), u, 0, v->x(), v->y(), v->z());
     }
     else{
       reparamMeshVertexOnFace(v, _gf, p);
-      lc = sizeFactor * BGM_MeshSize(_gf, p.x(), p.y(), v->x(), v->y(), v->z());
+      lc = _sizeFactor * BGM_MeshSize(_gf, p.x(), p.y(), v->x(), v->y(), v->z());
     }
     // printf("2D -- %g %g 3D -- %g %g\n",p.x(),p.y(),v->x(),v->y());
     itv->second = std::min(lc,itv->second);
-    itv->second = std::max(itv->second,  sizeFactor * CTX::instance()->mesh.lcMin);
-    itv->second = std::min(itv->second,  sizeFactor * CTX::instance()->mesh.lcMax);
+    itv->second = std::max(itv->second,  _sizeFactor * CTX::instance()->mesh.lcMin);
+    itv->second = std::min(itv->second,  _sizeFactor * CTX::instance()->mesh.lcMax);
   }
   // do not allow large variations in the size field
   // (Int. J. Numer. Meth. Engng. 43, 1143-1165 (1998) MESH GRADATION
@@ -1025,4 +1065,3 @@ MElement *backgroundMesh::getMeshElementByCoord(double u, double v, double w, bo
   return _octree->find(u,v,w, 2, strict);
 }
 
-backgroundMesh* backgroundMesh::_current = 0;
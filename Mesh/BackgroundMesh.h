@@ -41,7 +41,6 @@ struct crossField2d
 
 class backgroundMesh : public simpleFunction<double>
 {
-  static double sizeFactor;
   MElementOctree *_octree;
   std::vector<MVertex*> _vertices;
   std::vector<MElement*> _triangles;
@@ -50,7 +49,6 @@ class backgroundMesh : public simpleFunction<double>
   std::map<MVertex*,MVertex*> _2Dto3D;
   std::map<MVertex*,double> _distance;  
   std::map<MVertex*,double> _angles;  
-  static backgroundMesh * _current;
   backgroundMesh(GFace *, bool dist = false);
   ~backgroundMesh();
 #if defined(HAVE_ANN)
@@ -66,8 +64,16 @@ class backgroundMesh : public simpleFunction<double>
   static void set(GFace *);
   static void setCrossFieldsByDistance(GFace *);
   static void unset();
-  static backgroundMesh *current () { return _current; }
-  static void setSizeFactor (double s) {sizeFactor = s;}
+  // the current background mesh, the size factor and the curvature control
+  // flag are private to each thread, so that different faces can be meshed
+  // concurrently
+  static backgroundMesh *current();
+  static void setSizeFactor(double s);
+  static double getSizeFactor();
+  // overrides Mesh.CharacteristicLengthFromCurvature for the calling thread
+  // (-1 restores the global value)
+  static void setLcFromCurvature(int val);
+  static int getLcFromCurvature();
   void propagate1dMesh(GFace *);
   void propagateCrossField(GFace *);
   void propagateCrossFieldByDistance(GFace *);
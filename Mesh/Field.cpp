@@ -47,6 +47,14 @@ Field::~Field()
     delete it->second;
 }
 
+void Field::operator() (const std::vector<SPoint3> &points,
+                         std::vector<double> &values, GEntity *ge)
+{
+  values.resize(points.size());
+  for(unsigned int i = 0; i < points.size(); i++)
+    values[i] = (*this)(points[i].x(), points[i].y(), points[i].z(), ge);
+}
+
 FieldOption *Field::getOption(const std::string optionName)
 {
   std::map<std::string, FieldOption*>::iterator it = options.find(optionName);
@@ -989,6 +997,31 @@ class MathEvalExpression
     else
       return MAX_LC;
   }
+  void evaluate(const std::vector<SPoint3> &points, std::vector<double> &res)
+  {
+    if(!_f){
+      res.assign(points.size(), MAX_LC);
+      return;
+    }
+    std::vector<std::vector<double> > values(3 + _fields.size()), r;
+    for(int j = 0; j < 3; j++) values[j].resize(points.size());
+    for(unsigned int k = 0; k < points.size(); k++){
+      values[0][k] = points[k].x();
+      values[1][k] = points[k].y();
+      values[2][k] = points[k].z();
+    }
+    int i = 3;
+    for(std::set<int>::iterator it = _fields.begin(); it != _fields.end(); it++){
+      Field *field = GModel::current()->getFields()->get(*it);
+      if(field) (*field)(points, values[i]);
+      else values[i].assign(points.size(), MAX_LC);
+      i++;
+    }
+    if(_f->eval(values, r) && r.size() == 1)
+      res.swap(r[0]);
+    else
+      res.assign(points.size(), MAX_LC);
+  }
 };
 
 class MathEvalExpressionAniso
@@ -1097,6 +1130,17 @@ class MathEvalField : public Field
     }
     return expr.evaluate(x, y, z);
   }
+  void operator() (const std::vector<SPoint3> &points,
+                   std::vector<double> &values, GEntity *ge=0)
+  {
+    if(update_needed) {
+      if(!expr.set_function(f))
+        Msg::Error("Field %i: Invalid matheval expression \"%s\"",
+                   this->id, f.c_str());
+      update_needed = false;
+    }
+    expr.evaluate(points, values);
+  }
   const char *getName()
   {
     return "MathEval";
@@ -1228,6 +1272,34 @@ class PostViewField : public Field
   OctreePost *octree;
   int view_index;
   bool crop_negative_values;
+  // small direct-mapped cache of the last values computed by the isotropic
+  // evaluation, indexed by a hash of the coordinates: the mesh size is often
+  // evaluated repeatedly at the same (boundary) vertices
+  struct cacheEntry {
+    double x, y, z, value;
+    bool valid;
+  };
+  std::vector<cacheEntry> cache;
+  cacheEntry &getCacheEntry(double x, double y, double z)
+  {
+    double c[3] = {x, y, z};
+    unsigned int h = 2166136261u;
+    const unsigned char *b = (const unsigned char*)c;
+    for(unsigned int i = 0; i < sizeof(c); i++) h = (h ^ b[i]) * 16777619u;
+    return cache[h % cache.size()];
+  }
+  bool update()
+  {
+    PView *v = getView();
+    if(!v) return false;
+    if(update_needed || !octree){
+      if(octree) delete octree;
+      octree = new OctreePost(v);
+      cache.assign(4093, cacheEntry());
+      update_needed = false;
+    }
+    return true;
+  }
  public:
   PostViewField()
   {
@@ -1268,30 +1340,37 @@ class PostViewField : public Field
   }
   double operator() (double x, double y, double z, GEntity *ge=0)
   {
-    PView *v = getView();
-    if(!v) return MAX_LC;
-    if(update_needed){
-      if(octree) delete octree;
-      octree = new OctreePost(v);
-      update_needed = false;
-    }
+    if(!update()) return MAX_LC;
+    cacheEntry &c = getCacheEntry(x, y, z);
+    if(c.valid && c.x == x && c.y == y && c.z == z) return c.value;
     double l = 0.;
     // use large tolerance (in element reference coordinates) to maximize chance
     // of finding an element
     if(!octree->searchScalarWithTol(x, y, z, &l, 0, 0, 0.05))
       Msg::Info("No scalar element found containing point (%g,%g,%g)", x, y, z);
-    if(l <= 0 && crop_negative_values) return MAX_LC;
+    if(l <= 0 && crop_negative_values) l = MAX_LC;
+    c.x = x; c.y = y; c.z = z; c.value = l; c.valid = true;
     return l;
   }
-  void operator() (double x, double y, double z, SMetric3 &metr, GEntity *ge=0)
+  void operator() (const std::vector<SPoint3> &points,
+                   std::vector<double> &values, GEntity *ge=0)
   {
-    PView *v = getView();
-    if(!v) return;
-    if(update_needed){
-      if(octree) delete octree;
-      octree = new OctreePost(v);
-      update_needed = false;
+    if(!update()){
+      values.assign(points.size(), MAX_LC);
+      return;
     }
+    std::vector<int> found;
+    int n = octree->searchScalar(points, values, 0, &found, 0.05);
+    if(n < (int)points.size())
+      Msg::Info("No scalar element found containing %d point(s)",
+                (int)points.size() - n);
+    if(crop_negative_values)
+      for(unsigned int i = 0; i < values.size(); i++)
+        if(values[i] <= 0) values[i] = MAX_LC;
+  }
+  void operator() (double x, double y, double z, SMetric3 &metr, GEntity *ge=0)
+  {
+    if(!update()) return;
     double l[9] = {0., 0., 0., 0., 0., 0., 0., 0., 0.};
     // use large tolerance (in element reference coordinates) to maximize chance
     // of finding an element
@@ -2341,6 +2420,41 @@ void FieldManager::setBackgroundField(Field* BGF)
   _background_field = id;
 }
 
+bool Field::gatherStatistics()
+{
+  return Msg::GetVerbosity() >= 99;
+}
+
+void Field::addEvaluation(double time)
+{
+#if defined(_OPENMP)
+#pragma omp atomic
+#endif
+  numEvaluations++;
+#if defined(_OPENMP)
+#pragma omp atomic
+#endif
+  evaluationTime += time;
+}
+
+void FieldManager::resetStatistics()
+{
+  for(iterator it = begin(); it != end(); ++it){
+    it->second->numEvaluations = 0;
+    it->second->evaluationTime = 0.;
+  }
+}
+
+void FieldManager::printStatistics()
+{
+  for(iterator it = begin(); it != end(); ++it){
+    Field *f = it->second;
+    if(f->numEvaluations)
+      Msg::Info("Field %d (%s): %lld evaluations in %g s", it->first,
+                f->getName(), f->numEvaluations, f->evaluationTime);
+  }
+}
+
 void Field::putOnNewView()
 {
 #if defined(HAVE_POST)
@@ -2352,10 +2466,15 @@ void Field::putOnNewView()
   std::vector<GEntity*> entities;
   GModel::current()->getEntities(entities);
   for(unsigned int i = 0; i < entities.size(); i++){
+    std::vector<SPoint3> points;
+    std::vector<double> values;
     for(unsigned int j = 0; j < entities[i]->mesh_vertices.size(); j++){
       MVertex *v = entities[i]->mesh_vertices[j];
-      d[v->getNum()].push_back((*this)(v->x(), v->y(), v->z(), entities[i]));
+      points.push_back(SPoint3(v->x(), v->y(), v->z()));
     }
+    (*this)(points, values, entities[i]);
+    for(unsigned int j = 0; j < entities[i]->mesh_vertices.size(); j++)
+      d[entities[i]->mesh_vertices[j]->getNum()].push_back(values[j]);
   }
   std::ostringstream oss;
   oss << "Field " << id;
@@ -2368,13 +2487,26 @@ void Field::putOnNewView()
 void Field::putOnView(PView *view, int comp)
 {
   PViewData *data = view->getData();
+  // evaluate the field at all the nodes at once
+  std::vector<SPoint3> points;
   for(int ent = 0; ent < data->getNumEntities(0); ent++){
     for(int ele = 0; ele < data->getNumElements(0, ent); ele++){
       if(data->skipElement(0, ent, ele)) continue;
       for(int nod = 0; nod < data->getNumNodes(0, ent, ele); nod++){
         double x, y, z;
         data->getNode(0, ent, ele, nod, x, y, z);
-        double val = (*this)(x, y, z);
+        points.push_back(SPoint3(x, y, z));
+      }
+    }
+  }
+  std::vector<double> values;
+  (*this)(points, values);
+  int i = 0;
+  for(int ent = 0; ent < data->getNumEntities(0); ent++){
+    for(int ele = 0; ele < data->getNumElements(0, ent); ele++){
+      if(data->skipElement(0, ent, ele)) continue;
+      for(int nod = 0; nod < data->getNumNodes(0, ent, ele); nod++){
+        double val = values[i++];
         for(int comp = 0; comp < data->getNumComponents(0, ent, ele); comp++)
           data->setValue(0, ent, ele, nod, comp, val);
       }
@@ -9,8 +9,10 @@
 #include <string>
 #include <map>
 #include <list>
+#include <vector>
 #include "GmshConfig.h"
 #include "STensor3.h"
+#include "SPoint3.h"
 #include <fstream>
 #include <string>
 #include <string.h>
@@ -76,7 +78,7 @@ class FieldOption {
 
 class Field {
  public:
-  Field() {}
+  Field() : numEvaluations(0), evaluationTime(0.) {}
   virtual ~Field();
   int id;
   std::map<std::string, FieldOption *> options;
@@ -86,11 +88,21 @@ class Field {
   virtual double operator() (double x, double y, double z, GEntity *ge=0) = 0;
   // anisotropic
   virtual void operator() (double x, double y, double z, SMetric3 &, GEntity *ge=0){}
+  // isotropic, evaluated at a batch of points
+  virtual void operator() (const std::vector<SPoint3> &points,
+                           std::vector<double> &values, GEntity *ge=0);
 
   //temporary
   virtual void operator()(double x,double y,double z,SVector3& v1,SVector3& v2,SVector3& v3,GEntity* ge=0){}
 
   bool update_needed;
+  // evaluation statistics, gathered when the field is used as the background
+  // field during meshing, only in debug mode (verbosity >= 99) since timing
+  // each evaluation is costly; addEvaluation can be called concurrently
+  long long numEvaluations;
+  double evaluationTime;
+  void addEvaluation(double time);
+  static bool gatherStatistics();
   //void update(){ printf("up f \n"); return;}
   virtual const char *getName() = 0;
 #if defined(HAVE_POST)
@@ -129,6 +141,9 @@ class FieldManager : public std::map<int, Field*> {
   inline void setBoundaryLayerFieldId(int id){_boundaryLayer_field = id;};
   inline int getBackgroundField(){return _background_field;}
   inline int getBoundaryLayerField(){return _boundaryLayer_field;}
+  // reset and print the evaluation statistics of the background field
+  void resetStatistics();
+  void printStatistics();
 };
 
 // Boundary Layer Field (used both for anisotropic meshing and BL
@@ -19,6 +19,7 @@
 #include "MHexahedron.h"
 #include "MPrism.h"
 #include "MPyramid.h"
+#include "MEntityPool.h"
 #include "meshGEdge.h"
 #include "meshGFace.h"
 #include "meshGFaceOptimize.h"
@@ -331,6 +332,37 @@ static void PrintMesh2dStatistics(GModel *m)
   fclose(statreport);
 }
 
+// Renumbers the mesh vertices created since maxVertexNum in the order of the
+// model entities, so that the numbering of the vertices created while meshing
+// surfaces in parallel does not depend on the scheduling of the threads
+static void RenumberNewMeshVertices(GModel *m, int maxVertexNum)
+{
+  std::vector<GEntity*> entities;
+  m->getEntities(entities);
+  int num = maxVertexNum;
+  for(unsigned int i = 0; i < entities.size(); i++){
+    std::vector<MVertex*> &v = entities[i]->mesh_vertices;
+    for(unsigned int j = 0; j < v.size(); j++)
+      if(v[j]->getNum() > maxVertexNum) v[j]->forceNum(++num);
+  }
+  m->setMaxVertexNumber(num);
+}
+
+// Same for the mesh elements created since maxElementNum
+static void RenumberNewMeshElements(GModel *m, int maxElementNum)
+{
+  std::vector<GEntity*> entities;
+  m->getEntities(entities);
+  int num = maxElementNum;
+  for(unsigned int i = 0; i < entities.size(); i++){
+    for(unsigned int j = 0; j < entities[i]->getNumMeshElements(); j++){
+      MElement *e = entities[i]->getMeshElement(j);
+      if(e->getNum() > maxElementNum) e->forceNum(++num);
+    }
+  }
+  m->setMaxElementNumber(num);
+}
+
 static void Mesh2D(GModel *m)
 {
   if(TooManyElements(m, 2)) return;
@@ -353,17 +385,29 @@ static void Mesh2D(GModel *m)
 
     Msg::ResetProgressMeter();
 
+    // each thread has its own background mesh, so that faces can be meshed
+    // concurrently; mesh size fields are not reentrant, though
+    int nThreads = CTX::instance()->mesh.maxNumThreads2D;
+    if(nThreads <= 0) nThreads = Msg::GetMaxThreads();
+    if(m->getFields()->getBackgroundField() > 0) nThreads = 1;
+
     int nIter = 0, nTot = m->getNumFaces();
     while(1){
       int nPending = 0;
+      int maxVertexNum = m->getMaxVertexNumber();
+      int maxElementNum = m->getMaxElementNumber();
       std::vector<GFace*> temp;
       temp.insert(temp.begin(), f.begin(), f.end());
 #if defined(_OPENMP)
-#pragma omp parallel for schedule (dynamic)
+#pragma omp parallel num_threads(nThreads)
+#endif
+      {
+#if defined(_OPENMP)
+#pragma omp for schedule (dynamic)
 #endif
       for(size_t K = 0 ; K < temp.size() ; K++){
 	if (temp[K]->meshStatistics.status == GFace::PENDING){
-          backgroundMesh::current()->unset();
+          backgroundMesh::unset();
 	  meshGFace mesher(true);
 	  mesher(temp[K]);
 
@@ -392,9 +436,16 @@ static void Mesh2D(GModel *m)
 #endif
 	  {
 	    nPending++;
+            if(!nIter) Msg::ProgressMeter(nPending, nTot, false, "Meshing 2D...");
 	  }
 	}
-        if(!nIter) Msg::ProgressMeter(nPending, nTot, false, "Meshing 2D...");
+      }
+      // free the background mesh of the last face meshed by each thread
+      backgroundMesh::unset();
+      }
+      if(nThreads > 1 && temp.size() > 1){
+        RenumberNewMeshVertices(m, maxVertexNum);
+        RenumberNewMeshElements(m, maxElementNum);
       }
 #if defined(_OPENMP)
 #pragma omp master
@@ -402,7 +453,7 @@ static void Mesh2D(GModel *m)
       for(std::set<GFace*, GEntityLessThan>::iterator it = cf.begin();
           it != cf.end(); ++it){
         if ((*it)->meshStatistics.status == GFace::PENDING){
-          backgroundMesh::current()->unset();
+          backgroundMesh::unset();
           meshGFace mesher(true);
           mesher(*it);
 
@@ -433,6 +484,7 @@ static void Mesh2D(GModel *m)
       if(!nPending) break;
       if(nIter++ > 10) break;
     }
+    backgroundMesh::unset();
   }
 
   // collapseSmallEdges(*m);
@@ -617,7 +669,13 @@ void GenerateMesh(GModel *m, int ask)
   }
   CTX::instance()->lock = 1;
 
+#if defined(HAVE_MESH_POOL)
+  // allocate the new mesh in the pool of the model
+  MEntityPool::scope poolScope(m->getMeshPool());
+#endif
+
   Msg::ResetErrorCounter();
+  m->getFields()->resetStatistics();
 
   int old = m->getMeshStatus(false);
 
@@ -698,6 +756,7 @@ void GenerateMesh(GModel *m, int ask)
 
   Msg::Info("%d vertices %d elements",
             m->getNumMeshVertices(), m->getNumMeshElements());
+  m->getFields()->printStatistics();
 
   Msg::PrintErrorCounter("Mesh generation error summary");
 
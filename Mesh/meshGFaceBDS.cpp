@@ -148,7 +148,7 @@ static double correctLC_(BDS_Point *p1,BDS_Point *p2, GFace *f,
   double l2 = NewGetLc(p2);
   double l = 0.5 * (l1 + l2);
 
-  if(CTX::instance()->mesh.lcFromCurvature){
+  if(backgroundMesh::getLcFromCurvature()){
     //      GPoint GP = f->point(SPoint2(0.5 * (p1->u + p2->u) * SCALINGU,
     //                                   0.5 * (p1->v + p2->v) * SCALINGV));
     //      double l3 = BGM_MeshSize(f,GP.u(),GP.v(),GP.x(),GP.y(),GP.z());
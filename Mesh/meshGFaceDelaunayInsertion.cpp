@@ -1556,13 +1556,12 @@ void buildBackGroundMesh (GFace *gf,
     */
     // avoid computing curvatures on the fly : only on the
     // BGM computes once curvatures at each node
-    //  Disable curvature control
-    int CurvControl = CTX::instance()->mesh.lcFromCurvature;
-    CTX::instance()->mesh.lcFromCurvature = 0;
+    //  Disable curvature control (for this thread only)
+    backgroundMesh::setLcFromCurvature(0);
     //  Do a background mesh
     bowyerWatson(gf,4000, equivalence,parametricCoordinates);
     //  Re-enable curv control if asked
-    CTX::instance()->mesh.lcFromCurvature = CurvControl;
+    backgroundMesh::setLcFromCurvature(-1);
     // apply this to the BGM
     //    printf("1 end build bak mesh\n");
     backgroundMesh::set(gf);
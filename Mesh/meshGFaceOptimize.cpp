@@ -1147,8 +1147,18 @@ struct  quadBlob {
   inline void setBlobNumber(int number) { iBlob = number; }
   static void computeMatrices()
   {
-    if (matricesDone)return;
-    matricesDone = true;
+#if defined(_OPENMP)
+#pragma omp critical(quadBlobMatrices)
+#endif
+    {
+      if (!matricesDone){
+        computeMatricesOnce();
+        matricesDone = true;
+      }
+    }
+  }
+  static void computeMatricesOnce()
+  {
     M3.resize(6,6);
     M5.resize(10,10);
 
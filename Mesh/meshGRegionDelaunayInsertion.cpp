@@ -105,13 +105,16 @@ struct faceXtet{
 	    v[2] == other.v[2] );
   }
   bool visible (MVertex *v){
+    double d[3] = {v->x(),v->y(),v->z()};
+    return visible(d);
+  }
+  bool visible (double *d) const {
     MVertex* v0 = t1->tet()->getVertex(faces[i1][0]);
     MVertex* v1 = t1->tet()->getVertex(faces[i1][1]);
     MVertex* v2 = t1->tet()->getVertex(faces[i1][2]);
     double a[3] = {v0->x(),v0->y(),v0->z()};
     double b[3] = {v1->x(),v1->y(),v1->z()};
     double c[3] = {v2->x(),v2->y(),v2->z()};
-    double d[3] = {v->x(),v->y(),v->z()};
     double o = robustPredicates :: orient3d(a,b,c,d);
     return o < 0;
   }
@@ -424,12 +427,13 @@ void printTets (const char *fn, std::list<MTet4*> &cavity, bool force = false )
 }
 
 
+template <class CONTAINER>
 bool insertVertexB(std::list<faceXtet> &shell,
 		   std::list<MTet4*> &cavity,
 		   MVertex *v,
 		   MTet4 *t,
 		   MTet4Factory &myFactory,
-		   std::set<MTet4*,compareTet4Ptr> &allTets,
+		   CONTAINER &allTets,
 		   std::vector<double> & vSizes,
 		   std::vector<double> & vSizesBGM,
 		   std::set<MTet4*,compareTet4Ptr> *activeTets = 0 )
@@ -1190,20 +1194,224 @@ double tetcircumcenter(double a[3], double b[3], double c[3], double d[3],
   return xxx;
 }
 
-static void memoryCleanup(MTet4Factory &myFactory, std::set<MTet4*, compareTet4Ptr> &allTets){
-  //  int n1 = allTets.size();
-  std::set<MTet4*,compareTet4Ptr>::iterator itd = allTets.begin();
-  while(itd != allTets.end()){
-    if((*itd)->isDeleted()){
-      myFactory.Free((*itd));
-      allTets.erase(itd++);
+static void memoryCleanup(MTet4Factory &myFactory, MTet4Queue &allTets){
+  //  int n1 = myFactory.size();
+  std::vector<MTet4*> tets;
+  myFactory.getAllocatedTets(tets);
+  for (unsigned int i = 0; i < tets.size(); i++)
+    if (tets[i]->isDeleted()) myFactory.Free(tets[i]);
+  allTets.compact();
+  //  Msg::Info("cleaning up the memory %d -> %d", n1, myFactory.size());
+}
+
+
+// Parallel refinement: the circumcenters of a batch of bad tets are located
+// and their Delaunay cavities are computed concurrently (without modifying
+// the mesh), then the points are inserted one by one. A cavity is only
+// inserted if none of its tets (nor the tets adjacent to it) have been
+// modified by a previous insertion of the same batch; otherwise the bad tet
+// is kept for a later batch.
+
+struct delaunayCandidate {
+  MTet4 *worst, *tet; // bad tet, and tet containing its circumcenter
+  double center[3], uvw[3];
+  std::list<faceXtet> shell;
+  std::list<MTet4*> cavity;
+  bool found, starShaped;
+};
+
+static void recurFindCavityConst(std::list<faceXtet> &shell,
+                                 std::list<MTet4*> &cavity,
+                                 std::set<MTet4*> &visited,
+                                 double *p, MTet4 *t)
+{
+  visited.insert(t);
+  cavity.push_back(t);
+  for (int i = 0; i < 4; i++){
+    MTet4 *neigh = t->getNeigh(i);
+    faceXtet fxt (t, i);
+    if (!neigh)
+      shell.push_back(fxt);
+    else if (!neigh->isDeleted() &&
+             visited.find(neigh) == visited.end()){
+      int circ = neigh->inCircumSphere(p);
+      if (circ && (neigh->onWhat() == t->onWhat()))
+        recurFindCavityConst(shell, cavity, visited, p, neigh);
+      else
+        shell.push_back(fxt);
     }
-    else
-      itd++;
   }
-  //  Msg::Info("cleaning up the memory %d -> %d", n1, allTets.size());
 }
 
+static void computeCandidate(delaunayCandidate &c)
+{
+  MTetrahedron *base = c.worst->tet();
+  double pa[3] = {base->getVertex(0)->x(), base->getVertex(0)->y(),
+                  base->getVertex(0)->z()};
+  double pb[3] = {base->getVertex(1)->x(), base->getVertex(1)->y(),
+                  base->getVertex(1)->z()};
+  double pc[3] = {base->getVertex(2)->x(), base->getVertex(2)->y(),
+                  base->getVertex(2)->z()};
+  double pd[3] = {base->getVertex(3)->x(), base->getVertex(3)->y(),
+                  base->getVertex(3)->z()};
+  tetcircumcenter(pa, pb, pc, pd, c.center, &c.uvw[0], &c.uvw[1], &c.uvw[2]);
+
+  // the cavities are computed concurrently, so the visited tets cannot be
+  // flagged in the (shared) tets themselves
+  std::set<MTet4*> visited;
+  recurFindCavityConst(c.shell, c.cavity, visited, c.center, c.worst);
+
+  c.found = false;
+  c.tet = c.worst;
+  for (std::list<MTet4*>::iterator itc = c.cavity.begin(); itc != c.cavity.end(); ++itc){
+    MTetrahedron *t = (*itc)->tet();
+    t->xyz2uvw(c.center, c.uvw);
+    if (t->isInside(c.uvw[0], c.uvw[1], c.uvw[2])){
+      c.tet = *itc;
+      c.found = true;
+      break;
+    }
+  }
+
+  c.starShaped = true;
+  for (std::list<faceXtet>::iterator it = c.shell.begin(); it != c.shell.end(); ++it){
+    if (!it->visible(c.center)){
+      c.starShaped = false;
+      break;
+    }
+  }
+}
+
+static bool isModified(MTet4 *t, std::set<MTet4*> &modified)
+{
+  return t->isDeleted() || modified.find(t) != modified.end();
+}
+
+static bool cavityIsModified(std::list<faceXtet> &shell, std::list<MTet4*> &cavity,
+                             std::set<MTet4*> &modified)
+{
+  for (std::list<MTet4*>::iterator it = cavity.begin(); it != cavity.end(); ++it)
+    if (isModified(*it, modified)) return true;
+  for (std::list<faceXtet>::iterator it = shell.begin(); it != shell.end(); ++it){
+    MTet4 *otherSide = it->t1->getNeigh(it->i1);
+    if (otherSide && isModified(otherSide, modified)) return true;
+  }
+  return false;
+}
+
+static void insertVerticesByBatches(GRegion *gr, int maxVert, int batchSize,
+                                    MTet4Factory &myFactory, MTet4Queue &allTets,
+                                    std::vector<double> &vSizes,
+                                    std::vector<double> &vSizesBGM, int &NUM,
+                                    int &ITER, int &REALCOUNT,
+                                    int &NB_CORRECTION_OF_CAVITY,
+                                    int &COUNT_MISS_1, int &COUNT_MISS_2)
+{
+  std::vector<delaunayCandidate> candidates(batchSize);
+  int nextInfo = 0;
+
+  while(1){
+    if (ITER > maxVert) break;
+    if(!allTets.top()){
+      if(!myFactory.size())
+        Msg::Error("No tetrahedra in region %d", gr->tag());
+      break;
+    }
+    if(ITER >= nextInfo){
+      Msg::Info("%d points created - Worst tet radius is %g (PTS removed %d %d)",
+                REALCOUNT, allTets.top()->getRadius(), COUNT_MISS_1,
+                COUNT_MISS_2);
+      nextInfo += 5000;
+    }
+
+    // select the worst tets
+    int n = 0;
+    while(n < batchSize){
+      MTet4 *worst = allTets.top();
+      if(!worst || worst->getRadius() < 1) break;
+      allTets.pop();
+      delaunayCandidate &c = candidates[n++];
+      c.worst = worst;
+      c.shell.clear();
+      c.cavity.clear();
+    }
+    if(!n) break;
+
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic)
+#endif
+    for(int i = 0; i < n; i++)
+      computeCandidate(candidates[i]);
+
+    std::set<MTet4*> modified;
+    for(int i = 0; i < n; i++){
+      delaunayCandidate &c = candidates[i];
+      // cavities that need to be corrected are only inserted in an unmodified
+      // mesh, as they can grow beyond the tets that have been checked
+      if(cavityIsModified(c.shell, c.cavity, modified) ||
+         (!c.starShaped && modified.size())){
+        if(!c.worst->isDeleted()) allTets.push(c.worst);
+        continue;
+      }
+      ITER++;
+      for (std::list<MTet4*>::iterator itc = c.cavity.begin(); itc != c.cavity.end(); ++itc)
+        (*itc)->setDeleted(true);
+
+      if(!c.found){
+        c.worst->forceRadius(0.0);
+        COUNT_MISS_2++;
+        for (std::list<MTet4*>::iterator itc = c.cavity.begin(); itc != c.cavity.end(); ++itc)
+          (*itc)->setDeleted(false);
+        continue;
+      }
+
+      MVertex *v = new MVertex(c.center[0], c.center[1], c.center[2], c.tet->onWhat());
+      v->setIndex(NUM++);
+      bool starShaped = true;
+      bool correctCavity = false;
+      while (!c.starShaped){
+        int k = makeCavityStarShaped (c.shell, c.cavity, v);
+        if (k == -1){starShaped = false ; break;}
+        else if (k == 0) break;
+        else if (k == 1) correctCavity = true;
+      }
+      if (correctCavity && starShaped) NB_CORRECTION_OF_CAVITY ++;
+
+      double lc1 =
+        (1 - c.uvw[0] - c.uvw[1] - c.uvw[2]) * vSizes[c.tet->tet()->getVertex(0)->getIndex()] +
+        c.uvw[0] * vSizes[c.tet->tet()->getVertex(1)->getIndex()] +
+        c.uvw[1] * vSizes[c.tet->tet()->getVertex(2)->getIndex()] +
+        c.uvw[2] * vSizes[c.tet->tet()->getVertex(3)->getIndex()];
+      double lc = BGM_MeshSize(gr, 0, 0, c.center[0], c.center[1], c.center[2]);
+      vSizes.push_back(lc1);
+      vSizesBGM.push_back(lc);
+
+      // the tets adjacent to the cavity are reconnected by the insertion
+      std::vector<MTet4*> otherSides;
+      for (std::list<faceXtet>::iterator it = c.shell.begin(); it != c.shell.end(); ++it)
+        if (it->t1->getNeigh(it->i1)) otherSides.push_back(it->t1->getNeigh(it->i1));
+
+      if(!starShaped || !insertVertexB(c.shell, c.cavity, v, c.tet, myFactory,
+                                       allTets, vSizes, vSizesBGM)){
+        COUNT_MISS_1++;
+        c.worst->forceRadius(0.);
+        for (std::list<MTet4*>::iterator itc = c.cavity.begin(); itc != c.cavity.end(); ++itc)
+          (*itc)->setDeleted(false);
+        delete v;
+      }
+      else{
+        REALCOUNT++;
+        v->onWhat()->mesh_vertices.push_back(v);
+        modified.insert(c.cavity.begin(), c.cavity.end());
+        modified.insert(otherSides.begin(), otherSides.end());
+      }
+    }
+
+    if(myFactory.size() > 7 * (int)vSizes.size() && ITER > 1000){
+      memoryCleanup(myFactory, allTets);
+    }
+  }
+}
 
 void insertVerticesInRegion (GRegion *gr, int maxVert, bool _classify)
 {
@@ -1213,8 +1421,8 @@ void insertVerticesInRegion (GRegion *gr, int maxVert, bool _classify)
 
   std::vector<double> vSizes;
   std::vector<double> vSizesBGM;
-  MTet4Factory myFactory(1600000);
-  std::set<MTet4*, compareTet4Ptr> &allTets = myFactory.getAllTets();
+  MTet4Factory myFactory;
+  std::vector<MTet4*> allTets;
   int NUM = 0;
 
 
@@ -1239,7 +1447,7 @@ void insertVerticesInRegion (GRegion *gr, int maxVert, bool _classify)
 
   for(unsigned int i = 0; i < gr->tetrahedra.size(); i++){
     gr->tetrahedra[i]->setVolumePositive();
-    allTets.insert(myFactory.Create(gr->tetrahedra[i], vSizes,vSizesBGM));
+    allTets.push_back(myFactory.Create(gr->tetrahedra[i], vSizes,vSizesBGM));
   }
 
   gr->tetrahedra.clear();
@@ -1252,7 +1460,7 @@ void insertVerticesInRegion (GRegion *gr, int maxVert, bool _classify)
   if (_classify) {
     fs_cont search;
     buildFaceSearchStructure(gr->model(), search);
-    for(MTet4Factory::iterator it = allTets.begin(); it != allTets.end(); ++it){
+    for(std::vector<MTet4*>::iterator it = allTets.begin(); it != allTets.end(); ++it){
       if(!(*it)->onWhat()){
 	//	printf("I'm in coucou\n");
 	std::list<MTet4*> theRegion;
@@ -1279,11 +1487,11 @@ void insertVerticesInRegion (GRegion *gr, int maxVert, bool _classify)
   }
   else {
     // FIXME ... too simple
-    for(MTet4Factory::iterator it = allTets.begin(); it != allTets.end(); ++it)
+    for(std::vector<MTet4*>::iterator it = allTets.begin(); it != allTets.end(); ++it)
       (*it)->setOnWhat(gr);
   }
 
-  for(MTet4Factory::iterator it = allTets.begin(); it!=allTets.end(); ++it){
+  for(std::vector<MTet4*>::iterator it = allTets.begin(); it!=allTets.end(); ++it){
     (*it)->setNeigh(0, 0);
     (*it)->setNeigh(1, 0);
     (*it)->setNeigh(2, 0);
@@ -1297,31 +1505,38 @@ void insertVerticesInRegion (GRegion *gr, int maxVert, bool _classify)
 
   // here the classification should be done
 
+  MTet4Queue worstTets;
+  worstTets.insert(allTets.begin(), allTets.end());
+  std::vector<MTet4*>().swap(allTets);
+
   int ITER = 0, REALCOUNT = 0;
   int NB_CORRECTION_OF_CAVITY = 0;
   int COUNT_MISS_1 = 0;
   int COUNT_MISS_2 = 0;
 
   double t1 = Cpu();
-  while(1){
+  int batchSize = CTX::instance()->mesh.delaunayBatchSize3d * Msg::GetMaxThreads();
+  if(batchSize > 0)
+    insertVerticesByBatches(gr, maxVert, batchSize, myFactory, worstTets, vSizes,
+                            vSizesBGM,
+                            NUM, ITER, REALCOUNT, NB_CORRECTION_OF_CAVITY,
+                            COUNT_MISS_1, COUNT_MISS_2);
+  while(batchSize <= 0){
     //    break;
     if (ITER > maxVert)break;
-    if(allTets.empty()){
-      Msg::Error("No tetrahedra in region %d %d", gr->tag(), allTets.size());
+    MTet4 *worst = worstTets.top();
+    if(!worst){
+      if(!myFactory.size())
+        Msg::Error("No tetrahedra in region %d", gr->tag());
       break;
     }
-
-    MTet4 *worst = *allTets.begin();
-
-    if(worst->isDeleted()){
-      myFactory.Free(worst);
-      allTets.erase(allTets.begin());
-    }
     else{
       if(ITER++ % 5000 == 0)
         Msg::Info("%d points created - Worst tet radius is %g (PTS removed %d %d)",
                  REALCOUNT, worst->getRadius(), COUNT_MISS_1,COUNT_MISS_2);
       if(worst->getRadius() < 1) break;
+      worstTets.pop();
+      MTet4 *worstTet = worst;
       double center[3];
       double uvw[3];
       MTetrahedron *base = worst->tet();
@@ -1387,10 +1602,10 @@ void insertVerticesInRegion (GRegion *gr, int maxVert, bool _classify)
         vSizes.push_back(lc1);
         vSizesBGM.push_back(lc);
         // compute mesh spacing there
-        if(!starShaped || !insertVertexB(shell,cavity,v, worst, myFactory, allTets, vSizes,vSizesBGM)){
+        if(!starShaped || !insertVertexB(shell,cavity,v, worst, myFactory, worstTets, vSizes,vSizesBGM)){
 	  COUNT_MISS_1++;
 	  //	  printf("coucou 1 %d\n",ITER);
-          myFactory.changeTetRadius(allTets.begin(), 0.);
+          worstTet->forceRadius(0.);
 	  for (std::list<MTet4*>::iterator itc = cavity.begin(); itc != cavity.end(); ++itc)
 	    (*itc)->setDeleted(false);
           delete v;
@@ -1407,7 +1622,7 @@ void insertVerticesInRegion (GRegion *gr, int maxVert, bool _classify)
 	//	  toto->xyz2uvw(center,uvw);
 	//	  printf("point outside %12.5E %12.5E %12.5E %12.5E\n",uvw[0], uvw[1], uvw[2],1-uvw[0]-uvw[1]-uvw[2]);
 	//	}
-        myFactory.changeTetRadius(allTets.begin(), 0.0);
+        worstTet->forceRadius(0.0);
 	COUNT_MISS_2++;
 	for (std::list<MTet4*>::iterator itc = cavity.begin(); itc != cavity.end(); ++itc)  (*itc)->setDeleted(false);
 	//	if (cavity.size() > 10)printTets ("cavity.pos", cavity, true);
@@ -1417,12 +1632,13 @@ void insertVerticesInRegion (GRegion *gr, int maxVert, bool _classify)
     // Normally, a tet mesh contains about 6 times more tets than
     // vertices. This allows to clean up the set of tets when lots of
     // deleted ones are present in the mesh
-    if(allTets.size() > 7 * vSizes.size() && ITER > 1000){
-      memoryCleanup(myFactory, allTets);
+    if(myFactory.size() > 7 * (int)vSizes.size() && ITER > 1000){
+      memoryCleanup(myFactory, worstTets);
     }
   }
 
-  memoryCleanup(myFactory, allTets);
+  memoryCleanup(myFactory, worstTets);
+  myFactory.getAllocatedTets(allTets);
   double t2 = Cpu();
   double dt = (t2-t1);
   int COUNT_MISS = COUNT_MISS_1+COUNT_MISS_2;
@@ -1438,7 +1654,7 @@ void insertVerticesInRegion (GRegion *gr, int maxVert, bool _classify)
   // relocate vertices
   int nbReloc = 0;
   for (int SM=0;SM<CTX::instance()->mesh.nbSmoothing;SM++){
-    for(MTet4Factory::iterator it = allTets.begin(); it != allTets.end(); ++it){
+    for(std::vector<MTet4*>::iterator it = allTets.begin(); it != allTets.end(); ++it){
       if (!(*it)->isDeleted()){
 	double qq = (*it)->getQuality();
 	if (qq < .4)
@@ -1449,15 +1665,12 @@ void insertVerticesInRegion (GRegion *gr, int maxVert, bool _classify)
     }
   }
 
-  while(1){
-    if(allTets.begin() == allTets.end()) break;
-    MTet4 *worst = *allTets.begin();
-    if(!worst->isDeleted()){
-      worst->onWhat()->tetrahedra.push_back(worst->tet());
-      worst->tet() = 0;
+  for(std::vector<MTet4*>::iterator it = allTets.begin(); it != allTets.end(); ++it){
+    if(!(*it)->isDeleted()){
+      (*it)->onWhat()->tetrahedra.push_back((*it)->tet());
+      (*it)->tet() = 0;
     }
-    myFactory.Free(worst);
-    allTets.erase(allTets.begin());
+    myFactory.Free(*it);
   }
 }
 
@@ -1500,7 +1713,7 @@ void bowyerWatsonFrontalLayers(GRegion *gr, bool hex)
 {
   std::vector<double> vSizes;
   std::vector<double> vSizesBGM;
-  MTet4Factory myFactory(1600000);
+  MTet4Factory myFactory;
   std::set<MTet4*, compareTet4Ptr> &allTets = myFactory.getAllTets();
   std::set<MTet4*, compareTet4Ptr> activeTets;
   int NUM = 0;
@@ -10,13 +10,14 @@
 #include <set>
 #include <map>
 #include <stack>
+#include <vector>
+#include <algorithm>
 #include "MTetrahedron.h"
 #include "Numeric.h"
 #include "BackgroundMesh.h"
 #include "qualityMeasures.h"
 #include "robustPredicates.h"
 
-//#define _GMSH_PRE_ALLOCATE_STRATEGY_ 1
 class GRegion;
 class GFace;
 class GModel;
@@ -192,6 +193,7 @@ class compareTet4Ptr
   }
 };
 
+// Allocates the tets by blocks, and reuses the slots of the freed tets
 class MTet4Factory
 {
  public:
@@ -199,62 +201,56 @@ class MTet4Factory
   typedef container::iterator iterator;
  private:
   container allTets;
-#ifdef _GMSH_PRE_ALLOCATE_STRATEGY_
-  MTet4* allSlots;
-  int s_last, s_alloc;
-  std::stack<MTet4*> emptySlots;
-  inline MTet4 *getANewSlot()
-  {
-    if (s_last >= s_alloc) return 0;
-    MTet4 * t  = &(allSlots[s_last]);
-    s_last++;
-    return t;
-  }
+  std::vector<MTet4*> allBlocks;
+  std::vector<MTet4*> emptySlots;
+  int blockSize, lastInBlock, numAllocated;
   inline MTet4 *getAnEmptySlot()
   {
+    numAllocated++;
     if(!emptySlots.empty()){
-      MTet4* t = emptySlots.top();
-      emptySlots.pop();
+      MTet4 *t = emptySlots.back();
+      emptySlots.pop_back();
       return t;
     }
-    return getANewSlot();
-  };    
-#endif
- public :
-  MTet4Factory(int _size = 1000000)
-  {
-#ifdef _GMSH_PRE_ALLOCATE_STRATEGY_
-    s_last = 0; s_alloc = _size;
-    allSlots = new MTet4[s_alloc];
-#endif
+    if(allBlocks.empty() || lastInBlock == blockSize){
+      allBlocks.push_back(new MTet4[blockSize]);
+      lastInBlock = 0;
+    }
+    return &allBlocks.back()[lastInBlock++];
   }
-  ~MTet4Factory() 
+ public :
+  MTet4Factory(int _blockSize = 65536)
+    : blockSize(_blockSize), lastInBlock(0), numAllocated(0) {}
+  ~MTet4Factory()
   {
-#ifdef _GMSH_PRE_ALLOCATE_STRATEGY_
-    delete [] allSlots;
-#endif
+    for(unsigned int i = 0; i < allBlocks.size(); i++) delete [] allBlocks[i];
   }
-  MTet4 *Create(MTetrahedron * t, std::vector<double> &sizes, 
+  MTet4 *Create(MTetrahedron * t, std::vector<double> &sizes,
                 std::vector<double> &sizesBGM)
   {
-#ifdef _GMSH_PRE_ALLOCATE_STRATEGY_
     MTet4 *t4 = getAnEmptySlot();
-#else
-    MTet4 *t4 = new MTet4;
-#endif
     t4->setup(t, sizes, sizesBGM);
+    t4->setOnWhat(0);
     return t4;
   }
   void Free(MTet4 *t)
   {
     if (t->tet()) delete t->tet();
     t->tet() = 0;
-#ifdef _GMSH_PRE_ALLOCATE_STRATEGY_
-    emptySlots.push(t);
     t->setDeleted(true);
-#else
-    delete t;
-#endif
+    emptySlots.push_back(t);
+    numAllocated--;
+  }
+  // number of tets created and not freed (deleted or not)
+  int size() const { return numAllocated; }
+  // get the tets created and not freed (deleted or not), in memory order
+  void getAllocatedTets(std::vector<MTet4*> &tets)
+  {
+    for(unsigned int i = 0; i < allBlocks.size(); i++){
+      int n = (i + 1 < allBlocks.size()) ? blockSize : lastInBlock;
+      for(int j = 0; j < n; j++)
+        if(allBlocks[i][j].tet()) tets.push_back(&allBlocks[i][j]);
+    }
   }
   void changeTetRadius(iterator it, double r)
   {
@@ -266,6 +262,60 @@ class MTet4Factory
   container &getAllTets(){ return allTets; }
 };
 
+// Priority queue of the tets to refine, sorted like compareTet4Ptr. Tets are
+// not removed from the queue when they are deleted or when their radius
+// changes: these outdated entries are skipped when they reach the top.
+class MTet4Queue
+{
+ private:
+  struct entry {
+    double radius;
+    MTet4 *t;
+    bool operator < (const entry &other) const
+    {
+      if (radius < other.radius) return true;
+      if (radius > other.radius) return false;
+      return t > other.t;
+    }
+    bool outdated() const { return t->isDeleted() || t->getRadius() != radius; }
+  };
+  std::vector<entry> heap;
+ public:
+  void push(MTet4 *t)
+  {
+    entry e = {t->getRadius(), t};
+    heap.push_back(e);
+    std::push_heap(heap.begin(), heap.end());
+  }
+  template <class ITER> void insert(ITER beg, ITER end)
+  {
+    for (; beg != end; ++beg) push(*beg);
+  }
+  // return the worst tet (0 if there are none)
+  MTet4 *top()
+  {
+    while(!heap.empty() && heap.front().outdated()){
+      std::pop_heap(heap.begin(), heap.end());
+      heap.pop_back();
+    }
+    return heap.empty() ? 0 : heap.front().t;
+  }
+  void pop()
+  {
+    std::pop_heap(heap.begin(), heap.end());
+    heap.pop_back();
+  }
+  // remove all the outdated entries
+  void compact()
+  {
+    unsigned int n = 0;
+    for(unsigned int i = 0; i < heap.size(); i++)
+      if(!heap[i].outdated()) heap[n++] = heap[i];
+    heap.resize(n);
+    std::make_heap(heap.begin(), heap.end());
+  }
+};
+
 void optimizeMesh(GRegion *gr, const qualityMeasure4Tet &qm);
 
 #endif
@@ -230,6 +230,11 @@ int RenumberMeshElements(std::vector<MElement*> &elements, meshPartitionOptions
 
 int RenumberMesh(GModel *const model, meshPartitionOptions &options)
 {
+  if(model->getCompactMesh()){
+    Msg::Error("Compact meshes cannot be renumbered");
+    return 1;
+  }
+
   for (GModel::fiter it = model->firstFace() ; it != model->lastFace() ; ++it){
     std::vector<MElement *> temp;
 
@@ -267,6 +272,11 @@ int RenumberMesh(GModel *const model, meshPartitionOptions &options)
 
 int PartitionMesh(GModel *const model, meshPartitionOptions &options)
 {
+  if(model->getCompactMesh()){
+    Msg::Error("Compact meshes cannot be partitioned");
+    return 1;
+  }
+
   Graph graph;
   BoElemGrVec boElemGrVec;
   int ier;
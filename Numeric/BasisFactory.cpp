@@ -12,22 +12,91 @@
 #include "BasisFactory.h"
 #include "MElement.h"
 
-std::map<int, nodalBasis*> BasisFactory::fs;
-std::map<int, JacobianBasis*> BasisFactory::js;
-std::map<int, MetricBasis*> BasisFactory::ms;
-BasisFactory::Cont_bezierBasis BasisFactory::bs;
-BasisFactory::Cont_gradBasis BasisFactory::gs;
+nodalBasis *BasisFactory::fs[MSH_NUM_TYPE + 1] = {0};
+JacobianBasis *BasisFactory::js[MSH_NUM_TYPE + 1] = {0};
+MetricBasis *BasisFactory::ms[MSH_NUM_TYPE + 1] = {0};
+GradientBasis *BasisFactory::gs[MSH_NUM_TYPE + 1][MAX_ORDER] = {{0}};
+BasisFactory::Cont_gradBasis BasisFactory::gsHigh;
+bezierBasis *BasisFactory::bs[TYPE_XFEM + 1][MAX_ORDER] = {{0}};
+BasisFactory::Cont_bezierBasis BasisFactory::bsHigh;
+
+// Read a slot of the tables. The bases are built outside of any lock (their
+// construction can require other bases), and are published with a single
+// pointer store once complete: the basis built first is kept, the others
+// are deleted. The flushes around the pointer read and store make sure that
+// a thread seeing a non-null pointer also sees the complete basis.
+template <class T>
+static inline T *readSlot(T *const &slot)
+{
+  T *b;
+#if defined(_OPENMP)
+#pragma omp atomic read
+#endif
+  b = slot;
+#if defined(_OPENMP)
+#pragma omp flush
+#endif
+  return b;
+}
+
+template <class T>
+static T *publishSlot(T *&slot, T *b)
+{
+  T *kept;
+#if defined(_OPENMP)
+#pragma omp flush
+#pragma omp critical(BasisFactory)
+#endif
+  {
+    kept = slot;
+    if(!kept){
+#if defined(_OPENMP)
+#pragma omp atomic write
+#endif
+      slot = b;
+      kept = b;
+    }
+  }
+  if(kept != b) delete b;
+  return kept;
+}
+
+template <class T>
+static T *findOrPublish(std::map<std::pair<int, int>, T*> &m,
+                        const std::pair<int, int> &key, T *b)
+{
+  T *kept = 0;
+#if defined(_OPENMP)
+#pragma omp critical(BasisFactory)
+#endif
+  {
+    typename std::map<std::pair<int, int>, T*>::iterator it = m.find(key);
+    if(it != m.end())
+      kept = it->second;
+    else if(b)
+      kept = m[key] = b;
+  }
+  if(b && kept != b) delete b;
+  return kept;
+}
+
+static bool validTag(int tag)
+{
+  if(tag < 0 || tag > MSH_NUM_TYPE){
+    Msg::Error("Unknown type of element %d (in BasisFactory)", tag);
+    return false;
+  }
+  return true;
+}
 
 const nodalBasis* BasisFactory::getNodalBasis(int tag)
 {
   // If the Basis has already been built, return it.
-  std::map<int, nodalBasis*>::const_iterator it = fs.find(tag);
-  if (it != fs.end()) {
-    return it->second;
-  }
+  if(!validTag(tag)) return NULL;
+  nodalBasis *F = readSlot(fs[tag]);
+  if(F) return F;
   // Get the parent type to see which kind of basis
   // we want to create
-  nodalBasis* F = NULL;
   if (tag == MSH_TRI_MINI) {
     F = new miniBasis();
   }
@@ -51,88 +120,88 @@ const nodalBasis* BasisFactory::getNodalBasis(int tag)
         return NULL;
     }
   }
-
-  std::pair<std::map<int, nodalBasis*>::const_iterator, bool> inserted;
-
-#if defined(_OPENMP)
-  #pragma omp critical
-#endif
-    {
-      inserted = fs.insert(std::make_pair(tag, F));
-
-      if (!inserted.second)
-        delete F;
-    }
-
-  return inserted.first->second;
+  return publishSlot(fs[tag], F);
 }
 
 const JacobianBasis* BasisFactory::getJacobianBasis(int tag)
 {
-  std::map<int, JacobianBasis*>::const_iterator it = js.find(tag);
-  if (it != js.end())
-    return it->second;
-
-  JacobianBasis* J = new JacobianBasis(tag);
-  js.insert(std::make_pair(tag, J));
-  return J;
+  if(!validTag(tag)) return NULL;
+  JacobianBasis *J = readSlot(js[tag]);
+  if(J) return J;
+  return publishSlot(js[tag], new JacobianBasis(tag));
 }
 
 const MetricBasis* BasisFactory::getMetricBasis(int tag)
 {
-  std::map<int, MetricBasis*>::const_iterator it = ms.find(tag);
-  if (it != ms.end())
-    return it->second;
-
-  MetricBasis* M = new MetricBasis(tag);
-  ms.insert(std::make_pair(tag, M));
-  return M;
+  if(!validTag(tag)) return NULL;
+  MetricBasis *M = readSlot(ms[tag]);
+  if(M) return M;
+  return publishSlot(ms[tag], new MetricBasis(tag));
 }
 
 const GradientBasis* BasisFactory::getGradientBasis(int tag, int order)
 {
+  if(!validTag(tag)) return NULL;
+  if(order >= 0 && order < MAX_ORDER){
+    GradientBasis *G = readSlot(gs[tag][order]);
+    if(G) return G;
+    return publishSlot(gs[tag][order], new GradientBasis(tag, order));
+  }
   std::pair<int, int> key(tag, order);
-  Cont_gradBasis::const_iterator it = gs.find(key);
-  if (it != gs.end())
-    return it->second;
-
-  GradientBasis* G = new GradientBasis(tag, order);
-  gs.insert(std::make_pair(key, G));
-  return G;
+  GradientBasis *G = findOrPublish(gsHigh, key, (GradientBasis*)0);
+  if(G) return G;
+  return findOrPublish(gsHigh, key, new GradientBasis(tag, order));
 }
 
 const bezierBasis* BasisFactory::getBezierBasis(int parentType, int order)
 {
+  if(parentType >= 0 && parentType <= TYPE_XFEM && order >= 0 &&
+     order < MAX_ORDER){
+    bezierBasis *B = readSlot(bs[parentType][order]);
+    if(B) return B;
+    return publishSlot(bs[parentType][order], new bezierBasis(parentType, order));
+  }
   std::pair<int, int> key(parentType, order);
-  Cont_bezierBasis::iterator it = bs.find(key);
-  if (it != bs.end())
-    return it->second;
-
-  bezierBasis* B = new bezierBasis(parentType, order);
-  bs.insert(std::make_pair(key, B));
-  return B;
+  bezierBasis *B = findOrPublish(bsHigh, key, (bezierBasis*)0);
+  if(B) return B;
+  return findOrPublish(bsHigh, key, new bezierBasis(parentType, order));
 }
 
-void BasisFactory::clearAll()
+void BasisFactory::preload(int tag)
 {
-  std::map<int, nodalBasis*>::iterator itF = fs.begin();
-  while (itF != fs.end()) {
-    delete itF->second;
-    itF++;
+  if(!getNodalBasis(tag)) return;
+  switch(ElementType::ParentTypeFromTag(tag)){
+  case TYPE_LIN: case TYPE_TRI: case TYPE_QUA: case TYPE_TET:
+  case TYPE_PRI: case TYPE_HEX: case TYPE_PYR:
+    getJacobianBasis(tag);
+    break;
   }
-  fs.clear();
+}
 
-  std::map<int, JacobianBasis*>::iterator itJ = js.begin();
-  while (itJ != js.end()) {
-    delete itJ->second;
-    itJ++;
+void BasisFactory::clearAll()
+{
+  for(int i = 0; i <= MSH_NUM_TYPE; i++){
+    delete fs[i];
+    fs[i] = 0;
+    delete js[i];
+    js[i] = 0;
+    delete ms[i];
+    ms[i] = 0;
+    for(int j = 0; j < MAX_ORDER; j++){
+      delete gs[i][j];
+      gs[i][j] = 0;
+    }
   }
-  js.clear();
-
-  Cont_bezierBasis::iterator itB = bs.begin();
-  while (itB != bs.end()) {
-    delete itB->second;
-    itB++;
+  for(int i = 0; i <= TYPE_XFEM; i++){
+    for(int j = 0; j < MAX_ORDER; j++){
+      delete bs[i][j];
+      bs[i][j] = 0;
+    }
   }
-  bs.clear();
+  for(Cont_gradBasis::iterator it = gsHigh.begin(); it != gsHigh.end(); it++)
+    delete it->second;
+  gsHigh.clear();
+  for(Cont_bezierBasis::iterator it = bsHigh.begin(); it != bsHigh.end(); it++)
+    delete it->second;
+  bsHigh.clear();
 }
@@ -18,12 +18,20 @@ class BasisFactory
   typedef std::map<std::pair<int, int>, GradientBasis*> Cont_gradBasis;
 
  private:
-  static std::map<int, nodalBasis*> fs;
-  static std::map<int, JacobianBasis*> js;
-  static std::map<int, MetricBasis*> ms;
-  static Cont_gradBasis gs;
-  static Cont_bezierBasis bs;
+  // The bases are stored in tables indexed by element tag (and order): a
+  // basis is built once, and is then read without locking, so that the
+  // factory can be used concurrently from several threads. Gradient and
+  // bezier bases of order >= MAX_ORDER are stored in maps, accessed under a
+  // lock.
+  enum { MAX_ORDER = 64 };
+  static nodalBasis *fs[MSH_NUM_TYPE + 1];
+  static JacobianBasis *js[MSH_NUM_TYPE + 1];
+  static MetricBasis *ms[MSH_NUM_TYPE + 1];
+  static GradientBasis *gs[MSH_NUM_TYPE + 1][MAX_ORDER];
+  static Cont_gradBasis gsHigh;
   // store bezier bases by parentType and order (no serendipity..)
+  static bezierBasis *bs[TYPE_XFEM + 1][MAX_ORDER];
+  static Cont_bezierBasis bsHigh;
 
  public:
   // Caution: the returned pointer can be NULL
@@ -38,6 +46,11 @@ class BasisFactory
                             ElementType::OrderFromTag(tag) );
     }
 
+  // build the nodal and Jacobian bases (and the underlying gradient and
+  // bezier bases) of an element type, e.g. before using them from several
+  // threads, so that they are not built concurrently
+  static void preload(int tag);
+
   static void clearAll();
 };
 
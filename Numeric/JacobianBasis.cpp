@@ -499,6 +499,40 @@ void JacobianBasis::getScaledJacobianGeneral(int nJacNodes, const fullMatrix<dou
   getJacobianGeneral<true>(nJacNodes, gSMatX,  gSMatY, gSMatZ, nodesX, nodesY, nodesZ, jacobian);
 }
 
+template<bool scaling>
+void JacobianBasis::getJacobianBezierGeneral(int numEl, const double *nodesXYZ,
+                                             fullMatrix<double> &jacBez) const
+{
+  fullMatrix<double> nodesX(numMapNodes, numEl), nodesY(numMapNodes, numEl);
+  fullMatrix<double> nodesZ(numMapNodes, numEl);
+  for (int iEl = 0; iEl < numEl; iEl++) {
+    const double *xyz = &nodesXYZ[3 * iEl * numMapNodes];
+    for (int i = 0; i < numMapNodes; i++) {
+      nodesX(i, iEl) = xyz[3 * i];
+      nodesY(i, iEl) = xyz[3 * i + 1];
+      nodesZ(i, iEl) = xyz[3 * i + 2];
+    }
+  }
+  fullMatrix<double> jacobian(numJacNodes, numEl);
+  getJacobianGeneral<scaling>(numJacNodes, _gradBasis->gradShapeMatX,
+                              _gradBasis->gradShapeMatY, _gradBasis->gradShapeMatZ,
+                              nodesX, nodesY, nodesZ, jacobian);
+  jacBez.resize(numJacNodes, numEl, false);
+  bezier->matrixLag2Bez.mult(jacobian, jacBez);
+}
+
+void JacobianBasis::getSignedJacobianBezier(int numEl, const double *nodesXYZ,
+                                            fullMatrix<double> &jacBez) const
+{
+  getJacobianBezierGeneral<false>(numEl, nodesXYZ, jacBez);
+}
+
+void JacobianBasis::getScaledJacobianBezier(int numEl, const double *nodesXYZ,
+                                            fullMatrix<double> &jacBez) const
+{
+  getJacobianBezierGeneral<true>(numEl, nodesXYZ, jacBez);
+}
+
 // Calculate (signed) Jacobian and its gradients for one element, with normal vectors to straight element
 // for regularization. Evaluation points depend on the given matrices for shape function gradients.
 void JacobianBasis::getSignedJacAndGradientsGeneral(int nJacNodes, const fullMatrix<double> &gSMatX,
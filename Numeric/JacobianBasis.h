@@ -97,6 +97,17 @@ class JacobianBasis {
   inline void getScaledJacobianFast(const fullMatrix<double> &nodesXYZ, fullVector<double> &jacobian) const {
     getScaledJacobianGeneral(numJacNodesFast,gradShapeMatXFast,gradShapeMatYFast,gradShapeMatZFast,nodesXYZ,jacobian);
   }
+  // Batch evaluation of the Bezier coefficients of the Jacobian of numEl
+  // elements: nodesXYZ holds the coordinates of the map nodes of the
+  // elements, element after element (x, y, z of node i of element e at
+  // nodesXYZ[3 * (e * numMapNodes + i)]), and the coefficients of element e
+  // are stored in column e of jacBez. The gradients and the conversion to
+  // Bezier coefficients are computed for all the elements at once, with
+  // matrix-matrix products.
+  void getSignedJacobianBezier(int numEl, const double *nodesXYZ,
+                               fullMatrix<double> &jacBez) const;
+  void getScaledJacobianBezier(int numEl, const double *nodesXYZ,
+                               fullMatrix<double> &jacBez) const;
   //
   inline void lag2Bez(const fullVector<double> &jac, fullVector<double> &bez) const {
     bezier->matrixLag2Bez.mult(jac,bez);
@@ -146,6 +157,10 @@ class JacobianBasis {
                                 const fullMatrix<double> &nodesX, const fullMatrix<double> &nodesY,
                                 const fullMatrix<double> &nodesZ, fullMatrix<double> &jacobian) const;
 
+  template<bool scaling>
+  void getJacobianBezierGeneral(int numEl, const double *nodesXYZ,
+                                fullMatrix<double> &jacBez) const;
+
   void getSignedJacAndGradientsGeneral(int nJacNodes, const fullMatrix<double> &gSMatX,
                                        const fullMatrix<double> &gSMatY, const fullMatrix<double> &gSMatZ,
                                        const fullMatrix<double> &nodesXYZ, const fullMatrix<double> &normals,
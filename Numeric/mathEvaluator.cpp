@@ -3,6 +3,7 @@
 // See the LICENSE.txt file for license information. Please report all
 // bugs and problems to the public mailing list <gmsh@geuz.org>.
 
+#include <algorithm>
 #include "mathEvaluator.h"
 
 #if defined(HAVE_MATHEX)
@@ -34,6 +35,7 @@ mathEvaluator::mathEvaluator(std::vector<std::string> &expressions,
     for(unsigned int i = 0; i < _expressions.size(); i++)
       delete(_expressions[i]);
     _expressions.clear();
+    expressions.clear();
   }
 }
 
@@ -79,4 +81,68 @@ bool mathEvaluator::eval(std::vector<double> &values, std::vector<double> &res)
   return true;
 }
 
+bool mathEvaluator::eval(const std::vector<std::vector<double> > &values,
+                         std::vector<std::vector<double> > &res)
+{
+  if(_expressions.empty()) return false;
+
+  if(values.size() != _variables.size()){
+    Msg::Error("Given %d value(s) for %d variable(s)", values.size(), _variables.size());
+    return false;
+  }
+
+  int n = values.size() ? values[0].size() : 1;
+  for(unsigned int j = 1; j < values.size(); j++){
+    if((int)values[j].size() != n){
+      Msg::Error("Given %d value(s) for %d point(s)", values[j].size(), n);
+      return false;
+    }
+  }
+
+  res.resize(_expressions.size());
+  for(unsigned int i = 0; i < _expressions.size(); i++) res[i].resize(n);
+  if(!n) return true;
+
+  std::vector<const double*> vars(values.size());
+  for(unsigned int j = 0; j < values.size(); j++) vars[j] = &values[j][0];
+
+  // blocks whose evaluation failed (e.g. because of a division by zero) are
+  // evaluated again one point at a time, which handles the errors as the
+  // single point evaluation does
+  const int blockSize = 4096;
+  const int numBlocks = (n + blockSize - 1) / blockSize;
+  std::vector<char> failed(numBlocks * _expressions.size(), 0);
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic)
+#endif
+  for(int b = 0; b < numBlocks; b++){
+    int start = b * blockSize, m = std::min(blockSize, n - start);
+    std::vector<const double*> v(vars);
+    for(unsigned int j = 0; j < v.size(); j++) v[j] += start;
+    for(unsigned int i = 0; i < _expressions.size(); i++){
+      try {
+        _expressions[i]->eval(m, v, &res[i][start]);
+      }
+      catch(const smlib::mathex::error &e) {
+        failed[b * _expressions.size() + i] = 1;
+      }
+    }
+  }
+
+  std::vector<double> val(values.size()), r(_expressions.size());
+  for(int b = 0; b < numBlocks; b++){
+    bool retry = false;
+    for(unsigned int i = 0; i < _expressions.size(); i++)
+      if(failed[b * _expressions.size() + i]) retry = true;
+    if(!retry) continue;
+    int start = b * blockSize, end = std::min(start + blockSize, n);
+    for(int k = start; k < end; k++){
+      for(unsigned int j = 0; j < values.size(); j++) val[j] = values[j][k];
+      if(!eval(val, r)) return false;
+      for(unsigned int i = 0; i < _expressions.size(); i++) res[i][k] = r[i];
+    }
+  }
+  return true;
+}
+
 #endif
@@ -29,6 +29,13 @@ class mathEvaluator{
   // evaluate the expression(s) using the given values and fill the
   // result vector. Returns true if the evaluation succeeded.
   bool eval(std::vector<double> &values, std::vector<double> &res);
+  // evaluate the expression(s) at many points at once: values[j][k] is the
+  // value of the j-th variable at the k-th point, and res[i][k] is set to the
+  // value of the i-th expression at the k-th point. The points are evaluated
+  // by blocks (in parallel if OpenMP is available). Returns true if the
+  // evaluation succeeded.
+  bool eval(const std::vector<std::vector<double> > &values,
+            std::vector<std::vector<double> > &res);
 };
 
 #else
@@ -47,6 +54,11 @@ class mathEvaluator{
   {
     return false;
   }
+  bool eval(const std::vector<std::vector<double> > &values,
+            std::vector<std::vector<double> > &res)
+  {
+    return false;
+  }
 };
 
 #endif
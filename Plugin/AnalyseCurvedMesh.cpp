@@ -61,6 +61,74 @@ public:
   inline double maxB() const {return _maxB;}
 };
 
+// Refine the bounds on the Jacobian of an element by subdividing the Bezier
+// patch of the heap top (ordered by Comp) until the bounds are within the
+// tolerance or until the budget of subdivisions is spent. The subdivided
+// patches are deleted.
+template <class Comp>
+void refineBounds(std::vector<BezierJacobian*> &heap, const JacobianBasis *jfs,
+                  double tol, int maxSub, int &numSub, int &depth,
+                  double &minL, double &maxL, fullVector<double> &subJacBez)
+{
+  const int numSamplingPt = jfs->getNumJacNodes();
+  fullVector<double> jacBez;
+
+  make_heap(heap.begin(), heap.end(), Comp());
+  while (!heap[0]->boundsOk(tol, minL, maxL) && numSub < maxSub) {
+    BezierJacobian *bj = heap[0];
+    pop_heap(heap.begin(), heap.end(), Comp());
+    heap.pop_back();
+
+    bj->subDivisions(subJacBez);
+    const int currentDepth = bj->depth() + 1;
+    depth = std::max(depth, currentDepth);
+    ++numSub;
+    delete bj;
+
+    for (int i = 0; i < jfs->getNumDivisions(); i++) {
+      jacBez.setAsProxy(subJacBez, i * numSamplingPt, numSamplingPt);
+      bj = new BezierJacobian(jacBez, jfs, currentDepth);
+      minL = std::min(minL, bj->minL());
+      maxL = std::max(maxL, bj->maxL());
+
+      heap.push_back(bj);
+      push_heap(heap.begin(), heap.end(), Comp());
+    }
+  }
+}
+
+// Compute bounds [minB, maxB] on the Jacobian of an element from its Bezier
+// coefficients, with at most maxSub subdivisions. The bounds remain valid
+// (but are less sharp) if the budget is exhausted. Returns the maximum depth
+// of subdivision.
+int computeBounds(fullVector<double> &jacBez, const JacobianBasis *jfs,
+                  double tol, int maxSub, fullVector<double> &subJacBez,
+                  double &minB, double &maxB, bool &exhausted)
+{
+  std::vector<BezierJacobian*> heap;
+  heap.push_back(new BezierJacobian(jacBez, jfs, 0));
+
+  double minL = heap[0]->minL(), maxL = heap[0]->maxL();
+  int numSub = 0, depth = 0;
+  refineBounds<lessMinVal>(heap, jfs, tol, maxSub, numSub, depth,
+                           minL, maxL, subJacBez);
+  refineBounds<lessMax>(heap, jfs, tol, maxSub, numSub, depth,
+                        minL, maxL, subJacBez);
+  // the budget can be spent in either phase: the bounds are not sharp if any
+  // remaining patch is not within the tolerance
+  exhausted = false;
+  minB = minL;
+  maxB = maxL;
+  for (unsigned int i = 0; i < heap.size(); ++i) {
+    if (numSub >= maxSub && !heap[i]->boundsOk(tol, minL, maxL))
+      exhausted = true;
+    minB = std::min(minB, heap[i]->minB());
+    maxB = std::max(maxB, heap[i]->maxB());
+    delete heap[i];
+  }
+  return depth;
+}
+
 } // namespace
 
 StringXNumber CurvedMeshOptions_Number[] = {
@@ -69,7 +137,8 @@ StringXNumber CurvedMeshOptions_Number[] = {
   {GMSH_FULLRC, "Hidding threshold", NULL, .1},
   {GMSH_FULLRC, "Dimension of elements", NULL, -1},
   {GMSH_FULLRC, "Recompute bounds", NULL, 0},
-  {GMSH_FULLRC, "Tolerance", NULL, 1e-3}
+  {GMSH_FULLRC, "Tolerance", NULL, 1e-3},
+  {GMSH_FULLRC, "Maximum number of subdivisions", NULL, 1000}
 };
 extern "C"
 {
@@ -112,7 +181,15 @@ std::string GMSH_AnalyseCurvedMeshPlugin::getHelp() const
     "\n"
     "- Tolerance = ]0, 1[: Tolerance on the computation of min(R) or min(J). "
     "It should be at most 0.01 but it can be set to 1 to just check the validity of "
-    "the mesh.";
+    "the mesh.\n"
+    "\n"
+    "- Maximum number of subdivisions = [0, inf[: Budget of subdivisions of the "
+    "Bezier coefficients of the Jacobian, per element. If it is exhausted, the "
+    "bounds on the Jacobian are less sharp than the tolerance (but remain "
+    "valid).\n"
+    "\n"
+    "The elements are analysed in parallel if Gmsh is compiled with OpenMP "
+    "(the number of threads is set by OMP_NUM_THREADS).";
 }
 
 // Execution
@@ -125,6 +202,7 @@ PView *GMSH_AnalyseCurvedMeshPlugin::execute(PView *v)
   _dim           = static_cast<int>(CurvedMeshOptions_Number[3].def);
   _recompute     = static_cast<bool>(CurvedMeshOptions_Number[4].def);
   _tol           = static_cast<double>(CurvedMeshOptions_Number[5].def);
+  _maxSub        = static_cast<int>(CurvedMeshOptions_Number[6].def);
 
   if (_dim < 0 || _dim > 3) _dim = _m->getDim();
 
@@ -145,11 +223,14 @@ PView *GMSH_AnalyseCurvedMeshPlugin::execute(PView *v)
   if ((_dim == 1 && !_computedJ1D) ||
       (_dim == 2 && !_computedJ2D) ||
       (_dim == 3 && !_computedJ3D)   ) {
-    double time = Cpu();
+    double time = GetTimeInSeconds();
     Msg::StatusBar(true, "Computing Jacobian for %dD elements...", _dim);
     _computeMinMaxJandValidity();
-    Msg::StatusBar(true, "... Done computing Jacobian (%g seconds)", Cpu()-time);
+    Msg::StatusBar(true, "... Done computing Jacobian (%g seconds, %d thread%s)",
+                   GetTimeInSeconds() - time, Msg::GetMaxThreads(),
+                   Msg::GetMaxThreads() > 1 ? "s" : "");
     _printStatJacobian();
+    _printStatSubdivision();
   }
 
   if (_computeMetric &&
@@ -239,6 +320,9 @@ PView *GMSH_AnalyseCurvedMeshPlugin::execute(PView *v)
 
 void GMSH_AnalyseCurvedMeshPlugin::_computeMinMaxJandValidity()
 {
+  _numElPerDepth.clear();
+  _numExhausted = 0;
+
   switch (_dim) {
     case 3 :
       if (_computedJ3D) break;
@@ -298,109 +382,61 @@ void GMSH_AnalyseCurvedMeshPlugin::_computeMinMaxJandValidity(MElement *const*el
     return;
   }
 
-  const int numSamplingPt = jfs->getNumJacNodes();
   const int numMapNodes = jfs->getNumMapNodes();
-  fullVector<double> jacobian(numSamplingPt);
-  fullVector<double> jacBez(numSamplingPt);
-  fullVector<double> subJacBez(jfs->getNumSubNodes());
-
-  for (int k = 0; k < numEl; ++k) {
-    fullMatrix<double> nodesXYZ(numMapNodes,3);
-    el[k]->getNodesCoord(nodesXYZ);
-    jfs->getScaledJacobian(nodesXYZ,jacobian);
-    jfs->lag2Bez(jacobian, jacBez);
-
-    BezierJacobian *bj = new BezierJacobian(jacBez, jfs, 0);
-    std::vector<BezierJacobian*> heap;
-    heap.push_back(bj);
-
-    double minL = bj->minL(), maxL = bj->maxL();
-    int currentDepth = 0;
-
-    while (!heap[0]->boundsOk(_tol, minL, maxL)) {
-      bj = heap[0];
-      pop_heap(heap.begin(), heap.end(), lessMinVal());
-      heap.pop_back();
-
-      bj->subDivisions(subJacBez);
-      currentDepth = bj->depth() + 1;
-      if (currentDepth > 20) Msg::Error("depth is too damn high !");
-
-      for (int i = 0; i < jfs->getNumDivisions(); i++) {
-        jacBez.setAsProxy(subJacBez, i * numSamplingPt, numSamplingPt);
-        bj = new BezierJacobian(jacBez, jfs, currentDepth);
-        minL = std::min(minL, bj->minL());
-        maxL = std::max(maxL, bj->maxL());
-
-        heap.push_back(bj);
-        push_heap(heap.begin(), heap.end(), lessMinVal());
-      }
-    }
-
-    make_heap(heap.begin(), heap.end(), lessMax());
-
-    while (!heap[0]->boundsOk(_tol, minL, maxL)) {
-      bj = heap[0];
-      pop_heap(heap.begin(), heap.end(), lessMax());
-      heap.pop_back();
-
-      bj->subDivisions(subJacBez);
-      currentDepth = bj->depth() + 1;
-      if (currentDepth > 20) Msg::Error("depth is too damn high !");
 
-      for (int i = 0; i < jfs->getNumDivisions(); i++) {
-        jacBez.setAsProxy(subJacBez, i * numSamplingPt, numSamplingPt);
-        bj = new BezierJacobian(jacBez, jfs, currentDepth);
-        minL = std::min(minL, bj->minL());
-        maxL = std::max(maxL, bj->maxL());
+  // the elements are distributed over the threads by blocks, for which the
+  // Bezier coefficients of the Jacobian are computed at once; the bounds of
+  // element k are stored at index k so that _data keeps the element order
+  const int blockSize = 512;
+  const int numBlocks = (numEl + blockSize - 1) / blockSize;
+  std::vector<double> minJ(numEl), maxJ(numEl);
+  std::vector<int> depth(numEl);
+  int numExhausted = 0;
+
+#if defined(_OPENMP)
+#pragma omp parallel reduction(+:numExhausted)
+#endif
+  {
+    std::vector<double> nodesXYZ;
+    fullMatrix<double> blockJacBez;
+    fullVector<double> jacBez;
+    fullVector<double> subJacBez(jfs->getNumSubNodes());
 
-        heap.push_back(bj);
-        push_heap(heap.begin(), heap.end(), lessMax());
+#if defined(_OPENMP)
+#pragma omp for schedule(dynamic, 1)
+#endif
+    for (int b = 0; b < numBlocks; ++b) {
+      const int k0 = b * blockSize;
+      const int n = std::min(blockSize, numEl - k0);
+      nodesXYZ.resize(3 * numMapNodes * n);
+      for (int i = 0; i < n; ++i) {
+        for (int j = 0; j < numMapNodes; ++j) {
+          const MVertex *v = el[k0 + i]->getShapeFunctionNode(j);
+          double *xyz = &nodesXYZ[3 * (i * numMapNodes + j)];
+          xyz[0] = v->x();
+          xyz[1] = v->y();
+          xyz[2] = v->z();
+        }
+      }
+      jfs->getScaledJacobianBezier(n, &nodesXYZ[0], blockJacBez);
+
+      for (int i = 0; i < n; ++i) {
+        jacBez.setAsProxy(blockJacBez, i);
+        bool exhausted;
+        depth[k0 + i] = computeBounds(jacBez, jfs, _tol, _maxSub, subJacBez,
+                                      minJ[k0 + i], maxJ[k0 + i], exhausted);
+        if (exhausted) ++numExhausted;
       }
     }
+  }
 
-    double minB = minL;
-    double maxB = maxL;
-    for (unsigned int i = 0; i < heap.size(); ++i) {
-      minB = std::min(minB, heap[i]->minB());
-      maxB = std::max(maxB, heap[i]->maxB());
-    }
-
-    // TODO REMOVE #include "BasisFactory.h"
-
-    /*if (el[k]->getNum() == 26776) {
-      Msg::Info("%g %g %g %g", minB, minL, maxL, maxB);
-
-      / *const nodalBasis* nb = BasisFactory::getNodalBasis(el[k]->getTypeForMSH());
-      int tag1 = ElementType::getTag(el[k]->getType(), 1);
-      const nodalBasis* nb1 = BasisFactory::getNodalBasis(tag1);
-
-      //double *f;
-      //f = new double[nb1->points.size1()];
-      fullMatrix<double> f;
-      nb1->f(nb->points, f);
-      Msg::Info("SIZES [%d %d] (%d, %d)", f.size1(), f.size2(), nb->points.size1(), nb1->points.size1());
-
-      for (int i = 0; i < nb->points.size1(); ++i) {
-        double X[3] = {0, 0, 0};
-        for (int j = 0; j < f.size2(); ++j) {
-          X[0] += el[k]->getVertex(j)->x() * f(i, j);
-          X[1] += el[k]->getVertex(j)->y() * f(i, j);
-          X[2] += el[k]->getVertex(j)->z() * f(i, j);
-        }
-        if (std::abs(X[0] - el[k]->getVertex(i)->x()) < 1e-12 &&
-            std::abs(X[1] - el[k]->getVertex(i)->y()) < 1e-12 &&
-            std::abs(X[2] - el[k]->getVertex(i)->z()) < 1e-12);
-        else {
-          Msg::Info("aaarg %d/%d : [%g %g %g] ([%g %g %g])", i+1, nb->points.size1(),
-              el[k]->getVertex(i)->x(), el[k]->getVertex(i)->y(), el[k]->getVertex(i)->z(),
-              X[0], X[1], X[2]);
-        }
-      }* /
-    }*/
-
-    _data.push_back(CurvedMeshPluginData(el[k], minB, maxB));
+  for (int k = 0; k < numEl; ++k) {
+    _data.push_back(CurvedMeshPluginData(el[k], minJ[k], maxJ[k]));
+    if (depth[k] >= (int)_numElPerDepth.size())
+      _numElPerDepth.resize(depth[k] + 1, 0);
+    ++_numElPerDepth[depth[k]];
   }
+  _numExhausted += numExhausted;
 }
 
 void GMSH_AnalyseCurvedMeshPlugin::_computeMinR()
@@ -516,6 +552,28 @@ void GMSH_AnalyseCurvedMeshPlugin::_printStatJacobian()
       infratJ, supratJ, avgratJ, count);
 }
 
+void GMSH_AnalyseCurvedMeshPlugin::_printStatSubdivision()
+{
+  int numEl = 0;
+  double avgDepth = 0;
+  for (unsigned int d = 0; d < _numElPerDepth.size(); ++d) {
+    numEl += _numElPerDepth[d];
+    avgDepth += d * _numElPerDepth[d];
+  }
+  if (!numEl) return;
+  avgDepth /= numEl;
+
+  Msg::Info("Depth of subdivision: max=%d, avg=%g", (int)_numElPerDepth.size() - 1,
+      avgDepth);
+  for (unsigned int d = 0; d < _numElPerDepth.size(); ++d) {
+    if (_numElPerDepth[d])
+      Msg::Info("  depth %2d: %d elem.", d, _numElPerDepth[d]);
+  }
+  if (_numExhausted)
+    Msg::Warning("Budget of %d subdivisions exhausted for %d elem. (bounds on "
+        "the Jacobian less sharp than the tolerance)", _maxSub, _numExhausted);
+}
+
 BezierJacobian::BezierJacobian(fullVector<double> &v,
     const JacobianBasis *jfs, int depth)
 {
@@ -44,7 +44,7 @@ private :
   int _dim;
   GModel *_m;
   double _threshold, _tol;
-  int _numPView, _computeMetric;
+  int _numPView, _computeMetric, _maxSub;
   bool _recompute;
   bool _computedR3D, _computedR2D;
   bool _computedJ3D, _computedJ2D, _computedJ1D;
@@ -53,6 +53,12 @@ private :
 
   std::vector<CurvedMeshPluginData> _data;
 
+  // statistics of the last computation of the Jacobian: number of elements
+  // per depth of subdivision, and number of elements for which the budget of
+  // subdivisions was exhausted
+  std::vector<int> _numElPerDepth;
+  int _numExhausted;
+
 public :
   GMSH_AnalyseCurvedMeshPlugin() {
     _computedR3D = false;
@@ -65,6 +71,7 @@ public :
     _2PViewJ = false;
     _1PViewR = false;
     _2PViewR = false;
+    _numExhausted = 0;
   }
   std::string getName() const { return "AnalyseCurvedMesh"; }
   std::string getShortHelp() const {
@@ -83,6 +90,7 @@ private :
   bool _hideWithThreshold();
   void _printStatMetric();
   void _printStatJacobian();
+  void _printStatSubdivision();
 };
 
 #endif
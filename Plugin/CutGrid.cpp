@@ -308,6 +308,16 @@ void GMSH_CutGridPlugin::addInView(int numsteps, int connect, int nbcomp,
   }     
 }
 
+void GMSH_CutGridPlugin::copyValues(const std::vector<double> &v,
+                                    double ***vals)
+{
+  int nv = v.size() / (getNbU() * getNbV());
+  for(int i = 0; i < getNbU(); i++)
+    for(int j = 0; j < getNbV(); j++)
+      for(int k = 0; k < nv; k++)
+        vals[i][j][k] = v[(i * getNbV() + j) * nv + k];
+}
+
 PView *GMSH_CutGridPlugin::GenerateView(PView *v1, int connect)
 {
   if(getNbU() <= 0 || getNbV() <= 0)
@@ -338,26 +348,30 @@ PView *GMSH_CutGridPlugin::GenerateView(PView *v1, int connect)
     }
   }
   
+  // all the grid points are interpolated at once
+  std::vector<SPoint3> pts;
+  for(int i = 0; i < getNbU(); i++)
+    for(int j = 0; j < getNbV(); j++)
+      pts.push_back(SPoint3(pnts[i][j][0], pnts[i][j][1], pnts[i][j][2]));
+  std::vector<double> v;
+
   if(nbs){
-    for(int i = 0; i < getNbU(); i++)
-      for(int j = 0; j < getNbV(); j++)
-        o.searchScalar(pnts[i][j][0], pnts[i][j][1], pnts[i][j][2], vals[i][j]);
+    o.searchScalar(pts, v);
+    copyValues(v, vals);
     addInView(numsteps, connect, 1, pnts, vals, data2->SP, &data2->NbSP, 
               data2->SL, &data2->NbSL, data2->SQ, &data2->NbSQ);
   }
 
   if(nbv){
-    for(int i = 0; i < getNbU(); i++)
-      for(int j = 0; j < getNbV(); j++)
-        o.searchVector(pnts[i][j][0], pnts[i][j][1], pnts[i][j][2], vals[i][j]);
+    o.searchVector(pts, v);
+    copyValues(v, vals);
     addInView(numsteps, connect, 3, pnts, vals, data2->VP, &data2->NbVP,
               data2->VL, &data2->NbVL, data2->VQ, &data2->NbVQ);
   }
 
   if(nbt){
-    for(int i = 0; i < getNbU(); i++)
-      for(int j = 0; j < getNbV(); j++)
-        o.searchTensor(pnts[i][j][0], pnts[i][j][1], pnts[i][j][2], vals[i][j]);
+    o.searchTensor(pts, v);
+    copyValues(v, vals);
     addInView(numsteps, connect, 9, pnts, vals, data2->TP, &data2->NbTP, 
               data2->TL, &data2->NbTL, data2->TQ, &data2->NbTQ);
   }
@@ -22,6 +22,7 @@ class GMSH_CutGridPlugin : public GMSH_PostPlugin
                  std::vector<double> &P, int *nP, 
                  std::vector<double> &L, int *nL, 
                  std::vector<double> &Q, int *nQ);
+  void copyValues(const std::vector<double> &v, double ***vals);
   PView *GenerateView (PView *v, int connectPoints);
  public:
   GMSH_CutGridPlugin(){}
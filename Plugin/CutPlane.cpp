@@ -137,6 +137,16 @@ double GMSH_CutPlanePlugin::levelset(double x, double y, double z, double val) c
     CutPlaneOptions_Number[2].def * z + CutPlaneOptions_Number[3].def;
 }
 
+void GMSH_CutPlanePlugin::levelsetValues(int n, const double *x, const double *y,
+                                         const double *z, const double *val,
+                                         double *levels) const
+{
+  const double a = CutPlaneOptions_Number[0].def, b = CutPlaneOptions_Number[1].def;
+  const double c = CutPlaneOptions_Number[2].def, d = CutPlaneOptions_Number[3].def;
+  for(int i = 0; i < n; i++)
+    levels[i] = a * x[i] + b * y[i] + c * z[i] + d;
+}
+
 bool GMSH_CutPlanePlugin::geometricalFilter(fullMatrix<double> *node_positions) const
 {
   const double l0 = levelset((*node_positions)(0, 0),
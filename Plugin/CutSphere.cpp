@@ -138,6 +138,19 @@ double GMSH_CutSpherePlugin::levelset(double x, double y, double z,
   return (x - a) * (x - a) + (y - b) * (y - b) + (z - c) * (z - c) - r * r;
 }
 
+void GMSH_CutSpherePlugin::levelsetValues(int n, const double *x, const double *y,
+                                          const double *z, const double *val,
+                                          double *levels) const
+{
+  const double a = CutSphereOptions_Number[0].def;
+  const double b = CutSphereOptions_Number[1].def;
+  const double c = CutSphereOptions_Number[2].def;
+  const double r = CutSphereOptions_Number[3].def;
+  for(int i = 0; i < n; i++)
+    levels[i] = (x[i] - a) * (x[i] - a) + (y[i] - b) * (y[i] - b) +
+      (z[i] - c) * (z[i] - c) - r * r;
+}
+
 PView *GMSH_CutSpherePlugin::execute(PView *v)
 {
   int iView = (int)CutSphereOptions_Number[7].def;
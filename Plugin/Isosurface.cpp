@@ -114,6 +114,15 @@ double GMSH_IsosurfacePlugin::levelset(double x, double y, double z, double val)
   return val - IsosurfaceOptions_Number[0].def;
 }
 
+void GMSH_IsosurfacePlugin::levelsetValues(int n, const double *x, const double *y,
+                                           const double *z, const double *val,
+                                           double *levels) const
+{
+  const double v = IsosurfaceOptions_Number[0].def;
+  for(int i = 0; i < n; i++)
+    levels[i] = val[i] - v;
+}
+
 PView *GMSH_IsosurfacePlugin::execute(PView *v)
 {
   int iView = (int)IsosurfaceOptions_Number[4].def;
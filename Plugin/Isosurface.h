@@ -16,6 +16,8 @@ extern "C"
 class GMSH_IsosurfacePlugin : public GMSH_LevelsetPlugin
 {
   double levelset(double x, double y, double z, double val) const;
+  void levelsetValues(int n, const double *x, const double *y, const double *z,
+                      const double *val, double *levels) const;
  public:
   GMSH_IsosurfacePlugin(){}
   std::string getShortHelp() const
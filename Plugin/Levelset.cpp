@@ -180,7 +180,6 @@ static void reorderPrism(int numComp, double xp[12], double yp[12], double zp[12
 
 GMSH_LevelsetPlugin::GMSH_LevelsetPlugin()
 {
-  _invert = 0.;
   _ref[0] = _ref[1] = _ref[2] = 0.;
   _valueIndependent = 0; // "moving" levelset
   _valueView = -1; // use same view for levelset and field data
@@ -191,59 +190,52 @@ GMSH_LevelsetPlugin::GMSH_LevelsetPlugin()
   _orientation = GMSH_LevelsetPlugin::NONE;
 }
 
+void GMSH_LevelsetPlugin::levelsetValues(int n, const double *x, const double *y,
+                                         const double *z, const double *val,
+                                         double *levels) const
+{
+  for(int i = 0; i < n; i++)
+    levels[i] = levelset(x[i], y[i], z[i], val[i]);
+}
+
+void GMSH_LevelsetPlugin::cutOutput::clear()
+{
+  for(int i = 0; i < 24; i++){
+    num[i] = 0;
+    lists[i].clear();
+  }
+}
+
+void GMSH_LevelsetPlugin::cutOutput::appendTo(int N[24],
+                                              std::vector<double> *V[24]) const
+{
+  for(int i = 0; i < 24; i++){
+    N[i] += num[i];
+    V[i]->insert(V[i]->end(), lists[i].begin(), lists[i].end());
+  }
+}
+
 void GMSH_LevelsetPlugin::_addElement(int np, int numEdges, int numComp,
                                       double xp[12], double yp[12], double zp[12],
-                                      double valp[12][9], PViewDataList *out,
-                                      bool firstStep)
+                                      double valp[12][9], cutOutput &out,
+                                      bool firstStep) const
 {
-  std::vector<double> *list;
-  int *nbPtr;
+  // index of the list of the element (points, lines, triangles, quadrangles,
+  // tetrahedra, hexahedra, prisms, pyramids), then of the number of
+  // components (scalar, vector, tensor)
+  int idx;
   switch(np){
-  case 1:
-    if(numComp == 1)      { list = &out->SP; nbPtr = &out->NbSP; }
-    else if(numComp == 3) { list = &out->VP; nbPtr = &out->NbVP; }
-    else                  { list = &out->TP; nbPtr = &out->NbTP; }
-    break;
-  case 2:
-    if(numComp == 1)      { list = &out->SL; nbPtr = &out->NbSL; }
-    else if(numComp == 3) { list = &out->VL; nbPtr = &out->NbVL; }
-    else                  { list = &out->TL; nbPtr = &out->NbTL; }
-    break;
-  case 3:
-    if(numComp == 1)      { list = &out->ST; nbPtr = &out->NbST; }
-    else if(numComp == 3) { list = &out->VT; nbPtr = &out->NbVT; }
-    else                  { list = &out->TT; nbPtr = &out->NbTT; }
-    break;
-  case 4:
-    if(!_extractVolume || numEdges <= 4){
-      if(numComp == 1)      { list = &out->SQ; nbPtr = &out->NbSQ; }
-      else if(numComp == 3) { list = &out->VQ; nbPtr = &out->NbVQ; }
-      else                  { list = &out->TQ; nbPtr = &out->NbTQ; }
-    }
-    else{
-      if(numComp == 1)      { list = &out->SS; nbPtr = &out->NbSS; }
-      else if(numComp == 3) { list = &out->VS; nbPtr = &out->NbVS; }
-      else                  { list = &out->TS; nbPtr = &out->NbTS; }
-    }
-    break;
-  case 5:
-    if(numComp == 1)      { list = &out->SY; nbPtr = &out->NbSY; }
-    else if(numComp == 3) { list = &out->VY; nbPtr = &out->NbVY; }
-    else                  { list = &out->TY; nbPtr = &out->NbTY; }
-    break;
-  case 6:
-    if(numComp == 1)      { list = &out->SI; nbPtr = &out->NbSI; }
-    else if(numComp == 3) { list = &out->VI; nbPtr = &out->NbVI; }
-    else                  { list = &out->TI; nbPtr = &out->NbTI; }
-    break;
-  case 8:
-    if(numComp == 1)      { list = &out->SH; nbPtr = &out->NbSH; }
-    else if(numComp == 3) { list = &out->VH; nbPtr = &out->NbVH; }
-    else                  { list = &out->TH; nbPtr = &out->NbTH; }
-    break;
-  default:
-    return;
-  }
+  case 1: idx = 0; break;
+  case 2: idx = 1; break;
+  case 3: idx = 2; break;
+  case 4: idx = (!_extractVolume || numEdges <= 4) ? 3 : 4; break;
+  case 5: idx = 7; break;
+  case 6: idx = 6; break;
+  case 8: idx = 5; break;
+  default: return;
+  }
+  idx = 3 * idx + ((numComp == 1) ? 0 : (numComp == 3) ? 1 : 2);
+  std::vector<double> *list = &out.lists[idx];
 
   // copy the elements in the output data
   if(firstStep || !_valueIndependent) {
@@ -253,30 +245,23 @@ void GMSH_LevelsetPlugin::_addElement(int np, int numEdges, int numComp,
       list->push_back(yp[k]);
     for(int k = 0; k < np; k++)
       list->push_back(zp[k]);
-    (*nbPtr)++;
+    out.num[idx]++;
   }
   for(int k = 0; k < np; k++)
     for(int l = 0; l < numComp; l++)
       list->push_back(valp[k][l]);
 }
 
-void GMSH_LevelsetPlugin::_cutAndAddElements(PViewData *vdata, PViewData *wdata,
-                                             int ent, int ele, int vstep, int wstep,
+void GMSH_LevelsetPlugin::_cutAndAddElements(int type, int numNodes, int numEdges,
+                                             int numComp, int numSteps,
+                                             const double *const *values,
                                              double x[8], double y[8], double z[8],
                                              double levels[8], double scalarValues[8],
-                                             PViewDataList* out)
+                                             cutOutput &out) const
 {
-  int stepmin = vstep, stepmax = vstep + 1, otherstep = wstep;
-  if(stepmin < 0){
-    stepmin = vdata->getFirstNonEmptyTimeStep();
-    stepmax = vdata->getNumTimeSteps();
-  }
-  if(wstep < 0) otherstep = wdata->getFirstNonEmptyTimeStep();
-
-  int numNodes = vdata->getNumNodes(stepmin, ent, ele);
-  int numEdges = vdata->getNumEdges(stepmin, ent, ele);
-  int numComp = wdata->getNumComponents(otherstep, ent, ele);
-  int type = vdata->getType(stepmin, ent, ele);
+  // values[step] holds the field values (numComp per node) of the element at
+  // the step-th output step, or is null if the field has no such step
+  double invert = 0.;
 
   // decompose the element into simplices
   for(int simplex = 0; simplex < numSimplexDec(type); simplex++){
@@ -286,12 +271,11 @@ void GMSH_LevelsetPlugin::_cutAndAddElements(PViewData *vdata, PViewData *wdata,
                   nsn, nse);
 
     // loop over time steps
-    for(int step = stepmin; step < stepmax; step++){
+    for(int step = 0; step < numSteps; step++){
 
       // check which edges cut the iso and interpolate the value
-      if(wstep < 0) otherstep = step;
-
-      if(!wdata->hasTimeStep(otherstep)) continue;
+      const double *val = values[step];
+      if(!val) continue;
 
       int np = 0;
       double xp[12], yp[12], zp[12], valp[12][9];
@@ -301,9 +285,8 @@ void GMSH_LevelsetPlugin::_cutAndAddElements(PViewData *vdata, PViewData *wdata,
           double c = InterpolateIso(x, y, z, levels, 0., n[n0], n[n1],
                                     &xp[np], &yp[np], &zp[np]);
           for(int comp = 0; comp < numComp; comp++){
-            double v0, v1;
-            wdata->getValue(otherstep, ent, ele, n[n0], comp, v0);
-            wdata->getValue(otherstep, ent, ele, n[n1], comp, v1);
+            double v0 = val[n[n0] * numComp + comp];
+            double v1 = val[n[n1] * numComp + comp];
             valp[np][comp] = v0 + c * (v1 - v0);
           }
           ep[np++] = i + 1;
@@ -331,9 +314,9 @@ void GMSH_LevelsetPlugin::_cutAndAddElements(PViewData *vdata, PViewData *wdata,
             yp[nod] = y[n[nod]];
             zp[nod] = z[n[nod]];
             for(int comp = 0; comp < numComp; comp++)
-              wdata->getValue(otherstep, ent, ele, n[nod], comp, valp[nod][comp]);
+              valp[nod][comp] = val[n[nod] * numComp + comp];
           }
-          _addElement(nsn, nse, numComp, xp, yp, zp, valp, out, step == stepmin);
+          _addElement(nsn, nse, numComp, xp, yp, zp, valp, out, step == 0);
         }
         continue;
       }
@@ -352,7 +335,7 @@ void GMSH_LevelsetPlugin::_cutAndAddElements(PViewData *vdata, PViewData *wdata,
       // orient the triangles and the quads to get the normals right
       if(!_extractVolume && (np == 3 || np == 4)) {
         // compute invertion test only once for spatially-fixed views
-        if(step == stepmin || !_valueIndependent) {
+        if(step == 0 || !_valueIndependent) {
           double v1[3] = {xp[2] - xp[0], yp[2] - yp[0], zp[2] - zp[0]};
           double v2[3] = {xp[1] - xp[0], yp[1] - yp[0], zp[1] - zp[0]};
           double gr[3], normal[3];
@@ -360,22 +343,25 @@ void GMSH_LevelsetPlugin::_cutAndAddElements(PViewData *vdata, PViewData *wdata,
           switch (_orientation) {
           case MAP:
             gradSimplex(x, y, z, scalarValues, gr);
-            prosca(gr, normal, &_invert);
+            prosca(gr, normal, &invert);
             break;
           case PLANE:
-            prosca(normal, _ref, &_invert);
+            {
+              double ref[3] = {_ref[0], _ref[1], _ref[2]};
+              prosca(normal, ref, &invert);
+            }
             break;
           case SPHERE:
             gr[0] = xp[0] - _ref[0];
             gr[1] = yp[0] - _ref[1];
             gr[2] = zp[0] - _ref[2];
-            prosca(gr, normal, &_invert);
+            prosca(gr, normal, &invert);
           case NONE:
           default:
             break;
           }
         }
-        if(_invert > 0.) {
+        if(invert > 0.) {
           double xpi[12], ypi[12], zpi[12], valpi[12][9];
           int epi[12];
           for(int k = 0; k < np; k++)
@@ -397,7 +383,7 @@ void GMSH_LevelsetPlugin::_cutAndAddElements(PViewData *vdata, PViewData *wdata,
             yp[np] = y[n[nod]];
             zp[np] = z[n[nod]];
             for(int comp = 0; comp < numComp; comp++)
-              wdata->getValue(otherstep, ent, ele, n[nod], comp, valp[np][comp]);
+              valp[np][comp] = val[n[nod] * numComp + comp];
             ep[np] = -(nod + 1); // store node num!
             np++;
           }
@@ -412,17 +398,178 @@ void GMSH_LevelsetPlugin::_cutAndAddElements(PViewData *vdata, PViewData *wdata,
       }
 
       // finally, add the new element
-      _addElement(np, numEdges, numComp, xp, yp, zp, valp, out, step == stepmin);
+      _addElement(np, numEdges, numComp, xp, yp, zp, valp, out, step == 0);
 
     }
+  }
+}
 
-    if(vstep < 0){
-      for(int i = stepmin; i < stepmax; i++) {
-	out->Time.push_back(vdata->getTime(i));
+// The elements of the view are cut by chunks: the nodes of the elements of a
+// chunk are read (the accessors of the view data are not thread-safe), the
+// levelset is evaluated on all the nodes at once, the elements with no sign
+// change are rejected, and the field values of the remaining ones are read;
+// the cut is then done in parallel, each thread cutting a contiguous range of
+// elements into its own output, and the outputs are appended to the view in
+// thread order, so that the elements are in the same order as with one
+// thread.
+void GMSH_LevelsetPlugin::_cutView(PViewData *vdata, PViewData *wdata,
+                                   int vstep, int wstep, PViewDataList *out) const
+{
+  int stepmin = vstep, stepmax = vstep + 1;
+  if(vstep < 0){
+    stepmin = vdata->getFirstNonEmptyTimeStep();
+    stepmax = vdata->getNumTimeSteps();
+  }
+  const int numSteps = std::max(0, stepmax - stepmin);
+  const int compStep = (wstep < 0) ? wdata->getFirstNonEmptyTimeStep() : wstep;
+  std::vector<int> otherSteps(numSteps);
+  for(int step = 0; step < numSteps; step++){
+    otherSteps[step] = (wstep < 0) ? stepmin + step : wstep;
+    if(!wdata->hasTimeStep(otherSteps[step])) otherSteps[step] = -1;
+  }
+
+  const int chunkSize = 65536;
+  std::vector<int> ents, eles, types, numNodes, numEdges, numComps;
+  std::vector<double> X, Y, Z, S, L;
+  std::vector<int> cut, offsets;
+  std::vector<double> W;
+  std::vector<cutOutput> outputs(Msg::GetMaxThreads());
+
+  int N[24];
+  std::vector<double> *V[24];
+  out->getListPointers(N, V);
+
+  const int numEnt = vdata->getNumEntities(stepmin);
+  int ent = 0, ele = 0;
+  while(ent < numEnt){
+    // read the nodes of the next chunk of elements
+    ents.clear();
+    eles.clear();
+    types.clear();
+    numNodes.clear();
+    numEdges.clear();
+    numComps.clear();
+    X.clear();
+    Y.clear();
+    Z.clear();
+    S.clear();
+    while(ent < numEnt && (int)ents.size() < chunkSize){
+      if(ele >= vdata->getNumElements(stepmin, ent)){
+        ent++;
+        ele = 0;
+        continue;
+      }
+      if(!vdata->skipElement(stepmin, ent, ele)){
+        const int nn = vdata->getNumNodes(stepmin, ent, ele);
+        ents.push_back(ent);
+        eles.push_back(ele);
+        types.push_back(vdata->getType(stepmin, ent, ele));
+        numNodes.push_back(nn);
+        numEdges.push_back(vdata->getNumEdges(stepmin, ent, ele));
+        numComps.push_back(wdata->getNumComponents(compStep, ent, ele));
+        for(int nod = 0; nod < 8; nod++){
+          double x = 0., y = 0., z = 0., s = 0.;
+          if(nod < nn){
+            vdata->getNode(stepmin, ent, ele, nod, x, y, z);
+            if(vstep >= 0) vdata->getScalarValue(vstep, ent, ele, nod, s);
+          }
+          X.push_back(x);
+          Y.push_back(y);
+          Z.push_back(z);
+          S.push_back(s);
+        }
+      }
+      ele++;
+    }
+    const int numEl = ents.size();
+    if(!numEl) break;
+
+    // evaluate the levelset on all the nodes (and on the unused slots of the
+    // elements with less than 8 nodes), and keep the elements that change
+    // sign (or are on the extracted side of the levelset)
+    L.resize(X.size());
+    cut.resize(numEl);
+#if defined(_OPENMP)
+#pragma omp parallel
+#endif
+    {
+      const int thread = Msg::GetThreadNum();
+      const int numThreads = Msg::GetNumThreads();
+      const int begin = (long)numEl * thread / numThreads;
+      const int end = (long)numEl * (thread + 1) / numThreads;
+      if(end > begin)
+        levelsetValues(8 * (end - begin), &X[8 * begin], &Y[8 * begin],
+                       &Z[8 * begin], &S[8 * begin], &L[8 * begin]);
+      for(int i = begin; i < end; i++){
+        double lmin = L[8 * i], lmax = L[8 * i];
+        for(int nod = 1; nod < numNodes[i]; nod++){
+          lmin = std::min(lmin, L[8 * i + nod]);
+          lmax = std::max(lmax, L[8 * i + nod]);
+        }
+        cut[i] = (lmin <= 0. && lmax >= 0.) ||
+          (_extractVolume < 0 && lmax <= 0.) || (_extractVolume > 0 && lmin >= 0.);
+      }
+    }
+
+    // read the field values of the kept elements
+    int numCut = 0;
+    offsets.clear();
+    W.clear();
+    for(int i = 0; i < numEl; i++){
+      if(!cut[i]) continue;
+      cut[numCut++] = i;
+      offsets.push_back(W.size());
+      for(int step = 0; step < numSteps; step++){
+        if(otherSteps[step] < 0) continue;
+        for(int nod = 0; nod < numNodes[i]; nod++){
+          for(int comp = 0; comp < numComps[i]; comp++){
+            double v;
+            wdata->getValue(otherSteps[step], ents[i], eles[i], nod, comp, v);
+            W.push_back(v);
+          }
+        }
       }
     }
 
+#if defined(_OPENMP)
+#pragma omp parallel
+#endif
+    {
+      const int thread = Msg::GetThreadNum();
+      const int numThreads = Msg::GetNumThreads();
+      const int begin = (long)numCut * thread / numThreads;
+      const int end = (long)numCut * (thread + 1) / numThreads;
+      cutOutput &o = outputs[thread];
+      std::vector<const double*> values(numSteps);
+      for(int k = begin; k < end; k++){
+        const int i = cut[k];
+        const double *w = W.empty() ? 0 : &W[offsets[k]];
+        for(int step = 0; step < numSteps; step++){
+          if(otherSteps[step] < 0){
+            values[step] = 0;
+            continue;
+          }
+          values[step] = w;
+          w += numNodes[i] * numComps[i];
+        }
+        _cutAndAddElements(types[i], numNodes[i], numEdges[i], numComps[i],
+                           numSteps, numSteps ? &values[0] : 0, &X[8 * i],
+                           &Y[8 * i], &Z[8 * i], &L[8 * i], &S[8 * i], o);
+      }
+    }
+    for(unsigned int t = 0; t < outputs.size(); t++){
+      outputs[t].appendTo(N, V);
+      outputs[t].clear();
+    }
+  }
+
+  if(vstep < 0){
+    for(int i = stepmin; i < stepmax; i++)
+      out->Time.push_back(vdata->getTime(i));
   }
+
+  // set the number of elements of the lists, and finalize the view
+  out->importLists(N, V);
 }
 
 PView *GMSH_LevelsetPlugin::execute(PView *v)
@@ -462,52 +609,25 @@ PView *GMSH_LevelsetPlugin::execute(PView *v)
   // Force creation of one view per time step if we have multi meshes
   if(vdata->hasMultipleMeshes()) _valueIndependent = 0;
 
-  double x[8], y[8], z[8], levels[8];
-  double scalarValues[8] = {0., 0., 0., 0., 0., 0., 0., 0.};
-
   if(_valueIndependent) {
     // create a single output view containing the (possibly
     // multi-step) levelset
-    int firstNonEmptyStep = vdata->getFirstNonEmptyTimeStep();
     PViewDataList *out = getDataList(new PView());
-    for(int ent = 0; ent < vdata->getNumEntities(firstNonEmptyStep); ent++){
-      for(int ele = 0; ele < vdata->getNumElements(firstNonEmptyStep, ent); ele++){
-        if(vdata->skipElement(firstNonEmptyStep, ent, ele)) continue;
-        for(int nod = 0; nod < vdata->getNumNodes(firstNonEmptyStep, ent, ele); nod++){
-          vdata->getNode(firstNonEmptyStep, ent, ele, nod, x[nod], y[nod], z[nod]);
-          levels[nod] = levelset(x[nod], y[nod], z[nod], 0.);
-        }
-        _cutAndAddElements(vdata, wdata, ent, ele, -1, _valueTimeStep, x, y, z,
-                           levels, scalarValues, out);
-      }
-    }
+    _cutView(vdata, wdata, -1, _valueTimeStep, out);
     out->setName(vdata->getName() + "_Levelset");
     out->setFileName(vdata->getFileName() + "_Levelset.pos");
-    out->finalize();
   }
   else{
     // create one view per timestep
     for(int step = 0; step < vdata->getNumTimeSteps(); step++){
       if(!vdata->hasTimeStep(step)) continue;
       PViewDataList *out = getDataList(new PView());
-      for(int ent = 0; ent < vdata->getNumEntities(step); ent++){
-        for(int ele = 0; ele < vdata->getNumElements(step, ent); ele++){
-          if(vdata->skipElement(step, ent, ele)) continue;
-          for(int nod = 0; nod < vdata->getNumNodes(step, ent, ele); nod++){
-            vdata->getNode(step, ent, ele, nod, x[nod], y[nod], z[nod]);
-            vdata->getScalarValue(step, ent, ele, nod, scalarValues[nod]);
-            levels[nod] = levelset(x[nod], y[nod], z[nod], scalarValues[nod]);
-          }
-          int wstep = (_valueTimeStep < 0) ? step : _valueTimeStep;
-          _cutAndAddElements(vdata, wdata, ent, ele, step, wstep, x, y, z,
-                             levels, scalarValues, out);
-        }
-      }
+      int wstep = (_valueTimeStep < 0) ? step : _valueTimeStep;
+      _cutView(vdata, wdata, step, wstep, out);
       char tmp[246];
       sprintf(tmp, "_Levelset_%d", step);
       out->setName(vdata->getName() + tmp);
       out->setFileName(vdata->getFileName() + tmp + ".pos");
-      out->finalize();
     }
   }
 
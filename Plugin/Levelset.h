@@ -11,16 +11,27 @@
 class GMSH_LevelsetPlugin : public GMSH_PostPlugin
 {
  private:
-  double _invert;
+  // elements cut by a thread, stored in lists indexed as in
+  // PViewDataList::getListPointers(), and appended to the output view once
+  // a chunk of elements has been cut
+  class cutOutput {
+   public:
+    int num[24];
+    std::vector<double> lists[24];
+    cutOutput(){ clear(); }
+    void clear();
+    void appendTo(int N[24], std::vector<double> *V[24]) const;
+  };
   void _addElement(int np, int numEdges, int numComp,
                    double xp[12], double yp[12], double zp[12],
-                   double valp[12][9], PViewDataList *out,
-                   bool firstStep);
-  void _cutAndAddElements(PViewData *vdata, PViewData *wdata,
-                          int ent, int ele, int step, int wstep,
+                   double valp[12][9], cutOutput &out, bool firstStep) const;
+  void _cutAndAddElements(int type, int numNodes, int numEdges, int numComp,
+                          int numSteps, const double *const *values,
                           double x[8], double y[8], double z[8],
                           double levels[8], double scalarValues[8],
-                          PViewDataList *out);
+                          cutOutput &out) const;
+  void _cutView(PViewData *vdata, PViewData *wdata, int vstep, int wstep,
+                PViewDataList *out) const;
  protected:
   double _ref[3], _targetError;
   int _valueTimeStep, _valueView, _valueIndependent, _recurLevel, _extractVolume;
@@ -29,6 +40,11 @@ class GMSH_LevelsetPlugin : public GMSH_PostPlugin
  public:
   GMSH_LevelsetPlugin();
   virtual double levelset(double x, double y, double z, double val) const = 0;
+  // evaluate the levelset at n points at once (override with a loop that the
+  // compiler can vectorize)
+  virtual void levelsetValues(int n, const double *x, const double *y,
+                              const double *z, const double *val,
+                              double *levels) const;
   virtual PView *execute(PView *);
   void assignSpecificVisibility() const;
 };
@@ -91,6 +91,52 @@ StringXString *GMSH_MathEvalPlugin::getOptionStr(int iopt)
   return &MathEvalOptions_String[iopt];
 }
 
+static const int evalChunkSize = 65536;
+
+class evalChunk {
+ public:
+  std::vector<std::vector<double> > values;
+ private:
+  std::vector<std::vector<double> *> _outs;
+  std::vector<int> _offsets, _numValues;
+  bool _failed;
+ public:
+  evalChunk(int numVariables) : values(numVariables), _failed(false) {}
+  // register the values gathered since the last call as belonging to the list
+  // out, and reserve the corresponding slots (initialized to zero)
+  void add(std::vector<double> *out, int numComp)
+  {
+    int n = values[0].size() - (_numValues.empty() ? 0 : _numValues.back());
+    _outs.push_back(out);
+    _offsets.push_back(out->size());
+    _numValues.push_back(values[0].size());
+    out->resize(out->size() + n * numComp, 0.);
+  }
+  // evaluate the expressions for all the gathered values and fill the
+  // reserved slots; if the evaluation fails the slots are left to zero
+  void eval(mathEvaluator &f, int numComp)
+  {
+    if(_outs.empty()) return;
+    std::vector<std::vector<double> > res;
+    if(f.eval(values, res) && (int)res.size() == numComp){
+      for(unsigned int i = 0, k = 0; i < _outs.size(); i++){
+        std::vector<double> &out(*_outs[i]);
+        for(int c = _offsets[i]; (int)k < _numValues[i]; k++)
+          for(int j = 0; j < numComp; j++)
+            out[c++] = res[j][k];
+      }
+    }
+    else if(!_failed){
+      Msg::Error("Could not evaluate expression(s): using zero value(s)");
+      _failed = true;
+    }
+    for(unsigned int i = 0; i < values.size(); i++) values[i].clear();
+    _outs.clear();
+    _offsets.clear();
+    _numValues.clear();
+  }
+};
+
 PView *GMSH_MathEvalPlugin::execute(PView *view)
 {
   int timeStep = (int)MathEvalOptions_Number[0].def;
@@ -161,7 +207,12 @@ PView *GMSH_MathEvalPlugin::execute(PView *view)
   for(unsigned int i = 0; i < numVariables; i++) variables[i] = names[i];
   mathEvaluator f(expr, variables);
   if(expr.empty()) return view;
-  std::vector<double> values(numVariables), res(numComp2);
+  // the values of the variables are gathered for the nodes (and time steps)
+  // of consecutive elements, and the expressions are evaluated for whole
+  // chunks of (about) evalChunkSize nodes at once; the slots for the results
+  // are reserved in the output lists right after the coordinates, so that the
+  // lists always stay consistent with the element counters
+  evalChunk chunk(numVariables);
 
   OctreePost *octree = 0;
   if(forceInterpolation ||
@@ -210,9 +261,10 @@ PView *GMSH_MathEvalPlugin::execute(PView *view)
       std::vector<double> x(numNodes), y(numNodes), z(numNodes);
       for(int nod = 0; nod < numNodes; nod++)
         data1->getNode(timeBeg, ent, ele, nod, x[nod], y[nod], z[nod]);
-      for(int nod = 0; nod < numNodes; nod++) out->push_back(x[nod]);
-      for(int nod = 0; nod < numNodes; nod++) out->push_back(y[nod]);
-      for(int nod = 0; nod < numNodes; nod++) out->push_back(z[nod]);
+      out->insert(out->end(), x.begin(), x.end());
+      out->insert(out->end(), y.begin(), y.end());
+      out->insert(out->end(), z.begin(), z.end());
+      std::vector<std::vector<double> > &values(chunk.values);
       for(int step = timeBeg; step < timeEnd; step++){
 	if(!data1->hasTimeStep(step)) continue;
         int step2 = (otherTimeStep < 0) ? step : otherTimeStep;
@@ -233,22 +285,20 @@ PView *GMSH_MathEvalPlugin::execute(PView *view)
               for(int comp = 0; comp < otherNumComp; comp++)
                 otherData->getValue(step2, ent, ele, nod, comp, w[comp]);
           }
-          values[0] = x[nod]; values[1] = y[nod]; values[2] = z[nod];
-          for(int i = 0; i < 9; i++) values[3 + i] = v[i];
-          for(int i = 0; i < 9; i++) values[12 + i] = w[i];
-          if(f.eval(values, res)){
-            for(int i = 0; i < numComp2; i++)
-              out->push_back(res[i]);
-          }
-          else{
-            goto end;
-          }
+          values[0].push_back(x[nod]);
+          values[1].push_back(y[nod]);
+          values[2].push_back(z[nod]);
+          for(int i = 0; i < 9; i++) values[3 + i].push_back(v[i]);
+          for(int i = 0; i < 9; i++) values[12 + i].push_back(w[i]);
+          values[21].push_back(0.);
         }
       }
+      chunk.add(out, numComp2);
+      if((int)values[0].size() >= evalChunkSize) chunk.eval(f, numComp2);
     }
   }
+  chunk.eval(f, numComp2);
 
- end:
   if(octree) delete octree;
 
   if(timeStep < 0){
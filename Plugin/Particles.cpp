@@ -244,31 +244,44 @@ PView *GMSH_ParticlesPlugin::execute(PView *v)
   double c3 = (-A2 - (gamma - 1) * DT * A1 - (0.5 - gamma + beta) * DT * DT * A0);
   double c4 = DT * DT * (beta + (0.5 + gamma - 2 * beta) + (0.5 - gamma + beta));
 
+  // all the particles are moved together: the force is interpolated at all
+  // the particles with one batch search (which is performed in parallel),
+  // starting with the elements in which each particle was previously found
+  int numParticles = getNbU() * getNbV();
+  std::vector<SPoint3> XINIT(numParticles), X0(numParticles), X1(numParticles);
   for(int i = 0; i < getNbU(); ++i){
     for(int j = 0; j < getNbV(); ++j){
-      double XINIT[3], X0[3], X1[3];
-      getPoint(i, j, XINIT);
-      getPoint(i, j, X0);
-      getPoint(i, j, X1);
-      data2->NbVP++;
-      data2->VP.push_back(XINIT[0]);
-      data2->VP.push_back(XINIT[1]);
-      data2->VP.push_back(XINIT[2]);
-      for(int iter = 0; iter < maxIter; iter++){
-        double F[3], X[3];
-        o1.searchVector(X1[0], X1[1], X1[2], F, timeStep);
-        for(int k = 0; k < 3; k++)
-          X[k] = (c2 * X1[k] + c3 * X0[k] + c4 * F[k]) / c1;
-        data2->VP.push_back(X[0] - XINIT[0]);
-        data2->VP.push_back(X[1] - XINIT[1]);
-        data2->VP.push_back(X[2] - XINIT[2]);
-        for(int k = 0; k < 3; k++){
-          X0[k] = X1[k];
-          X1[k] = X[k];
-        }        
-      }
+      double p[3];
+      getPoint(i, j, p);
+      int n = i * getNbV() + j;
+      XINIT[n] = X0[n] = X1[n] = SPoint3(p);
     }
   }
+  std::vector<std::vector<double> > out(numParticles);
+  for(int n = 0; n < numParticles; n++){
+    out[n].push_back(XINIT[n].x());
+    out[n].push_back(XINIT[n].y());
+    out[n].push_back(XINIT[n].z());
+  }
+  std::vector<double> F;
+  std::vector<void*> hints;
+  for(int iter = 0; iter < maxIter; iter++){
+    o1.searchVector(X1, F, timeStep, 0, 0., &hints);
+    for(int n = 0; n < numParticles; n++){
+      double X[3];
+      for(int k = 0; k < 3; k++)
+        X[k] = (c2 * X1[n][k] + c3 * X0[n][k] + c4 * F[3 * n + k]) / c1;
+      out[n].push_back(X[0] - XINIT[n].x());
+      out[n].push_back(X[1] - XINIT[n].y());
+      out[n].push_back(X[2] - XINIT[n].z());
+      X0[n] = X1[n];
+      X1[n] = SPoint3(X);
+    }
+  }
+  for(int n = 0; n < numParticles; n++){
+    data2->NbVP++;
+    data2->VP.insert(data2->VP.end(), out[n].begin(), out[n].end());
+  }
 
   v2->getOptions()->vectorType = PViewOptions::Displacement;
 
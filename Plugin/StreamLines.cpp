@@ -220,97 +220,156 @@ PView *GMSH_StreamLinesPlugin::execute(PView *v)
   }
 
   OctreePost o1(v1);
-  double *val2 = 0;
-  OctreePost *o2 = 0;
-  if(data2){
-    val2 = new double[data2->getNumTimeSteps()];
-    o2 = new OctreePost(v2);
-  }
+  OctreePost *o2 = data2 ? new OctreePost(v2) : 0;
+  int numSteps2 = data2 ? data2->getNumTimeSteps() : 0;
 
   PView *v3 = new PView();
   PViewDataList *data3 = getDataList(v3);
 
   const double b1 = 1. / 3., b2 = 2. / 3., b3 = 1. / 3., b4 = 1. / 6.;
   const double a1 = 0.5, a2 = 0.5, a3 = 1., a4 = 1.;
-  double XINIT[3], X[3], DX[3], X1[3], X2[3], X3[3], X4[3];
 
+  // all the seeds are integrated together: the velocity at each stage of the
+  // scheme is interpolated at all the seeds with one batch search (which is
+  // performed in parallel), starting with the elements in which each seed
+  // was found at the previous search
+  int numSeeds = getNbU() * getNbV();
+  std::vector<SPoint3> XINIT(numSeeds), X(numSeeds);
   for(int i = 0; i < getNbU(); ++i){
     for(int j = 0; j < getNbV(); ++j){
-      getPoint(i, j, XINIT);
-      getPoint(i, j, X);
-          
-      if(data2){
-        o2->searchScalar(X[0], X[1], X[2], val2, -1);
-      }
-      else{
-        data3->NbVP++;
-        data3->VP.push_back(X[0]);
-        data3->VP.push_back(X[1]);
-        data3->VP.push_back(X[2]);
-      }
+      double p[3];
+      getPoint(i, j, p);
+      XINIT[i * getNbV() + j] = X[i * getNbV() + j] = SPoint3(p);
+    }
+  }
 
-      int currentTimeStep = 0;
+  // output data of each seed
+  std::vector<std::vector<double> > out(numSeeds);
+  std::vector<double> val2;
+  std::vector<void*> hints1, hints2;
+  if(data2){
+    o2->searchScalar(X, val2, -1, 0, 0., &hints2);
+  }
+  else{
+    for(int s = 0; s < numSeeds; s++){
+      out[s].push_back(X[s].x());
+      out[s].push_back(X[s].y());
+      out[s].push_back(X[s].z());
+    }
+  }
 
-      for(int iter = 0; iter < maxIter; iter++){
+  // seeds that can still move: in a steady flow, a seed that is outside of
+  // the view stays where it is (its velocity is zero), and does not need to
+  // be searched for anymore
+  std::vector<int> active(numSeeds);
+  for(int s = 0; s < numSeeds; s++) active[s] = s;
+
+  int currentTimeStep = 0;
+  std::vector<double> val, newVal2;
+  std::vector<int> found;
+  std::vector<SPoint3> X0, X1, X2, X3, X4;
+
+  for(int iter = 0; iter < maxIter; iter++){
+
+    if(timeStep < 0){
+      double T0 = data1->getTime(0);
+      double currentT = T0 + DT * iter;
+      data3->Time.push_back(currentT);
+      for(; currentTimeStep < data1->getNumTimeSteps() - 1 &&
+            currentT > 0.5 * (data1->getTime(currentTimeStep) +
+                              data1->getTime(currentTimeStep + 1));
+          currentTimeStep++);
+    }
+    else{
+      currentTimeStep = timeStep;
+    }
 
-        double XPREV[3] = {X[0], X[1], X[2]};
+    std::vector<SPoint3> XPREV(X);
+    std::vector<double> val2PREV(val2);
+
+    // dX/dt = V
+    // X1 = X + a1 * DT * V(X)
+    // X2 = X + a2 * DT * V(X1)
+    // X3 = X + a3 * DT * V(X2)
+    // X4 = X + a4 * DT * V(X3)
+    // X = X + b1 X1 + b2 X2 + b3 X3 + b4 x4
+    int n = active.size();
+    X0.resize(n); X1.resize(n); X2.resize(n); X3.resize(n); X4.resize(n);
+    for(int i = 0; i < n; i++) X0[i] = X[active[i]];
+    o1.searchVector(X0, val, currentTimeStep, &found, 0., &hints1);
+    for(int i = 0; i < n; i++)
+      for(int k = 0; k < 3; k++) X1[i][k] = X0[i][k] + DT * val[3 * i + k] * a1;
+    o1.searchVector(X1, val, currentTimeStep, 0, 0., &hints1);
+    for(int i = 0; i < n; i++)
+      for(int k = 0; k < 3; k++) X2[i][k] = X0[i][k] + DT * val[3 * i + k] * a2;
+    o1.searchVector(X2, val, currentTimeStep, 0, 0., &hints1);
+    for(int i = 0; i < n; i++)
+      for(int k = 0; k < 3; k++) X3[i][k] = X0[i][k] + DT * val[3 * i + k] * a3;
+    o1.searchVector(X3, val, currentTimeStep, 0, 0., &hints1);
+    for(int i = 0; i < n; i++)
+      for(int k = 0; k < 3; k++) X4[i][k] = X0[i][k] + DT * val[3 * i + k] * a4;
+
+    for(int i = 0; i < n; i++){
+      SPoint3 &x = X[active[i]];
+      for(int k = 0; k < 3; k++)
+        x[k] += (b1 * (X1[i][k] - x[k]) + b2 * (X2[i][k] - x[k]) +
+                 b3 * (X3[i][k] - x[k]) + b4 * (X4[i][k] - x[k]));
+      X0[i] = x;
+    }
 
-        if(timeStep < 0){
-          double T0 = data1->getTime(0);
-          double currentT = T0 + DT * iter;
-          data3->Time.push_back(currentT);
-          for(; currentTimeStep < data1->getNumTimeSteps() - 1 && 
-                currentT > 0.5 * (data1->getTime(currentTimeStep) + 
-                                  data1->getTime(currentTimeStep + 1));
-          currentTimeStep++);
-        }
-        else{
-          currentTimeStep = timeStep;
-        }
+    if(data2){
+      o2->searchScalar(X0, newVal2, -1, 0, 0., &hints2);
+      for(int i = 0; i < n; i++)
+        for(int k = 0; k < numSteps2; k++)
+          val2[active[i] * numSteps2 + k] = newVal2[i * numSteps2 + k];
+      for(int s = 0; s < numSeeds; s++){
+        std::vector<double> &o = out[s];
+        o.push_back(XPREV[s].x()); o.push_back(X[s].x());
+        o.push_back(XPREV[s].y()); o.push_back(X[s].y());
+        o.push_back(XPREV[s].z()); o.push_back(X[s].z());
+        for(int k = 0; k < numSteps2; k++)
+          o.push_back(val2PREV[s * numSteps2 + k]);
+        for(int k = 0; k < numSteps2; k++)
+          o.push_back(val2[s * numSteps2 + k]);
+      }
+    }
+    else{
+      for(int s = 0; s < numSeeds; s++){
+        out[s].push_back(X[s].x() - XINIT[s].x());
+        out[s].push_back(X[s].y() - XINIT[s].y());
+        out[s].push_back(X[s].z() - XINIT[s].z());
+      }
+    }
 
-        // dX/dt = V
-        // X1 = X + a1 * DT * V(X)
-        // X2 = X + a2 * DT * V(X1)
-        // X3 = X + a3 * DT * V(X2)
-        // X4 = X + a4 * DT * V(X3)
-        // X = X + b1 X1 + b2 X2 + b3 X3 + b4 x4
-        double val[3];
-        o1.searchVector(X[0], X[1], X[2], val, currentTimeStep);
-        for(int k = 0; k < 3; k++) X1[k] = X[k] + DT * val[k] * a1;
-        o1.searchVector(X1[0], X1[1], X1[2], val, currentTimeStep);
-        for(int k = 0; k < 3; k++) X2[k] = X[k] + DT * val[k] * a2;
-        o1.searchVector(X2[0], X2[1], X2[2], val, currentTimeStep);
-        for(int k = 0; k < 3; k++) X3[k] = X[k] + DT * val[k] * a3;
-        o1.searchVector(X3[0], X3[1], X3[2], val, currentTimeStep);
-        for(int k = 0; k < 3; k++) X4[k] = X[k] + DT * val[k] * a4;
-
-        for(int k = 0; k < 3; k++) 
-          X[k] += (b1 * (X1[k] - X[k]) + b2 * (X2[k] - X[k]) + 
-                   b3 * (X3[k] - X[k]) + b4 * (X4[k] - X[k]));
-        for(int k = 0; k < 3; k++) DX[k] = X[k] - XINIT[k];
-
-        if(data2){
-          data3->NbSL++;
-          data3->SL.push_back(XPREV[0]); data3->SL.push_back(X[0]);
-          data3->SL.push_back(XPREV[1]); data3->SL.push_back(X[1]);
-          data3->SL.push_back(XPREV[2]); data3->SL.push_back(X[2]);
-          for(int k = 0; k < data2->getNumTimeSteps(); k++)
-            data3->SL.push_back(val2[k]);
-          o2->searchScalar(X[0], X[1], X[2], val2, -1);
-          for(int k = 0; k < data2->getNumTimeSteps(); k++)
-            data3->SL.push_back(val2[k]);
-        }
-        else{
-          data3->VP.push_back(DX[0]);
-          data3->VP.push_back(DX[1]);
-          data3->VP.push_back(DX[2]);
+    if(timeStep >= 0){
+      int m = 0;
+      for(int i = 0; i < n; i++){
+        if(!found[i]) continue;
+        active[m] = active[i];
+        for(int k = 0; k < 9; k++){
+          hints1[9 * m + k] = hints1[9 * i + k];
+          if(data2) hints2[9 * m + k] = hints2[9 * i + k];
         }
+        m++;
       }
+      active.resize(m);
+      hints1.resize(9 * m);
+      if(data2) hints2.resize(9 * m);
+    }
+  }
+
+  for(int s = 0; s < numSeeds; s++){
+    if(data2){
+      data3->NbSL += maxIter;
+      data3->SL.insert(data3->SL.end(), out[s].begin(), out[s].end());
+    }
+    else{
+      data3->NbVP++;
+      data3->VP.insert(data3->VP.end(), out[s].begin(), out[s].end());
     }
   }
 
   if(data2){
-    delete [] val2;
     delete o2;
   }
   else{
@@ -365,7 +365,8 @@ void OctreePost::_create(PViewData *data)
 }
 
 static void *getElement(double P[3], Octree *octree, int nbNod,
-                        int qn, double *qx, double *qy, double *qz)
+                        int qn, double *qx, double *qy, double *qz,
+                        void **hint)
 {
   if(qn && qx && qy && qz){
     std::vector<void*> v;
@@ -387,14 +388,45 @@ static void *getElement(double P[3], Octree *octree, int nbNod,
     }
     if(v.size()) return v[0];
   }
+  else if(hint){
+    return Octree_SearchFrom(P, octree, hint);
+  }
   else{
     return Octree_Search(P, octree);
   }
   return 0;
 }
 
+// check if the element used as a hint contains the point: the point must be
+// in the (tolerance-enlarged) bounding box of the element, and lie on the
+// element if it is of lower dimension than the space (xyz2uvw projects the
+// point on the element, so that e.g. a triangle would otherwise "contain" all
+// the points of the prism it spans)
+static bool hintContains(MElement *e, double P[3])
+{
+  double eps = CTX::instance()->geom.tolerance;
+  for(int i = 0; i < 3; i++){
+    double min = e->getVertex(0)->point()[i], max = min;
+    for(int j = 1; j < e->getNumVertices(); j++){
+      min = std::min(min, e->getVertex(j)->point()[i]);
+      max = std::max(max, e->getVertex(j)->point()[i]);
+    }
+    if(P[i] < min - eps || P[i] > max + eps) return false;
+  }
+  double U[3];
+  e->xyz2uvw(P, U);
+  if(!e->isInside(U[0], U[1], U[2])) return false;
+  if(e->getDim() < 3){
+    SPoint3 p;
+    e->pnt(U[0], U[1], U[2], p);
+    if(p.distance(SPoint3(P)) > eps) return false;
+  }
+  return true;
+}
+
 static MElement *getElement(double P[3], GModel *m,
-                            int qn, double *qx, double *qy, double *qz)
+                            int qn, double *qx, double *qy, double *qz,
+                            void **hint)
 {
   SPoint3 pt(P);
   if(qn && qx && qy && qz){
@@ -416,6 +448,15 @@ static MElement *getElement(double P[3], GModel *m,
     }
     if(elements.size()) return elements[0];
   }
+  else if(hint){
+    // start with the previous element, and only perform a strict search
+    // (which does not modify the element tolerance) if it does not match
+    MElement *e = (MElement*)*hint;
+    if(e && hintContains(e, P)) return e;
+    e = m->getMeshElementByCoord(pt, -1, true);
+    if(e) *hint = e;
+    return e;
+  }
   else{
     return m->getMeshElementByCoord(pt);
   }
@@ -496,191 +537,210 @@ bool OctreePost::_getValue(void *in, int nbComp, double P[3], int timestep,
   return true;
 }
 
-bool OctreePost::searchScalar(double x, double y, double z, double *values,
-                              int step, double *size,
-                              int qn, double *qx, double *qy, double *qz)
+bool OctreePost::_search(int nbComp, double P[3], double *values, int step,
+                         double *size, int qn, double *qx, double *qy,
+                         double *qz, void **hints)
 {
-  double P[3] = {x, y, z};
-
   if(step < 0){
     int numSteps = 1;
     if(_theViewDataList) numSteps = _theViewDataList->getNumTimeSteps();
     else if(_theViewDataGModel) numSteps = _theViewDataGModel->getNumTimeSteps();
-    for(int i = 0; i < numSteps; i++){
+    for(int i = 0; i < nbComp * numSteps; i++)
       values[i] = 0.0;
-    }
   }
   else
-    values[0] = 0.0;
+    for(int i = 0; i < nbComp; i++)
+      values[i] = 0.0;
 
   if(_theViewDataList){
-    if(_getValue(getElement(P, _SS, 4, qn, qx, qy, qz),
-                 3, 4, 1, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _SH, 8, qn, qx, qy, qz),
-                 3, 8, 1, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _SI, 6, qn, qx, qy, qz),
-                 3, 6, 1, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _SY, 5, qn, qx, qy, qz),
-                 3, 5, 1, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _ST, 3, qn, qx, qy, qz),
-                 2, 3, 1, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _SQ, 4, qn, qx, qy, qz),
-                 2, 4, 1, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _SL, 2, qn, qx, qy, qz),
-                 1, 2, 1, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _SPP, 1, qn, qx, qy, qz),
-                 0, 1, 1, P, step, values, size)) return true;
+    // element types are tried in this order
+    static const int dim[8] = {3, 3, 3, 3, 2, 2, 1, 0};
+    static const int nbNod[8] = {4, 8, 6, 5, 3, 4, 2, 1};
+    Octree *octrees[8];
+    if(nbComp == 1){
+      octrees[0] = _SS; octrees[1] = _SH; octrees[2] = _SI; octrees[3] = _SY;
+      octrees[4] = _ST; octrees[5] = _SQ; octrees[6] = _SL; octrees[7] = _SPP;
+    }
+    else if(nbComp == 3){
+      octrees[0] = _VS; octrees[1] = _VH; octrees[2] = _VI; octrees[3] = _VY;
+      octrees[4] = _VT; octrees[5] = _VQ; octrees[6] = _VL; octrees[7] = _VPP;
+    }
+    else{
+      octrees[0] = _TS; octrees[1] = _TH; octrees[2] = _TI; octrees[3] = _TY;
+      octrees[4] = _TT; octrees[5] = _TQ; octrees[6] = _TL; octrees[7] = _TPP;
+    }
+    for(int i = 0; i < 8; i++){
+      if(_getValue(getElement(P, octrees[i], nbNod[i], qn, qx, qy, qz,
+                              hints ? &hints[i] : 0),
+                   dim[i], nbNod[i], nbComp, P, step, values, size))
+        return true;
+    }
   }
   else if(_theViewDataGModel){
     GModel *m = _theViewDataGModel->getModel((step < 0) ? 0 : step);
     if(m){
-      if(_getValue(getElement(P, m, qn, qx, qy, qz),
-                   1, P, step, values, size)) return true;
+      if(_getValue(getElement(P, m, qn, qx, qy, qz, hints ? &hints[8] : 0),
+                   nbComp, P, step, values, size)) return true;
     }
   }
 
   return false;
 }
 
-bool OctreePost::searchScalarWithTol(double x, double y, double z, double *values,
-                                     int step, double *size, double tol,
-                                     int qn, double *qx, double *qy, double *qz)
+bool OctreePost::_searchWithTol(int nbComp, double P[3], double *values,
+                                int step, double *size, double tol,
+                                int qn, double *qx, double *qy, double *qz)
 {
-  bool a = searchScalar(x, y, z, values, step, size, qn, qx, qy, qz);
+  bool a = _search(nbComp, P, values, step, size, qn, qx, qy, qz);
   if(!a && tol != 0.){
     double oldtol1 = element::getTolerance();
     double oldtol2 = MElement::getTolerance();
     element::setTolerance(tol);
     MElement::setTolerance(tol);
-    a = searchScalar(x, y, z, values, step, size, qn, qx, qy, qz);
+    a = _search(nbComp, P, values, step, size, qn, qx, qy, qz);
     element::setTolerance(oldtol1);
     MElement::setTolerance(oldtol2);
   }
   return a;
 }
 
-bool OctreePost::searchVector(double x, double y, double z, double *values,
-                              int step, double *size,
-                              int qn, double *qx, double *qy, double *qz)
+int OctreePost::_search(int nbComp, const std::vector<SPoint3> &points,
+                        std::vector<double> &values, int step,
+                        std::vector<int> *found, double tol,
+                        std::vector<void*> *hints)
 {
-  double P[3] = {x, y, z};
-
+  int numSteps = 1;
   if(step < 0){
-    int numSteps = 1;
     if(_theViewDataList) numSteps = _theViewDataList->getNumTimeSteps();
     else if(_theViewDataGModel) numSteps = _theViewDataGModel->getNumTimeSteps();
-    for(int i = 0; i < 3 * numSteps; i++)
-      values[i] = 0.0;
   }
-  else
-    for(int i = 0; i < 3; i++)
-      values[i] = 0.0;
-
-  if(_theViewDataList){
-    if(_getValue(getElement(P, _VS, 4, qn, qx, qy, qz),
-                 3, 4, 3, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _VH, 8, qn, qx, qy, qz),
-                 3, 8, 3, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _VI, 6, qn, qx, qy, qz),
-                 3, 6, 3, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _VY, 5, qn, qx, qy, qz),
-                 3, 5, 3, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _VT, 3, qn, qx, qy, qz),
-                 2, 3, 3, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _VQ, 4, qn, qx, qy, qz),
-                 2, 4, 3, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _VL, 2, qn, qx, qy, qz),
-                 1, 2, 3, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _VPP, 1, qn, qx, qy, qz),
-                 0, 1, 3, P, step, values, size)) return true;
+  const int nv = nbComp * numSteps;
+  const int n = points.size();
+  values.resize(n * nv);
+  std::vector<int> ok(n, 0);
+  if(!n){
+    if(found) found->swap(ok);
+    return 0;
   }
-  else if(_theViewDataGModel){
+  if(hints && (int)hints->size() != 9 * n)
+    hints->assign(9 * n, (void*)0);
+
+  if(_theViewDataGModel){
+    // make sure the element locator of the model is created before the
+    // concurrent queries
     GModel *m = _theViewDataGModel->getModel((step < 0) ? 0 : step);
     if(m){
-      if(_getValue(getElement(P, m, qn, qx, qy, qz),
-                   3, P, step, values, size)) return true;
+      SPoint3 pt(points[0]);
+      m->getMeshElementByCoord(pt, -1, true);
     }
   }
 
-  return false;
+  int numFound = 0;
+#if defined(_OPENMP)
+#pragma omp parallel reduction(+:numFound)
+#endif
+  {
+    // last elements found by this thread in each octree (and in the model),
+    // used as starting points for the next queries
+    void *threadHints[9] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+#if defined(_OPENMP)
+#pragma omp for schedule(dynamic, 256)
+#endif
+    for(int i = 0; i < n; i++){
+      double P[3] = {points[i].x(), points[i].y(), points[i].z()};
+      void **h = hints ? &(*hints)[9 * i] : threadHints;
+      if(_search(nbComp, P, &values[i * nv], step, 0, 0, 0, 0, 0, h)){
+        ok[i] = 1;
+        numFound++;
+      }
+    }
+  }
+
+  // the non-strict searches modify the global element tolerances, and are
+  // thus performed sequentially on the points that have not been found
+  if(numFound < n && (_theViewDataGModel || tol != 0.)){
+    for(int i = 0; i < n; i++){
+      if(ok[i]) continue;
+      double P[3] = {points[i].x(), points[i].y(), points[i].z()};
+      if(_searchWithTol(nbComp, P, &values[i * nv], step, 0, tol)){
+        ok[i] = 1;
+        numFound++;
+      }
+    }
+  }
+
+  if(found) found->swap(ok);
+  return numFound;
 }
 
-bool OctreePost::searchVectorWithTol(double x, double y, double z, double *values,
+bool OctreePost::searchScalar(double x, double y, double z, double *values,
+                              int step, double *size,
+                              int qn, double *qx, double *qy, double *qz)
+{
+  double P[3] = {x, y, z};
+  return _search(1, P, values, step, size, qn, qx, qy, qz);
+}
+
+bool OctreePost::searchScalarWithTol(double x, double y, double z, double *values,
                                      int step, double *size, double tol,
                                      int qn, double *qx, double *qy, double *qz)
 {
-  bool a = searchVector(x, y, z, values, step, size, qn, qx, qy, qz);
-  if(!a && tol != 0.){
-    double oldtol1 = element::getTolerance();
-    double oldtol2 = MElement::getTolerance();
-    element::setTolerance(tol);
-    MElement::setTolerance(tol);
-    a = searchVector(x, y, z, values, step, size, qn, qx, qy, qz);
-    element::setTolerance(oldtol1);
-    MElement::setTolerance(oldtol2);
-  }
-  return a;
+  double P[3] = {x, y, z};
+  return _searchWithTol(1, P, values, step, size, tol, qn, qx, qy, qz);
 }
 
-bool OctreePost::searchTensor(double x, double y, double z, double *values,
+int OctreePost::searchScalar(const std::vector<SPoint3> &points,
+                             std::vector<double> &values, int step,
+                             std::vector<int> *found, double tol,
+                             std::vector<void*> *hints)
+{
+  return _search(1, points, values, step, found, tol, hints);
+}
+
+bool OctreePost::searchVector(double x, double y, double z, double *values,
                               int step, double *size,
                               int qn, double *qx, double *qy, double *qz)
 {
   double P[3] = {x, y, z};
+  return _search(3, P, values, step, size, qn, qx, qy, qz);
+}
 
-  if(step < 0){
-    int numSteps = 1;
-    if(_theViewDataList) numSteps = _theViewDataList->getNumTimeSteps();
-    else if(_theViewDataGModel) numSteps = _theViewDataGModel->getNumTimeSteps();
-    for(int i = 0; i < 9 * numSteps; i++)
-      values[i] = 0.0;
-  }
-  else
-    for(int i = 0; i < 9; i++)
-      values[i] = 0.0;
+bool OctreePost::searchVectorWithTol(double x, double y, double z, double *values,
+                                     int step, double *size, double tol,
+                                     int qn, double *qx, double *qy, double *qz)
+{
+  double P[3] = {x, y, z};
+  return _searchWithTol(3, P, values, step, size, tol, qn, qx, qy, qz);
+}
 
-  if(_theViewDataList){
-    if(_getValue(getElement(P, _TS, 4, qn, qx, qy, qz),
-                 3, 4, 9, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _TH, 8, qn, qx, qy, qz),
-                 3, 8, 9, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _TI, 6, qn, qx, qy, qz),
-                 3, 6, 9, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _TY, 5, qn, qx, qy, qz),
-                 3, 5, 9, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _TT, 3, qn, qx, qy, qz),
-                 2, 3, 9, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _TQ, 4, qn, qx, qy, qz),
-                 2, 4, 9, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _TL, 2, qn, qx, qy, qz),
-                 1, 2, 9, P, step, values, size)) return true;
-    if(_getValue(getElement(P, _TPP, 1, qn, qx, qy, qz),
-                 0, 1, 9, P, step, values, size)) return true;
-  }
-  else if(_theViewDataGModel){
-    GModel *m = _theViewDataGModel->getModel((step < 0) ? 0 : step);
-    if(m){
-      if(_getValue(getElement(P, m, qn, qx, qy, qz),
-                   9, P, step, values, size)) return true;
-    }
-  }
+int OctreePost::searchVector(const std::vector<SPoint3> &points,
+                             std::vector<double> &values, int step,
+                             std::vector<int> *found, double tol,
+                             std::vector<void*> *hints)
+{
+  return _search(3, points, values, step, found, tol, hints);
+}
 
-  return false;
+bool OctreePost::searchTensor(double x, double y, double z, double *values,
+                              int step, double *size,
+                              int qn, double *qx, double *qy, double *qz)
+{
+  double P[3] = {x, y, z};
+  return _search(9, P, values, step, size, qn, qx, qy, qz);
 }
 
 bool OctreePost::searchTensorWithTol(double x, double y, double z, double *values,
                                      int step, double *size, double tol,
                                      int qn, double *qx, double *qy, double *qz)
 {
-  bool a = searchTensor(x, y, z, values, step, size, qn, qx, qy, qz);
-  if(!a && tol != 0.){
-    double oldtol1 = element::getTolerance();
-    double oldtol2 = MElement::getTolerance();
-    element::setTolerance(tol);
-    MElement::setTolerance(tol);
-    a = searchTensor(x, y, z, values, step, size, qn, qx, qy, qz);
-    element::setTolerance(oldtol1);
-    MElement::setTolerance(oldtol2);
-  }
-  return a;
+  double P[3] = {x, y, z};
+  return _searchWithTol(9, P, values, step, size, tol, qn, qx, qy, qz);
+}
+
+int OctreePost::searchTensor(const std::vector<SPoint3> &points,
+                             std::vector<double> &values, int step,
+                             std::vector<int> *found, double tol,
+                             std::vector<void*> *hints)
+{
+  return _search(9, points, values, step, found, tol, hints);
 }
@@ -6,7 +6,9 @@
 #ifndef _OCTREE_POST_H_
 #define _OCTREE_POST_H_
 
+#include <vector>
 #include "Octree.h"
+#include "SPoint3.h"
 
 class PView;
 class PViewData;
@@ -32,6 +34,16 @@ class OctreePost
                  double *elementSize);
   bool _getValue(void *in, int nbComp, double P[3], int step,
                  double *values, double *elementSize);
+  bool _search(int nbComp, double P[3], double *values, int step,
+               double *size, int qn=0, double *qx=0, double *qy=0,
+               double *qz=0, void **hints=0);
+  bool _searchWithTol(int nbComp, double P[3], double *values, int step,
+                      double *size, double tol, int qn=0, double *qx=0,
+                      double *qy=0, double *qz=0);
+  int _search(int nbComp, const std::vector<SPoint3> &points,
+              std::vector<double> &values, int step,
+              std::vector<int> *found, double tol,
+              std::vector<void*> *hints);
  public :
   OctreePost(PView *v);
   OctreePost(PViewData *data);
@@ -60,6 +72,29 @@ class OctreePost
   bool searchTensorWithTol(double x, double y, double z, double *values,
                            int step=-1, double *size=0, double tol=1.e-2,
                            int qn=0, double *qx=0, double *qy=0, double *qz=0);
+  // batch versions of the searches above: the values at points[i] are stored
+  // in values[i * nv], ..., values[i * nv + nv - 1], where nv is the number of
+  // components (1, 3 or 9) times the number of time steps if step < 0. Points
+  // are searched in parallel, each thread starting its searches with the last
+  // element it found. found[i] is set to 1 if points[i] was found (if tol is
+  // not 0, points that were not found are searched again with the given
+  // tolerance). If hints is given, the elements in which each point is found
+  // are stored in it, and the search of points[i] starts with the elements
+  // stored for index i by the previous call (instead of the last elements
+  // found by the thread): this is useful to follow moving points, e.g. along
+  // trajectories. Returns the number of points found.
+  int searchScalar(const std::vector<SPoint3> &points,
+                   std::vector<double> &values, int step=-1,
+                   std::vector<int> *found=0, double tol=0.,
+                   std::vector<void*> *hints=0);
+  int searchVector(const std::vector<SPoint3> &points,
+                   std::vector<double> &values, int step=-1,
+                   std::vector<int> *found=0, double tol=0.,
+                   std::vector<void*> *hints=0);
+  int searchTensor(const std::vector<SPoint3> &points,
+                   std::vector<double> &values, int step=-1,
+                   std::vector<int> *found=0, double tol=0.,
+                   std::vector<void*> *hints=0);
 };
 
 #endif
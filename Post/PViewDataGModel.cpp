@@ -85,6 +85,10 @@ static MElement *_getOneElementOfGivenType(GModel *m, int type)
 
 bool PViewDataGModel::finalize(bool computeMinMax, const std::string &interpolationScheme)
 {
+  if(getNumTimeSteps() && _steps[0]->getModel()->getCompactMesh())
+    Msg::Error("View based on a compact mesh: its data can only be saved in "
+               "MSH format");
+
   if(computeMinMax){
     _min = VAL_INF;
     _max = -VAL_INF;
@@ -10,6 +10,7 @@
 #include "MElement.h"
 #include "Numeric.h"
 #include "StringUtils.h"
+#include "compactMesh.h"
 #include "OS.h"
 
 bool PViewDataGModel::addData(GModel *model, std::map<int, std::vector<double> > &data,
@@ -148,6 +149,9 @@ bool PViewDataGModel::writeMSH(const std::string &fileName, double version, bool
   }
 
   GModel *model = _steps[0]->getModel();
+  // if the mesh has been compactified, the node and element indices are
+  // given by the compact mesh
+  compactMesh *cm = model->getCompactMesh();
 
   FILE *fp;
   if(saveMesh){
@@ -222,13 +226,13 @@ bool PViewDataGModel::writeMSH(const std::string &fileName, double version, bool
           fprintf(fp, "3\n%d\n%d\n%d\n", step, numComp, numEnt);
         for(int i = 0; i < _steps[step]->getNumData(); i++){
           if(_steps[step]->getData(i)){
-            MVertex *v = _steps[step]->getModel()->getMeshVertexByTag(i);
-            if(!v){
+            MVertex *v = cm ? 0 : _steps[step]->getModel()->getMeshVertexByTag(i);
+            int num = cm ? cm->getNodeIndexByNumber(i) : v ? v->getIndex() : 0;
+            if(cm ? !num : !v){
               Msg::Error("Unknown vertex %d in data", i);
               fclose(fp);
               return false;
             }
-            int num = v->getIndex();
             if(binary){
               fwrite(&num, sizeof(int), 1, fp);
               fwrite(_steps[step]->getData(i), sizeof(double), numComp, fp);
@@ -261,14 +265,15 @@ bool PViewDataGModel::writeMSH(const std::string &fileName, double version, bool
           fprintf(fp, "3\n%d\n%d\n%d\n", step, numComp, numEnt);
         for(int i = 0; i < _steps[step]->getNumData(); i++){
           if(_steps[step]->getData(i)){
-            MElement *e = model->getMeshElementByTag(i);
-            if(!e){
+            MElement *e = cm ? 0 : model->getMeshElementByTag(i);
+            int num = cm ? cm->getElementIndexByNumber(i) :
+              e ? model->getMeshElementIndex(e) : 0;
+            if(cm ? !num : !e){
               Msg::Error("Unknown element %d in data", i);
               fclose(fp);
               return false;
             }
             int mult = _steps[step]->getMult(i);
-            int num = model->getMeshElementIndex(e);
             if(binary){
               fwrite(&num, sizeof(int), 1, fp);
               if(_type == ElementNodeData)
@@ -527,43 +527,54 @@ static void generateConnectivities(std::vector<double> &list, int nbList, int nb
                                    int nbVert, int nbComp, smooth_data &data)
 {
   if(!nbList) return;
-  double *vals = new double[nbTimeStep * nbComp];
   int nb = list.size() / nbList;
-  for(unsigned int i = 0; i < list.size(); i += nb) {
-    double *x = &list[i];
-    double *y = &list[i + nbVert];
-    double *z = &list[i + 2 * nbVert];
-    double *v = &list[i + 3 * nbVert];
+  int n = nbTimeStep * nbComp;
+  std::vector<double> xyz(3 * nbList * nbVert), vals(n * nbList * nbVert);
+  for(int e = 0; e < nbList; e++) {
+    double *x = &list[e * nb];
+    double *y = &list[e * nb + nbVert];
+    double *z = &list[e * nb + 2 * nbVert];
+    double *v = &list[e * nb + 3 * nbVert];
     for(int j = 0; j < nbVert; j++) {
+      int p = e * nbVert + j;
+      xyz[3 * p] = x[j];
+      xyz[3 * p + 1] = y[j];
+      xyz[3 * p + 2] = z[j];
       for(int ts = 0; ts < nbTimeStep; ts++)
         for(int k = 0; k < nbComp; k++)
-          vals[nbComp * ts + k] = v[nbVert * nbComp * ts + nbComp * j + k];
-      data.add(x[j], y[j], z[j], nbTimeStep * nbComp, vals);
+          vals[n * p + nbComp * ts + k] = v[nbVert * nbComp * ts + nbComp * j + k];
     }
   }
-  delete [] vals;
+  data.add(nbList * nbVert, &xyz[0], n, &vals[0]);
 }
 
 static void smoothList(std::vector<double> &list, int nbList, int nbTimeStep,
-                       int nbVert, int nbComp, smooth_data &data)
+                       int nbVert, int nbComp, const smooth_data &data)
 {
   if(!nbList) return;
-  double *vals = new double[nbTimeStep * nbComp];
   int nb = list.size() / nbList;
-  for(unsigned int i = 0; i < list.size(); i += nb) {
-    double *x = &list[i];
-    double *y = &list[i + nbVert];
-    double *z = &list[i + 2 * nbVert];
-    double *v = &list[i + 3 * nbVert];
-    for(int j = 0; j < nbVert; j++) {
-      if(data.get(x[j], y[j], z[j], nbTimeStep * nbComp, vals)){
-        for(int ts = 0; ts < nbTimeStep; ts++)
-          for(int k = 0; k < nbComp; k++)
-            v[nbVert * nbComp * ts + nbComp * j + k] = vals[nbComp * ts + k];
+#if defined(_OPENMP)
+#pragma omp parallel
+#endif
+  {
+    std::vector<double> vals(nbTimeStep * nbComp);
+#if defined(_OPENMP)
+#pragma omp for
+#endif
+    for(int e = 0; e < nbList; e++) {
+      double *x = &list[e * nb];
+      double *y = &list[e * nb + nbVert];
+      double *z = &list[e * nb + 2 * nbVert];
+      double *v = &list[e * nb + 3 * nbVert];
+      for(int j = 0; j < nbVert; j++) {
+        if(data.get(x[j], y[j], z[j], nbTimeStep * nbComp, &vals[0])){
+          for(int ts = 0; ts < nbTimeStep; ts++)
+            for(int k = 0; k < nbComp; k++)
+              v[nbVert * nbComp * ts + nbComp * j + k] = vals[nbComp * ts + k];
+        }
       }
     }
   }
-  delete [] vals;
 }
 
 void PViewDataList::smooth()
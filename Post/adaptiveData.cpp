@@ -4,7 +4,9 @@
 // bugs and problems to the public mailing list <gmsh@geuz.org>.
 
 #include <math.h>
+#include <string.h>
 #include <list>
+#include <map>
 #include <set>
 #include "adaptiveData.h"
 #include "Plugin.h"
@@ -66,6 +68,27 @@ static void computeShapeFunctions(fullMatrix<double> *coeffs, fullMatrix<double>
   coeffs->mult(*tmp, *sf);
 }
 
+// refinement test of a node of the tree, which records the deviation in the
+// threshold bounds of the element
+static inline bool exceeds(double deviation, double threshold,
+                           adaptiveThreshold *th)
+{
+  if(th) th->add(deviation, threshold);
+  return deviation > threshold;
+}
+
+// FNV-1a hash of the element data
+static unsigned long long hashData(const double *d, int n,
+                                   unsigned long long h = 14695981039346656037ULL)
+{
+  const unsigned char *c = (const unsigned char*)d;
+  for(unsigned int i = 0; i < n * sizeof(double); i++){
+    h ^= c[i];
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
 adaptiveVertex *adaptiveVertex::add(double x, double y, double z,
                                   std::set<adaptiveVertex> &allVertices)
 {
@@ -100,7 +123,8 @@ void adaptivePoint::error(double AVG, double tol)
   recurError(e, AVG, tol);
 }
 
-void adaptivePoint::recurError(adaptivePoint *e, double AVG, double tol)
+void adaptivePoint::recurError(adaptivePoint *e, double AVG, double tol,
+                               adaptiveThreshold *th)
 {
   e->visible = true;
 }
@@ -139,7 +163,8 @@ void adaptiveLine::error(double AVG, double tol)
   recurError(e, AVG, tol);
 }
 
-void adaptiveLine::recurError(adaptiveLine *e, double AVG, double tol)
+void adaptiveLine::recurError(adaptiveLine *e, double AVG, double tol,
+                              adaptiveThreshold *th)
 {
   if(!e->e[0])
     e->visible = true;
@@ -150,10 +175,10 @@ void adaptiveLine::recurError(adaptiveLine *e, double AVG, double tol)
       double v2 = e->e[1]->V();
       vr = (v1 + v2) / 2.;
       double v = e->V();
-      if(fabs(v - vr) > AVG * tol){
+      if(exceeds(fabs(v - vr), AVG * tol, th)){
         e->visible = false;
-        recurError(e->e[0], AVG, tol);
-        recurError(e->e[1], AVG, tol);
+        recurError(e->e[0], AVG, tol, th);
+        recurError(e->e[1], AVG, tol, th);
       }
       else
         e->visible = true;
@@ -166,12 +191,12 @@ void adaptiveLine::recurError(adaptiveLine *e, double AVG, double tol)
       double vr1 = (v11 + v12) / 2.;
       double vr2 = (v21 + v22) / 2.;
       vr = (vr1 + vr2) / 2.;
-      if(fabs(e->e[0]->V() - vr1) > AVG * tol ||
-         fabs(e->e[1]->V() - vr2) > AVG * tol ||
-         fabs(e->V() - vr) > AVG * tol) {
+      if(exceeds(fabs(e->e[0]->V() - vr1), AVG * tol, th) ||
+         exceeds(fabs(e->e[1]->V() - vr2), AVG * tol, th) ||
+         exceeds(fabs(e->V() - vr), AVG * tol, th)) {
         e->visible = false;
-        recurError(e->e[0], AVG, tol);
-        recurError(e->e[1], AVG, tol);
+        recurError(e->e[0], AVG, tol, th);
+        recurError(e->e[1], AVG, tol, th);
       }
       else
         e->visible = true;
@@ -229,7 +254,8 @@ void adaptiveTriangle::error(double AVG, double tol)
   recurError(t, AVG, tol);
 }
 
-void adaptiveTriangle::recurError(adaptiveTriangle *t, double AVG, double tol)
+void adaptiveTriangle::recurError(adaptiveTriangle *t, double AVG, double tol,
+                                  adaptiveThreshold *th)
 {
   if(!t->e[0])
     t->visible = true;
@@ -242,12 +268,12 @@ void adaptiveTriangle::recurError(adaptiveTriangle *t, double AVG, double tol)
       double v4 = t->e[3]->V();
       vr = (2 * v1 + 2 * v2 + 2 * v3 + v4) / 7.;
       double v = t->V();
-      if(fabs(v - vr) > AVG * tol){
+      if(exceeds(fabs(v - vr), AVG * tol, th)){
         t->visible = false;
-        recurError(t->e[0], AVG, tol);
-        recurError(t->e[1], AVG, tol);
-        recurError(t->e[2], AVG, tol);
-        recurError(t->e[3], AVG, tol);
+        recurError(t->e[0], AVG, tol, th);
+        recurError(t->e[1], AVG, tol, th);
+        recurError(t->e[2], AVG, tol, th);
+        recurError(t->e[3], AVG, tol, th);
       }
       else
         t->visible = true;
@@ -274,16 +300,16 @@ void adaptiveTriangle::recurError(adaptiveTriangle *t, double AVG, double tol)
       double vr3 = (2 * v31 + 2 * v32 + 2 * v33 + v34) / 7.;
       double vr4 = (2 * v41 + 2 * v42 + 2 * v43 + v44) / 7.;
       vr = (2 * vr1 + 2 * vr2 + 2 * vr3 + vr4) / 7.;
-      if(fabs(t->e[0]->V() - vr1) > AVG * tol ||
-         fabs(t->e[1]->V() - vr2) > AVG * tol ||
-         fabs(t->e[2]->V() - vr3) > AVG * tol ||
-         fabs(t->e[3]->V() - vr4) > AVG * tol ||
-         fabs(t->V() - vr) > AVG * tol){
+      if(exceeds(fabs(t->e[0]->V() - vr1), AVG * tol, th) ||
+         exceeds(fabs(t->e[1]->V() - vr2), AVG * tol, th) ||
+         exceeds(fabs(t->e[2]->V() - vr3), AVG * tol, th) ||
+         exceeds(fabs(t->e[3]->V() - vr4), AVG * tol, th) ||
+         exceeds(fabs(t->V() - vr), AVG * tol, th)){
         t->visible = false;
-        recurError(t->e[0], AVG, tol);
-        recurError(t->e[1], AVG, tol);
-        recurError(t->e[2], AVG, tol);
-        recurError(t->e[3], AVG, tol);
+        recurError(t->e[0], AVG, tol, th);
+        recurError(t->e[1], AVG, tol, th);
+        recurError(t->e[2], AVG, tol, th);
+        recurError(t->e[3], AVG, tol, th);
       }
       else
         t->visible = true;
@@ -349,7 +375,8 @@ void adaptiveQuadrangle::error(double AVG, double tol)
   recurError(q, AVG, tol);
 }
 
-void adaptiveQuadrangle::recurError(adaptiveQuadrangle *q, double AVG, double tol)
+void adaptiveQuadrangle::recurError(adaptiveQuadrangle *q, double AVG, double tol,
+                                    adaptiveThreshold *th)
 {
   if(!q->e[0])
     q->visible = true;
@@ -362,12 +389,12 @@ void adaptiveQuadrangle::recurError(adaptiveQuadrangle *q, double AVG, double to
       double v4 = q->e[3]->V();
       vr = (v1 + v2 + v3 + v4) / 4.;
       double v = q->V();
-      if(fabs(v - vr) > AVG * tol){
+      if(exceeds(fabs(v - vr), AVG * tol, th)){
         q->visible = false;
-        recurError(q->e[0], AVG, tol);
-        recurError(q->e[1], AVG, tol);
-        recurError(q->e[2], AVG, tol);
-        recurError(q->e[3], AVG, tol);
+        recurError(q->e[0], AVG, tol, th);
+        recurError(q->e[1], AVG, tol, th);
+        recurError(q->e[2], AVG, tol, th);
+        recurError(q->e[3], AVG, tol, th);
       }
       else
         q->visible = true;
@@ -394,16 +421,16 @@ void adaptiveQuadrangle::recurError(adaptiveQuadrangle *q, double AVG, double to
       double vr3 = (v31 + v32 + v33 + v34) / 4.;
       double vr4 = (v41 + v42 + v43 + v44) / 4.;
       vr = (vr1 + vr2 + vr3 + vr4) / 4.;
-      if(fabs(q->e[0]->V() - vr1) > AVG * tol ||
-         fabs(q->e[1]->V() - vr2) > AVG * tol ||
-         fabs(q->e[2]->V() - vr3) > AVG * tol ||
-         fabs(q->e[3]->V() - vr4) > AVG * tol ||
-         fabs(q->V() - vr) > AVG * tol){
+      if(exceeds(fabs(q->e[0]->V() - vr1), AVG * tol, th) ||
+         exceeds(fabs(q->e[1]->V() - vr2), AVG * tol, th) ||
+         exceeds(fabs(q->e[2]->V() - vr3), AVG * tol, th) ||
+         exceeds(fabs(q->e[3]->V() - vr4), AVG * tol, th) ||
+         exceeds(fabs(q->V() - vr), AVG * tol, th)){
         q->visible = false;
-        recurError(q->e[0], AVG, tol);
-        recurError(q->e[1], AVG, tol);
-        recurError(q->e[2], AVG, tol);
-        recurError(q->e[3], AVG, tol);
+        recurError(q->e[0], AVG, tol, th);
+        recurError(q->e[1], AVG, tol, th);
+        recurError(q->e[2], AVG, tol, th);
+        recurError(q->e[3], AVG, tol, th);
       }
       else
         q->visible = true;
@@ -481,7 +508,8 @@ void adaptiveTetrahedron::error(double AVG, double tol)
   recurError(t, AVG, tol);
 }
 
-void adaptiveTetrahedron::recurError(adaptiveTetrahedron *t, double AVG, double tol)
+void adaptiveTetrahedron::recurError(adaptiveTetrahedron *t, double AVG, double tol,
+                                     adaptiveThreshold *th)
 {
   if(!t->e[0])
     t->visible = true;
@@ -497,16 +525,16 @@ void adaptiveTetrahedron::recurError(adaptiveTetrahedron *t, double AVG, double
     const double vr = (v1 + v2 + v3 + v4 + v5 + v6 + v7 + v8) * .125;
     const double v = t->V();
     if(!t->e[0]->e[0]) {
-      if(fabs(v - vr) > AVG * tol) {
+      if(exceeds(fabs(v - vr), AVG * tol, th)) {
         t->visible = false;
-        recurError(t->e[0], AVG, tol);
-        recurError(t->e[1], AVG, tol);
-        recurError(t->e[2], AVG, tol);
-        recurError(t->e[3], AVG, tol);
-        recurError(t->e[4], AVG, tol);
-        recurError(t->e[5], AVG, tol);
-        recurError(t->e[6], AVG, tol);
-        recurError(t->e[7], AVG, tol);
+        recurError(t->e[0], AVG, tol, th);
+        recurError(t->e[1], AVG, tol, th);
+        recurError(t->e[2], AVG, tol, th);
+        recurError(t->e[3], AVG, tol, th);
+        recurError(t->e[4], AVG, tol, th);
+        recurError(t->e[5], AVG, tol, th);
+        recurError(t->e[6], AVG, tol, th);
+        recurError(t->e[7], AVG, tol, th);
       }
       else
         t->visible = true;
@@ -524,24 +552,24 @@ void adaptiveTetrahedron::recurError(adaptiveTetrahedron *t, double AVG, double
         }
         vri[k] /= 8.0;
       }
-      if(fabs(t->e[0]->V() - vri[0]) > AVG * tol ||
-         fabs(t->e[1]->V() - vri[1]) > AVG * tol ||
-         fabs(t->e[2]->V() - vri[2]) > AVG * tol ||
-         fabs(t->e[3]->V() - vri[3]) > AVG * tol ||
-         fabs(t->e[4]->V() - vri[4]) > AVG * tol ||
-         fabs(t->e[5]->V() - vri[5]) > AVG * tol ||
-         fabs(t->e[6]->V() - vri[6]) > AVG * tol ||
-         fabs(t->e[7]->V() - vri[7]) > AVG * tol ||
-         fabs(v - vr) > AVG * tol) {
+      if(exceeds(fabs(t->e[0]->V() - vri[0]), AVG * tol, th) ||
+         exceeds(fabs(t->e[1]->V() - vri[1]), AVG * tol, th) ||
+         exceeds(fabs(t->e[2]->V() - vri[2]), AVG * tol, th) ||
+         exceeds(fabs(t->e[3]->V() - vri[3]), AVG * tol, th) ||
+         exceeds(fabs(t->e[4]->V() - vri[4]), AVG * tol, th) ||
+         exceeds(fabs(t->e[5]->V() - vri[5]), AVG * tol, th) ||
+         exceeds(fabs(t->e[6]->V() - vri[6]), AVG * tol, th) ||
+         exceeds(fabs(t->e[7]->V() - vri[7]), AVG * tol, th) ||
+         exceeds(fabs(v - vr), AVG * tol, th)) {
         t->visible = false;
-        recurError(t->e[0], AVG, tol);
-        recurError(t->e[1], AVG, tol);
-        recurError(t->e[2], AVG, tol);
-        recurError(t->e[3], AVG, tol);
-        recurError(t->e[4], AVG, tol);
-        recurError(t->e[5], AVG, tol);
-        recurError(t->e[6], AVG, tol);
-        recurError(t->e[7], AVG, tol);
+        recurError(t->e[0], AVG, tol, th);
+        recurError(t->e[1], AVG, tol, th);
+        recurError(t->e[2], AVG, tol, th);
+        recurError(t->e[3], AVG, tol, th);
+        recurError(t->e[4], AVG, tol, th);
+        recurError(t->e[5], AVG, tol, th);
+        recurError(t->e[6], AVG, tol, th);
+        recurError(t->e[7], AVG, tol, th);
       }
       else
         t->visible = true;
@@ -677,7 +705,8 @@ void adaptiveHexahedron::error(double AVG, double tol)
   recurError(h, AVG, tol);
 }
 
-void adaptiveHexahedron::recurError(adaptiveHexahedron *h, double AVG, double tol)
+void adaptiveHexahedron::recurError(adaptiveHexahedron *h, double AVG, double tol,
+                                    adaptiveThreshold *th)
 {
   if(!h->e[0])
     h->visible = true;
@@ -693,16 +722,16 @@ void adaptiveHexahedron::recurError(adaptiveHexahedron *h, double AVG, double to
     const double vr = (v1 + v2 + v3 + v4 + v5 + v6 + v7 + v8) * .125;
     const double v = h->V();
     if(!h->e[0]->e[0]) {
-      if(fabs(v - vr) > AVG * tol) {
+      if(exceeds(fabs(v - vr), AVG * tol, th)) {
         h->visible = false;
-        recurError(h->e[0], AVG, tol);
-        recurError(h->e[1], AVG, tol);
-        recurError(h->e[2], AVG, tol);
-        recurError(h->e[3], AVG, tol);
-        recurError(h->e[4], AVG, tol);
-        recurError(h->e[5], AVG, tol);
-        recurError(h->e[6], AVG, tol);
-        recurError(h->e[7], AVG, tol);
+        recurError(h->e[0], AVG, tol, th);
+        recurError(h->e[1], AVG, tol, th);
+        recurError(h->e[2], AVG, tol, th);
+        recurError(h->e[3], AVG, tol, th);
+        recurError(h->e[4], AVG, tol, th);
+        recurError(h->e[5], AVG, tol, th);
+        recurError(h->e[6], AVG, tol, th);
+        recurError(h->e[7], AVG, tol, th);
       }
       else
         h->visible = true;
@@ -720,24 +749,24 @@ void adaptiveHexahedron::recurError(adaptiveHexahedron *h, double AVG, double to
         }
         vri[k] /= 8.0;
       }
-      if(fabs(h->e[0]->V() - vri[0]) > AVG * tol ||
-         fabs(h->e[1]->V() - vri[1]) > AVG * tol ||
-         fabs(h->e[2]->V() - vri[2]) > AVG * tol ||
-         fabs(h->e[3]->V() - vri[3]) > AVG * tol ||
-         fabs(h->e[4]->V() - vri[4]) > AVG * tol ||
-         fabs(h->e[5]->V() - vri[5]) > AVG * tol ||
-         fabs(h->e[6]->V() - vri[6]) > AVG * tol ||
-         fabs(h->e[7]->V() - vri[7]) > AVG * tol ||
-         fabs(v - vr) > AVG * tol) {
+      if(exceeds(fabs(h->e[0]->V() - vri[0]), AVG * tol, th) ||
+         exceeds(fabs(h->e[1]->V() - vri[1]), AVG * tol, th) ||
+         exceeds(fabs(h->e[2]->V() - vri[2]), AVG * tol, th) ||
+         exceeds(fabs(h->e[3]->V() - vri[3]), AVG * tol, th) ||
+         exceeds(fabs(h->e[4]->V() - vri[4]), AVG * tol, th) ||
+         exceeds(fabs(h->e[5]->V() - vri[5]), AVG * tol, th) ||
+         exceeds(fabs(h->e[6]->V() - vri[6]), AVG * tol, th) ||
+         exceeds(fabs(h->e[7]->V() - vri[7]), AVG * tol, th) ||
+         exceeds(fabs(v - vr), AVG * tol, th)) {
         h->visible = false;
-        recurError(h->e[0], AVG, tol);
-        recurError(h->e[1], AVG, tol);
-        recurError(h->e[2], AVG, tol);
-        recurError(h->e[3], AVG, tol);
-        recurError(h->e[4], AVG, tol);
-        recurError(h->e[5], AVG, tol);
-        recurError(h->e[6], AVG, tol);
-        recurError(h->e[7], AVG, tol);
+        recurError(h->e[0], AVG, tol, th);
+        recurError(h->e[1], AVG, tol, th);
+        recurError(h->e[2], AVG, tol, th);
+        recurError(h->e[3], AVG, tol, th);
+        recurError(h->e[4], AVG, tol, th);
+        recurError(h->e[5], AVG, tol, th);
+        recurError(h->e[6], AVG, tol, th);
+        recurError(h->e[7], AVG, tol, th);
       }
       else
         h->visible = true;
@@ -832,7 +861,8 @@ void adaptivePrism::error(double AVG, double tol)
   recurError(p, AVG, tol);
 }
 
-void adaptivePrism::recurError(adaptivePrism *p, double AVG, double tol)
+void adaptivePrism::recurError(adaptivePrism *p, double AVG, double tol,
+                               adaptiveThreshold *th)
 {
   if(!p->e[0])
     p->visible = true;
@@ -843,16 +873,16 @@ void adaptivePrism::recurError(adaptivePrism *p, double AVG, double tol)
     const double vr = (vi[0] + vi[1] + vi[2] + vi[3]/2 + vi[4] + vi[5] + vi[6] + vi[7]/2) / 7;
     const double v = p->V();
     if(!p->e[0]->e[0]) {
-      if(fabs(v - vr) > AVG * tol){
+      if(exceeds(fabs(v - vr), AVG * tol, th)){
         p->visible = false;
-        recurError(p->e[0], AVG, tol);
-        recurError(p->e[1], AVG, tol);
-        recurError(p->e[2], AVG, tol);
-        recurError(p->e[3], AVG, tol);
-        recurError(p->e[4], AVG, tol);
-        recurError(p->e[5], AVG, tol);
-        recurError(p->e[6], AVG, tol);
-        recurError(p->e[7], AVG, tol);
+        recurError(p->e[0], AVG, tol, th);
+        recurError(p->e[1], AVG, tol, th);
+        recurError(p->e[2], AVG, tol, th);
+        recurError(p->e[3], AVG, tol, th);
+        recurError(p->e[4], AVG, tol, th);
+        recurError(p->e[5], AVG, tol, th);
+        recurError(p->e[6], AVG, tol, th);
+        recurError(p->e[7], AVG, tol, th);
       }
       else
         p->visible = true;
@@ -869,13 +899,13 @@ void adaptivePrism::recurError(adaptivePrism *p, double AVG, double tol)
         double vi7 = p->e[i]->e[6]->V();
         double vi8 = p->e[i]->e[7]->V();
         double vri = (vi1 + vi2 + vi3 + vi4/2 + vi5 + vi6 + vi7 + vi8/2) / 7;
-        err |= (fabs((vi[i] - vri)) > AVG * tol);
+        err |= (exceeds(fabs((vi[i] - vri)), AVG * tol, th));
       }
-      err |= (fabs((v - vr)) > AVG * tol);
+      err |= (exceeds(fabs((v - vr)), AVG * tol, th));
       if(err) {
         p->visible = false;
         for(int i = 0; i < 8; i++)
-          recurError(p->e[i], AVG, tol);
+          recurError(p->e[i], AVG, tol, th);
       }
       else
         p->visible = true;
@@ -906,6 +936,38 @@ adaptiveElements<T>::~adaptiveElements()
   cleanElement<T>();
 }
 
+template <class T>
+void adaptiveElements<T>::_createPools(int numPools)
+{
+  std::map<const adaptiveVertex*, int> vertexIndex;
+  std::vector<adaptiveVertex> vertices;
+  for(std::set<adaptiveVertex>::iterator it = T::allVertices.begin();
+      it != T::allVertices.end(); ++it){
+    vertexIndex[&(*it)] = vertices.size();
+    vertices.push_back(*it);
+  }
+  std::map<const T*, int> elementIndex;
+  std::vector<T> elements;
+  for(typename std::list<T*>::iterator it = T::all.begin(); it != T::all.end(); ++it){
+    elementIndex[*it] = elements.size();
+    elements.push_back(**it);
+  }
+
+  // the copies point to the static tree: make them point to their own pool
+  _vertexPools.assign(numPools, vertices);
+  _elementPools.assign(numPools, elements);
+  const int numChildren = sizeof(elements[0].e) / sizeof(elements[0].e[0]);
+  for(int pool = 0; pool < numPools; pool++){
+    for(unsigned int i = 0; i < elements.size(); i++){
+      T &e = _elementPools[pool][i];
+      for(int j = 0; j < T::numNodes; j++)
+        e.p[j] = &_vertexPools[pool][vertexIndex[e.p[j]]];
+      for(int j = 0; j < numChildren; j++)
+        if(e.e[j]) e.e[j] = &_elementPools[pool][elementIndex[e.e[j]]];
+    }
+  }
+}
+
 template <class T>
 void adaptiveElements<T>::init(int level)
 {
@@ -954,6 +1016,11 @@ void adaptiveElements<T>::init(int level)
   if(tmpv) delete tmpv;
   if(tmpg) delete tmpg;
 
+  _createPools(Msg::GetMaxThreads());
+  _cacheHash.clear();
+  _cacheThreshold.clear();
+  _cacheNumSub.clear();
+
 #ifdef TIMER
   adaptiveData::timerInit += GetTimeInSeconds() - t1;
   return;
@@ -961,135 +1028,86 @@ void adaptiveElements<T>::init(int level)
 }
 
 template <class T>
-void adaptiveElements<T>::adapt(double tol, int numComp,
-                                std::vector<PCoords> &coords,
-                                std::vector<PValues> &values,
-                                double &minVal, double &maxVal,
-                                GMSH_PostPlugin *plug,
-                                bool onlyComputeMinMax)
+void adaptiveElements<T>::_refine(int pool, const double *xyz, const double *val,
+                                  int numComp, double avg, double tol, bool error,
+                                  GMSH_PostPlugin *plug, adaptiveThreshold &th,
+                                  std::vector<double> &out, int &numSub)
 {
-  if(numComp != 1 && numComp != 3){
-    Msg::Error("Can only adapt scalar or vector data");
-    return;
-  }
-
-  int numVertices = T::allVertices.size();
-
-  if(!numVertices){
-    Msg::Error("No adapted vertices to interpolate");
-    return;
+  std::vector<adaptiveVertex> &vertices = _vertexPools[pool];
+  std::vector<T> &elements = _elementPools[pool];
+  const int numVertices = vertices.size();
+  const int numVals = _interpolVal->size2();
+  const int numNodes = _interpolGeom->size2();
+
+  // interpolate the values (and for vectors, the square of their norm) and
+  // the coordinates at the vertices of the tree
+  const int nc = (numComp == 1) ? 1 : 4;
+  fullMatrix<double> v(numVals, nc), res(numVertices, nc);
+  for(int i = 0; i < numVals; i++){
+    for(int c = 0; c < numComp; c++)
+      v(i, c) = val[i * numComp + c];
+    if(numComp == 3)
+      v(i, 3) = v(i, 0) * v(i, 0) + v(i, 1) * v(i, 1) + v(i, 2) * v(i, 2);
   }
+  _interpolVal->mult(v, res);
 
-  int numVals = _coeffsVal ? _coeffsVal->size1() : T::numNodes;
-  if(numVals != (int)values.size()){
-    Msg::Error("Wrong number of values in adaptation %d != %i",
-               numVals, values.size());
-    return;
-  }
-
-#ifdef TIMER
-  double t1 = GetTimeInSeconds();
-#endif
+  fullMatrix<double> x(numNodes, 3), X(numVertices, 3);
+  for(int i = 0; i < numNodes; i++)
+    for(int j = 0; j < 3; j++)
+      x(i, j) = xyz[3 * i + j];
+  _interpolGeom->mult(x, X);
 
-  fullVector<double> val(numVals), res(numVertices);
-  if(numComp == 1){
-    for(int i = 0; i < numVals; i++)
-      val(i) = values[i].v[0];
-  }
-  else{
-    for(int i = 0; i < numVals; i++)
-      val(i) = values[i].v[0] * values[i].v[0] + values[i].v[1] * values[i].v[1] +
-        values[i].v[2] * values[i].v[2];
-  }
-  _interpolVal->mult(val, res);
-
-  //minVal = VAL_INF;
-  //maxVal = -VAL_INF;
   for(int i = 0; i < numVertices; i++){
-    minVal = std::min(minVal, res(i));
-    maxVal = std::max(maxVal, res(i));
-  }
-  if(onlyComputeMinMax) return;
-
-  fullMatrix<double> *resxyz = 0;
-  if(numComp == 3){
-    fullMatrix<double> valxyz(numVals, 3);
-    resxyz = new fullMatrix<double>(numVertices, 3);
-    for(int i = 0; i < numVals; i++){
-      valxyz(i, 0) = values[i].v[0];
-      valxyz(i, 1) = values[i].v[1];
-      valxyz(i, 2) = values[i].v[2];
+    adaptiveVertex &p = vertices[i];
+    p.val = res(i, nc - 1);
+    if(numComp == 3){
+      p.valx = res(i, 0);
+      p.valy = res(i, 1);
+      p.valz = res(i, 2);
     }
-    _interpolVal->mult(valxyz, *resxyz);
+    p.X = X(i, 0);
+    p.Y = X(i, 1);
+    p.Z = X(i, 2);
   }
 
-  int numNodes = _coeffsGeom ? _coeffsGeom->size1() : T::numNodes;
-  if(numNodes != (int)coords.size()){
-    Msg::Error("Wrong number of nodes in adaptation %d != %i",
-               numNodes, coords.size());
-    if(resxyz) delete resxyz;
-    return;
-  }
-
-  fullMatrix<double> xyz(numNodes, 3), XYZ(numVertices, 3);
-  for(int i = 0; i < numNodes; i++){
-    xyz(i, 0) = coords[i].c[0];
-    xyz(i, 1) = coords[i].c[1];
-    xyz(i, 2) = coords[i].c[2];
-  }
-  _interpolGeom->mult(xyz, XYZ);
-
-#ifdef TIMER
-  adaptiveData::timerAdapt += GetTimeInSeconds() - t1;
-  return;
-#endif
-
-  int i = 0;
-  for(std::set<adaptiveVertex>::iterator it = T::allVertices.begin();
-      it != T::allVertices.end(); ++it){
-    // ok because we know this will not change the set ordering
-    adaptiveVertex *p = (adaptiveVertex*)&(*it);
-    p->val = res(i);
-    if(resxyz){
-      p->valx = (*resxyz)(i, 0);
-      p->valy = (*resxyz)(i, 1);
-      p->valz = (*resxyz)(i, 2);
-    }
-    p->X = XYZ(i, 0);
-    p->Y = XYZ(i, 1);
-    p->Z = XYZ(i, 2);
-    i++;
-  }
-
-  if(resxyz) delete resxyz;
-
-  for(typename std::list<T*>::iterator it = T::all.begin();
-      it != T::all.end(); it++)
-    (*it)->visible = false;
-
-  if(!plug || tol != 0.){
-    double avg = fabs(maxVal - minVal);
-    if(tol < 0) avg = 1.; // force visibility to the smallest subdivision
-    T::error(avg, tol);
-  }
-
-  if(plug)
+  for(unsigned int i = 0; i < elements.size(); i++)
+    elements[i].visible = false;
+
+  if(error) T::recurError(&elements[0], avg, tol, &th);
+
+  if(plug){
+    // the plugins work on the static tree
+    int i = 0;
+    for(std::set<adaptiveVertex>::iterator it = T::allVertices.begin();
+        it != T::allVertices.end(); ++it)
+      // ok because we know this will not change the set ordering
+      *(adaptiveVertex*)&(*it) = vertices[i++];
+    i = 0;
+    for(typename std::list<T*>::iterator it = T::all.begin(); it != T::all.end(); ++it)
+      (*it)->visible = elements[i++].visible;
     plug->assignSpecificVisibility();
+    i = 0;
+    for(typename std::list<T*>::iterator it = T::all.begin(); it != T::all.end(); ++it)
+      elements[i++].visible = (*it)->visible;
+  }
 
-  coords.clear();
-  values.clear();
-  for(typename std::list<T*>::iterator it = T::all.begin();
-      it != T::all.end(); it++){
-    if((*it)->visible){
-      adaptiveVertex **p = (*it)->p;
-      for(int i = 0; i < T::numNodes; i++) {
-        coords.push_back(PCoords(p[i]->X, p[i]->Y, p[i]->Z));
-        if(numComp == 1)
-          values.push_back(PValues(p[i]->val));
-        else
-          values.push_back(PValues(p[i]->valx, p[i]->valy, p[i]->valz));
+  numSub = 0;
+  for(unsigned int i = 0; i < elements.size(); i++){
+    if(!elements[i].visible) continue;
+    adaptiveVertex **p = elements[i].p;
+    for(int k = 0; k < T::numNodes; ++k) out.push_back(p[k]->X);
+    for(int k = 0; k < T::numNodes; ++k) out.push_back(p[k]->Y);
+    for(int k = 0; k < T::numNodes; ++k) out.push_back(p[k]->Z);
+    for(int k = 0; k < T::numNodes; ++k){
+      if(numComp == 1)
+        out.push_back(p[k]->val);
+      else{
+        out.push_back(p[k]->valx);
+        out.push_back(p[k]->valy);
+        out.push_back(p[k]->valz);
       }
     }
+    numSub++;
   }
 }
 
@@ -1142,53 +1160,184 @@ void adaptiveElements<T>::addInView(double tol, int step,
   }
   if(!numEle) return;
 
-  outList->clear();
+  // the previous output is kept to copy the elements that do not change
+  std::vector<double> previous;
+  previous.swap(*outList);
   *outNb = 0;
 
+  if(_vertexPools.empty() || _vertexPools[0].empty()){
+    Msg::Error("No adapted vertices to interpolate");
+    return;
+  }
+  if((int)_vertexPools.size() < Msg::GetMaxThreads())
+    _createPools(Msg::GetMaxThreads());
+
+#ifdef TIMER
+  double t1 = GetTimeInSeconds();
+#endif
+
+  // read the nodes and the values of the elements (the accessors of the view
+  // data are not thread-safe)
+  const int numVals = _interpolVal->size2();
+  const int numNodes = _interpolGeom->size2();
+  std::vector<double> xyz, val;
+  int numEl = 0;
   for(int ent = 0; ent < in->getNumEntities(step); ent++){
     for(int ele = 0; ele < in->getNumElements(step, ent); ele++){
       if(in->skipElement(step, ent, ele) ||
          in->getNumEdges(step, ent, ele) != T::numEdges) continue;
-      int numNodes = in->getNumNodes(step, ent, ele);
-      std::vector<PCoords> coords;
+      if(in->getNumNodes(step, ent, ele) != numNodes){
+        Msg::Error("Wrong number of nodes in adaptation %d != %i", numNodes,
+                   in->getNumNodes(step, ent, ele));
+        continue;
+      }
+      if(in->getNumValues(step, ent, ele) != numVals * numComp){
+        Msg::Error("Wrong number of values in adaptation %d != %i",
+                   numVals * numComp, in->getNumValues(step, ent, ele));
+        continue;
+      }
       for(int i = 0; i < numNodes; i++){
         double x, y, z;
         in->getNode(step, ent, ele, i, x, y, z);
-        coords.push_back(PCoords(x, y, z));
+        xyz.push_back(x);
+        xyz.push_back(y);
+        xyz.push_back(z);
       }
-      int numVal = in->getNumValues(step, ent, ele);
-      std::vector<PValues> values;
-      if(numComp == 1){
-        for(int i = 0; i < numVal; i++){
-          double val;
-          in->getValue(step, ent, ele, i, val);
-          values.push_back(PValues(val));
-        }
+      for(int i = 0; i < numVals * numComp; i++){
+        double v;
+        in->getValue(step, ent, ele, i, v);
+        val.push_back(v);
       }
-      else if(numComp == 3){
-        for(int i = 0; i < numVal / 3; i++){
-          double vx, vy, vz;
-          in->getValue(step, ent, ele, 3 * i, vx);
-          in->getValue(step, ent, ele, 3 * i + 1, vy);
-          in->getValue(step, ent, ele, 3 * i + 2, vz);
-          values.push_back(PValues(vx, vy, vz));
-        }
+      numEl++;
+    }
+  }
+  if(!numEl) return;
+
+  // range of the interpolated values of all the elements, and hash of the
+  // element data
+  const int numVertices = _interpolVal->size1();
+  double minVal = out->Min, maxVal = out->Max;
+  std::vector<unsigned long long> hash(numEl);
+#if defined(_OPENMP)
+#pragma omp parallel
+#endif
+  {
+    fullVector<double> v(numVals), res(numVertices);
+    double tmin = minVal, tmax = maxVal;
+#if defined(_OPENMP)
+#pragma omp for
+#endif
+    for(int k = 0; k < numEl; k++){
+      const double *d = &val[numVals * numComp * k];
+      for(int i = 0; i < numVals; i++){
+        if(numComp == 1)
+          v(i) = d[i];
+        else
+          v(i) = d[3 * i] * d[3 * i] + d[3 * i + 1] * d[3 * i + 1] +
+            d[3 * i + 2] * d[3 * i + 2];
+      }
+      _interpolVal->mult(v, res);
+      for(int i = 0; i < numVertices; i++){
+        tmin = std::min(tmin, res(i));
+        tmax = std::max(tmax, res(i));
       }
-      adapt(tol, numComp, coords, values, out->Min, out->Max, plug);
-      *outNb += coords.size() / T::numNodes;
-      for(unsigned int i = 0; i < coords.size() / T::numNodes; i++){
-        for(int k = 0; k < T::numNodes; ++k)
-          outList->push_back(coords[T::numNodes * i + k].c[0]);
-        for(int k = 0; k < T::numNodes; ++k)
-          outList->push_back(coords[T::numNodes * i + k].c[1]);
-        for(int k = 0; k < T::numNodes; ++k)
-          outList->push_back(coords[T::numNodes * i + k].c[2]);
-        for(int k = 0; k < T::numNodes; ++k)
-          for(int l = 0; l < numComp; ++l)
-            outList->push_back(values[T::numNodes * i + k].v[l]);
+      hash[k] = hashData(d, numVals * numComp,
+                         hashData(&xyz[3 * numNodes * k], 3 * numNodes));
+    }
+#if defined(_OPENMP)
+#pragma omp critical
+#endif
+    {
+      minVal = std::min(minVal, tmin);
+      maxVal = std::max(maxVal, tmax);
+    }
+  }
+  out->Min = minVal;
+  out->Max = maxVal;
+
+  const bool error = !plug || tol != 0.;
+  double avg = fabs(maxVal - minVal);
+  if(tol < 0) avg = 1.; // force visibility to the smallest subdivision
+
+  // an element can be copied from the previous output if its data is the
+  // same, and if the threshold is within the bounds of its last refinement
+  const int stride = T::numNodes * (3 + numComp);
+  bool cached = !plug && error && (int)_cacheHash.size() == numEl &&
+    _cacheXyz.size() == xyz.size() && _cacheVal.size() == val.size();
+  std::vector<int> offset;
+  if(cached){
+    offset.resize(numEl);
+    unsigned int o = 0;
+    for(int k = 0; k < numEl; k++){
+      offset[k] = o;
+      o += _cacheNumSub[k] * stride;
+    }
+    if(o != previous.size()) cached = false;
+  }
+
+  // refine the elements, each thread refining a contiguous range of elements
+  // with its own copy of the tree (serially if a plugin assigns the
+  // visibility), and append the outputs in thread order
+  std::vector<int> numSub(numEl);
+  std::vector<adaptiveThreshold> th(numEl);
+  std::vector<std::vector<double> > outputs(_vertexPools.size());
+  int numCopied = 0;
+#if defined(_OPENMP)
+#pragma omp parallel if(!plug) reduction(+:numCopied)
+#endif
+  {
+    const int thread = Msg::GetThreadNum();
+    const int numThreads = Msg::GetNumThreads();
+    const int begin = (long)numEl * thread / numThreads;
+    const int end = (long)numEl * (thread + 1) / numThreads;
+    std::vector<double> &o = outputs[thread];
+    for(int k = begin; k < end; k++){
+      const int nx = 3 * numNodes, nv = numVals * numComp;
+      if(cached && hash[k] == _cacheHash[k] &&
+         _cacheThreshold[k].contains(avg * tol) &&
+         !memcmp(&xyz[nx * k], &_cacheXyz[nx * k], nx * sizeof(double)) &&
+         !memcmp(&val[nv * k], &_cacheVal[nv * k], nv * sizeof(double))){
+        th[k] = _cacheThreshold[k];
+        numSub[k] = _cacheNumSub[k];
+        o.insert(o.end(), previous.begin() + offset[k],
+                 previous.begin() + offset[k] + numSub[k] * stride);
+        numCopied++;
       }
+      else
+        _refine(thread, &xyz[3 * numNodes * k], &val[numVals * numComp * k],
+                numComp, avg, tol, error, plug, th[k], o, numSub[k]);
     }
   }
+
+  unsigned int size = 0;
+  for(unsigned int t = 0; t < outputs.size(); t++)
+    size += outputs[t].size();
+  outList->reserve(size);
+  for(unsigned int t = 0; t < outputs.size(); t++)
+    outList->insert(outList->end(), outputs[t].begin(), outputs[t].end());
+  for(int k = 0; k < numEl; k++)
+    *outNb += numSub[k];
+
+  if(!plug && error){
+    _cacheHash.swap(hash);
+    _cacheXyz.swap(xyz);
+    _cacheVal.swap(val);
+    _cacheThreshold.swap(th);
+    _cacheNumSub.swap(numSub);
+  }
+  else{
+    _cacheHash.clear();
+    _cacheXyz.clear();
+    _cacheVal.clear();
+    _cacheThreshold.clear();
+    _cacheNumSub.clear();
+  }
+
+  Msg::Debug("Adapted %d elements (%d unchanged)", numEl, numCopied);
+
+#ifdef TIMER
+  adaptiveData::timerAdapt += GetTimeInSeconds() - t1;
+#endif
 }
 
 adaptiveData::adaptiveData(PViewData *data)
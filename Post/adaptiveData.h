@@ -6,6 +6,7 @@
 #ifndef _ADAPTIVE_DATA_H_
 #define _ADAPTIVE_DATA_H_
 
+#include <algorithm>
 #include <list>
 #include <set>
 #include <vector>
@@ -33,6 +34,28 @@ class adaptiveVertex {
   }
 };
 
+// Bounds of the refinement threshold (the product of the tolerance and of
+// the range of the values) between which the refinement of an element stays
+// the same: a node of the refinement tree is subdivided if one of the
+// deviations of its value from the values of its children is larger than the
+// threshold.
+class adaptiveThreshold {
+ public:
+  double lo, hi;
+  adaptiveThreshold() : lo(-1.e200), hi(1.e200) {}
+  void add(double deviation, double threshold)
+  {
+    if(deviation > threshold)
+      hi = std::min(hi, deviation);
+    else
+      lo = std::max(lo, deviation);
+  }
+  bool contains(double threshold) const
+  {
+    return threshold >= lo && threshold < hi;
+  }
+};
+
 class adaptivePoint {
  public:
   bool visible;
@@ -59,7 +82,8 @@ class adaptivePoint {
   static void create(int maxlevel);
   static void recurCreate(adaptivePoint *e, int maxlevel, int level);
   static void error(double AVG, double tol);
-  static void recurError(adaptivePoint *e, double AVG, double tol);
+  static void recurError(adaptivePoint *e, double AVG, double tol,
+                         adaptiveThreshold *th=0);
 };
 
 class adaptiveLine {
@@ -90,7 +114,8 @@ class adaptiveLine {
   static void create(int maxlevel);
   static void recurCreate(adaptiveLine *e, int maxlevel, int level);
   static void error(double AVG, double tol);
-  static void recurError(adaptiveLine *e, double AVG, double tol);
+  static void recurError(adaptiveLine *e, double AVG, double tol,
+                         adaptiveThreshold *th=0);
 };
 
 class adaptiveTriangle {
@@ -123,7 +148,8 @@ class adaptiveTriangle {
   static void create(int maxlevel);
   static void recurCreate(adaptiveTriangle *t, int maxlevel, int level);
   static void error(double AVG, double tol);
-  static void recurError(adaptiveTriangle *t, double AVG, double tol);
+  static void recurError(adaptiveTriangle *t, double AVG, double tol,
+                         adaptiveThreshold *th=0);
 };
 
 class adaptiveQuadrangle {
@@ -159,7 +185,8 @@ class adaptiveQuadrangle {
   static void create(int maxlevel);
   static void recurCreate(adaptiveQuadrangle *q, int maxlevel, int level);
   static void error(double AVG, double tol);
-  static void recurError(adaptiveQuadrangle *q, double AVG, double tol);
+  static void recurError(adaptiveQuadrangle *q, double AVG, double tol,
+                         adaptiveThreshold *th=0);
 };
 
 class adaptivePrism {
@@ -200,7 +227,8 @@ class adaptivePrism {
   static void create(int maxlevel);
   static void recurCreate(adaptivePrism *p, int maxlevel, int level);
   static void error(double AVG, double tol);
-  static void recurError(adaptivePrism *p, double AVG, double tol);
+  static void recurError(adaptivePrism *p, double AVG, double tol,
+                         adaptiveThreshold *th=0);
 };
 
 class adaptiveTetrahedron {
@@ -237,7 +265,8 @@ class adaptiveTetrahedron {
   static void create(int maxlevel);
   static void recurCreate(adaptiveTetrahedron *t, int maxlevel, int level);
   static void error(double AVG, double tol);
-  static void recurError(adaptiveTetrahedron *t, double AVG, double tol);
+  static void recurError(adaptiveTetrahedron *t, double AVG, double tol,
+                         adaptiveThreshold *th=0);
 };
 
 class adaptiveHexahedron {
@@ -284,7 +313,8 @@ class adaptiveHexahedron {
   static void create(int maxlevel);
   static void recurCreate(adaptiveHexahedron *h, int maxlevel, int level);
   static void error(double AVG, double tol);
-  static void recurError(adaptiveHexahedron *h, double AVG, double tol);
+  static void recurError(adaptiveHexahedron *h, double AVG, double tol,
+                         adaptiveThreshold *th=0);
 };
 
 class PCoords { 
@@ -314,21 +344,37 @@ class adaptiveElements {
  private:
   fullMatrix<double> *_coeffsVal, *_eexpsVal, *_interpolVal;
   fullMatrix<double> *_coeffsGeom, *_eexpsGeom, *_interpolGeom;
+  // copies of the refinement tree of the reference element (T::all and
+  // T::allVertices, in the same order), one per thread, so that elements can
+  // be refined concurrently
+  std::vector<std::vector<adaptiveVertex> > _vertexPools;
+  std::vector<std::vector<T> > _elementPools;
+  // last refinement of each element (the input data and its hash, the
+  // threshold bounds and the number of sub-elements), to only refine again
+  // the elements whose refinement changes: the hashes are compared first, and
+  // the data only if they match
+  std::vector<unsigned long long> _cacheHash;
+  std::vector<double> _cacheXyz, _cacheVal;
+  std::vector<adaptiveThreshold> _cacheThreshold;
+  std::vector<int> _cacheNumSub;
+  void _createPools(int numPools);
+  // refine the element with nodes xyz and values val (numComp per value)
+  // with the given copy of the tree, append its visible sub-elements to out
+  // and update the threshold bounds of the element
+  void _refine(int pool, const double *xyz, const double *val, int numComp,
+               double avg, double tol, bool error, GMSH_PostPlugin *plug,
+               adaptiveThreshold &th, std::vector<double> &out, int &numSub);
  public:
   adaptiveElements(std::vector<fullMatrix<double>*> &interpolationMatrices);
   ~adaptiveElements();
   // create the _interpolVal and _interpolGeom matrices at the given
   // refinement level
   void init(int level);
-  // process the element data in coords/values and return the refined
-  // elements in coords/values
-  void adapt(double tol, int numComp,
-             std::vector<PCoords> &coords, std::vector<PValues> &values,
-             double &minVal, double &maxVal, GMSH_PostPlugin *plug=0,
-             bool onlyComputeMinMax=false);
   // adapt all the T-type elements in the input view and add the
   // refined elements in the output view (we will remove this when we
-  // switch to true on-the-fly local refinement in drawPost())
+  // switch to true on-the-fly local refinement in drawPost()); the elements
+  // are refined in parallel, and only the elements whose data or refinement
+  // changed since the last call are refined again
   void addInView(double tol, int step, PViewData *in, PViewDataList *out, 
                  GMSH_PostPlugin *plug=0);
 };
@@ -62,8 +62,9 @@ void dofManagerBase::_parallelFinalize()
   if (Msg::GetCommRank() != Msg::GetCommSize()-1)
     MPI_Send (&numTotal, 1, MPI_INT, Msg::GetCommRank()+1, 0, MPI_COMM_WORLD);
   MPI_Bcast(&numTotal, 1, MPI_INT, Msg::GetCommSize()-1, MPI_COMM_WORLD);
-  for (std::map <Dof, int> ::iterator it = unknown.begin(); it!= unknown.end(); it++)
-    it->second += numStart;
+  std::vector<std::pair<Dof, int> > &entries = unknown.entries();
+  for (unsigned int i = 0; i < entries.size(); i++)
+    entries[i].second += numStart;
   std::vector<std::list<Dof> >  ghostedByProc;
   int *nRequest = new int[Msg::GetCommSize()];
   int *nRequested = new int[Msg::GetCommSize()];
@@ -115,10 +116,10 @@ void dofManagerBase::_parallelFinalize()
     if (status.MPI_TAG == 0) {
       for (int j = 0; j < nRequested[index]; j++) {
         Dof d(recv0[index][j*2], recv0[index][j*2+1]);
-        std::map<Dof, int>::iterator it = unknown.find(d);
-        if (it == unknown.end ())
+        int num = unknown.find(d);
+        if (num < 0)
           Msg::Error ("ghost Dof does not exist on parent process");
-        send1[index][j] = it->second;
+        send1[index][j] = num;
         parentByProc[index][j] = d;
       }
       MPI_Isend(send1[index], nRequested[index], MPI_INT, index, 1,
@@ -130,7 +131,7 @@ void dofManagerBase::_parallelFinalize()
     nRequest[i] = 0;
   for (std::map <Dof, std::pair<int, int> >::iterator it = ghostByDof.begin(); it != ghostByDof.end(); it++) {
     int proc = it->second.first;
-    unknown[it->first] = recv1 [proc][nRequest[proc] ++];
+    unknown.set(it->first, recv1 [proc][nRequest[proc] ++]);
   }
   MPI_Waitall (Msg::GetCommSize(), reqSend0, MPI_STATUS_IGNORE);
   MPI_Waitall (Msg::GetCommSize(), reqSend1, MPI_STATUS_IGNORE);
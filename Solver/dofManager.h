@@ -12,6 +12,7 @@
 #include <map>
 #include <list>
 #include <iostream>
+#include <algorithm>
 #include "MVertex.h"
 #include "linearSystem.h"
 #include "fullMatrix.h"
@@ -46,6 +47,58 @@ class Dof{
   }
 };
 
+// A hash table numbering dofs, with open addressing and linear probing: the
+// (dof, number) pairs are stored in insertion order in a vector, and the table
+// stores their positions in this vector (or -1 for empty slots).
+class dofIndexMap{
+ private:
+  std::vector<std::pair<Dof, int> > _entries;
+  std::vector<int> _table;
+  inline size_t _slot(const Dof &d) const
+  {
+    unsigned long h = (unsigned long)d.getEntity() * 2654435761UL +
+      (unsigned long)d.getType() * 40503UL;
+    h ^= (h >> 16);
+    size_t mask = _table.size() - 1;
+    size_t i = h & mask;
+    while(_table[i] >= 0 && !(_entries[_table[i]].first == d))
+      i = (i + 1) & mask;
+    return i;
+  }
+  void _rehash(size_t size)
+  {
+    _table.assign(size, -1);
+    for(unsigned int i = 0; i < _entries.size(); i++)
+      _table[_slot(_entries[i].first)] = i;
+  }
+ public:
+  inline int size() const { return _entries.size(); }
+  inline bool empty() const { return _entries.empty(); }
+  void clear(){ _entries.clear(); _table.clear(); }
+  // get the number of dof d, or -1 if d is not numbered
+  inline int find(const Dof &d) const
+  {
+    if(_table.empty()) return -1;
+    int p = _table[_slot(d)];
+    return (p < 0) ? -1 : _entries[p].second;
+  }
+  // set the number of dof d
+  void set(const Dof &d, int num)
+  {
+    if(2 * (_entries.size() + 1) > _table.size())
+      _rehash(std::max((size_t)16, 2 * _table.size()));
+    size_t i = _slot(d);
+    if(_table[i] >= 0)
+      _entries[_table[i]].second = num;
+    else{
+      _table[i] = _entries.size();
+      _entries.push_back(std::make_pair(d, num));
+    }
+  }
+  // the (dof, number) pairs, in insertion order
+  std::vector<std::pair<Dof, int> > &entries(){ return _entries; }
+};
+
 template<class T> struct dofTraits
 {
   typedef T VecType;
@@ -87,7 +140,7 @@ class DofAffineConstraint{
 class dofManagerBase{
   protected:
   // numbering of unknown dof blocks
-  std::map<Dof, int> unknown;
+  dofIndexMap unknown;
 
   // associatations (not used ?)
   std::map<Dof, Dof> associatedWith;
@@ -133,6 +186,7 @@ class dofManager : public dofManagerBase{
   std::map<const std::string, linearSystem<dataMat>*> _linearSystems;
 
   std::map<Dof, T> ghostValue;
+
   public:
   void scatterSolution();
 
@@ -151,7 +205,7 @@ class dofManager : public dofManagerBase{
   virtual ~dofManager(){}
   virtual inline void fixDof(Dof key, const dataVec &value)
   {
-    if(unknown.find(key) != unknown.end())
+    if(unknown.find(key) >= 0)
       return;
     fixed[key] = value;
   }
@@ -175,7 +229,7 @@ class dofManager : public dofManagerBase{
   {
     if(ghostValue.find(key) == ghostValue.end())
     {
-      if(unknown.find(key) != unknown.end())
+      if(unknown.find(key) >= 0)
         return true;
     }
     return false;
@@ -209,10 +263,8 @@ class dofManager : public dofManagerBase{
     if (constraints.find(key) != constraints.end()) return;
     if (ghostByDof.find(key) != ghostByDof.end()) return;
 
-    std::map<Dof, int> :: iterator it = unknown.find(key);
-    if (it == unknown.end()) {
-      unsigned int size = unknown.size();
-      unknown[key] = size;
+    if (unknown.find(key) < 0) {
+      unknown.set(key, unknown.size());
     }
   }
   virtual inline void numberDof(const std::vector<Dof> &R)
@@ -240,10 +292,10 @@ class dofManager : public dofManagerBase{
   {
     if(ghostValue.find(key) == ghostValue.end())
     {
-      std::map<Dof, int>::const_iterator it = unknown.find(key);
-      if (it != unknown.end())
+      int num = unknown.find(key);
+      if (num >= 0)
       {
-        _current->getFromSolution(it->second, val);
+        _current->getFromSolution(num, val);
         return true;
       }
     }
@@ -272,9 +324,9 @@ class dofManager : public dofManagerBase{
       }
     }
     {
-      std::map<Dof, int>::const_iterator it = unknown.find(key);
-      if (it != unknown.end()) {
-        _current->getFromSolution(it->second, val);
+      int num = unknown.find(key);
+      if (num >= 0) {
+        _current->getFromSolution(num, val);
         return;
       }
     }
@@ -292,9 +344,6 @@ class dofManager : public dofManagerBase{
         dataVec tmp(val);
         val = it->second.shift;
         for (unsigned i = 0; i < (it->second).linear.size(); i++){
-          /* gcc: warning: variable ‘itu’ set but not used
-          std::map<Dof, int>::const_iterator itu = unknown.find
-            (((it->second).linear[i]).first);*/
           getDofValue(((it->second).linear[i]).first, tmp);
           dofTraits<T>::gemm(val, ((it->second).linear[i]).second, tmp, 1, 1);
         }
@@ -313,8 +362,7 @@ class dofManager : public dofManagerBase{
 
   virtual inline void insertInSparsityPatternLinConst(const Dof &R, const Dof &C)
   {
-    std::map<Dof, int>::iterator itR = unknown.find(R);
-    if (itR != unknown.end())
+    if (unknown.find(R) >= 0)
     {
       typename std::map<Dof, DofAffineConstraint<dataVec> >::iterator itConstraint;
       itConstraint = constraints.find(C);
@@ -339,11 +387,11 @@ class dofManager : public dofManagerBase{
   {
     if (_isParallel && !_parallelFinalized) _parallelFinalize();
     if (!_current->isAllocated()) _current->allocate (sizeOfR());
-    std::map<Dof, int>::iterator itR = unknown.find(R);
-    if (itR != unknown.end()){
-      std::map<Dof, int>::iterator itC = unknown.find(C);
-      if (itC != unknown.end()){
-        _current->insertInSparsityPattern(itR->second, itC->second);
+    int NR = unknown.find(R);
+    if (NR >= 0){
+      int NC = unknown.find(C);
+      if (NC >= 0){
+        _current->insertInSparsityPattern(NR, NC);
       }
       else{
         typename std::map<Dof, dataVec>::iterator itFixed = fixed.find(C);
@@ -352,7 +400,7 @@ class dofManager : public dofManagerBase{
         else insertInSparsityPatternLinConst(R, C);
       }
     }
-    if (itR == unknown.end())
+    if (NR < 0)
     {
       insertInSparsityPatternLinConst(R, C);
     }
@@ -362,11 +410,11 @@ class dofManager : public dofManagerBase{
   {
     if (_isParallel && !_parallelFinalized) _parallelFinalize();
     if (!_current->isAllocated()) _current->allocate (sizeOfR());
-    std::map<Dof, int>::iterator itR = unknown.find(R);
-    if (itR != unknown.end()){
-      std::map<Dof, int>::iterator itC = unknown.find(C);
-      if (itC != unknown.end()){
-        _current->addToMatrix(itR->second, itC->second, value);
+    int NR = unknown.find(R);
+    if (NR >= 0){
+      int NC = unknown.find(C);
+      if (NC >= 0){
+        _current->addToMatrix(NR, NC, value);
       }
       else{
         typename std::map<Dof, dataVec>::iterator itFixed = fixed.find(C);
@@ -374,12 +422,12 @@ class dofManager : public dofManagerBase{
           // tmp = -value * itFixed->second
           dataVec tmp(itFixed->second);
           dofTraits<T>::gemm(tmp, value, itFixed->second, -1, 0);
-          _current->addToRightHandSide(itR->second, tmp);
+          _current->addToRightHandSide(NR, tmp);
         }
         else assembleLinConst(R, C, value);
       }
     }
-    if (itR == unknown.end())
+    if (NR < 0)
     {
       assembleLinConst(R, C, value);
     }
@@ -390,18 +438,9 @@ class dofManager : public dofManagerBase{
     if (_isParallel && !_parallelFinalized) _parallelFinalize();
     if (!_current->isAllocated()) _current->allocate(sizeOfR());
 
-    std::vector<int> NR(R.size()), NC(C.size());
-
-    for (unsigned int i = 0; i < R.size(); i++){
-      std::map<Dof, int>::iterator itR = unknown.find(R[i]);
-      if (itR != unknown.end()) NR[i] = itR->second;
-      else NR[i] = -1;
-    }
-    for (unsigned int i = 0; i < C.size(); i++){
-      std::map<Dof, int>::iterator itC = unknown.find(C[i]);
-      if (itC != unknown.end()) NC[i] = itC->second;
-      else NC[i] = -1;
-    }
+    std::vector<int> NR, NC;
+    getDofNumbers(R, NR);
+    getDofNumbers(C, NC);
     for (unsigned int i = 0; i < R.size(); i++){
       if (NR[i] != -1){
         for (unsigned int j = 0; j < C.size(); j++){
@@ -432,12 +471,8 @@ class dofManager : public dofManagerBase{
   {
     if (_isParallel && !_parallelFinalized) _parallelFinalize();
     if (!_current->isAllocated()) _current->allocate(sizeOfR());
-    std::vector<int> NR(R.size());
-    for (unsigned int i = 0; i < R.size(); i++){
-      std::map<Dof, int>::iterator itR = unknown.find(R[i]);
-      if (itR != unknown.end()) NR[i] = itR->second;
-      else NR[i] = -1;
-    }
+    std::vector<int> NR;
+    getDofNumbers(R, NR);
     for (unsigned int i = 0; i < R.size(); i++){
       if (NR[i] != -1){
         _current->addToRightHandSide(NR[i], m(i));
@@ -459,12 +494,21 @@ class dofManager : public dofManagerBase{
   {
     if (_isParallel && !_parallelFinalized) _parallelFinalize();
     if (!_current->isAllocated()) _current->allocate(sizeOfR());
-    std::vector<int> NR(R.size());
-    for (unsigned int i = 0; i < R.size(); i++){
-      std::map<Dof, int>::iterator itR = unknown.find(R[i]);
-      if (itR != unknown.end()) NR[i] = itR->second;
-      else NR[i] = -1;
-    }
+    std::vector<int> NR;
+    getDofNumbers(R, NR);
+    _assemble(R, NR, m);
+  }
+  // get the numbers of the dofs R (-1 for dofs that are not unknowns)
+  inline void getDofNumbers(const std::vector<Dof> &R, std::vector<int> &NR) const
+  {
+    NR.resize(R.size());
+    for (unsigned int i = 0; i < R.size(); i++)
+      NR[i] = unknown.find(R[i]);
+  }
+ protected:
+  void _assemble(std::vector<Dof> &R, const std::vector<int> &NR,
+                 const fullMatrix<dataMat> &m)
+  {
     for (unsigned int i = 0; i < R.size(); i++){
       if (NR[i] != -1){
         for (unsigned int j = 0; j < R.size(); j++){
@@ -489,6 +533,7 @@ class dofManager : public dofManagerBase{
       }
     }
   }
+ public:
   inline void assemble(int entR, int typeR, int entC, int typeC, const dataMat &value)
   {
     assemble(Dof(entR, typeR), Dof(entC, typeC), value);
@@ -505,9 +550,9 @@ class dofManager : public dofManagerBase{
   {
     if (_isParallel && !_parallelFinalized) _parallelFinalize();
     if(!_current->isAllocated()) _current->allocate(sizeOfR());
-    std::map<Dof, int>::iterator itR = unknown.find(R);
-    if(itR != unknown.end()){
-      _current->addToRightHandSide(itR->second, value);
+    int NR = unknown.find(R);
+    if(NR >= 0){
+      _current->addToRightHandSide(NR, value);
     }
     else{
       typename std::map<Dof, DofAffineConstraint<dataVec> >::iterator itConstraint;
@@ -533,6 +578,14 @@ class dofManager : public dofManagerBase{
   virtual int sizeOfR() const { return _isParallel ? _localSize : unknown.size(); }
   virtual int sizeOfF() const { return fixed.size(); }
   virtual void systemSolve(){ _current->systemSolve(); }
+  // check if element matrices can be assembled concurrently (from several
+  // threads) with assemble(R, m): the current linear system must be
+  // allocated and support concurrent additions
+  bool isThreadSafe() const
+  {
+    return (!_isParallel || _parallelFinalized) && _current->isAllocated() &&
+      _current->isThreadSafe();
+  }
   virtual void systemClear()
   {
     _current->zeroMatrix();
@@ -577,8 +630,8 @@ class dofManager : public dofManagerBase{
   
   virtual inline void assembleLinConst(const Dof &R, const Dof &C, const dataMat &value)
   {
-    std::map<Dof, int>::iterator itR = unknown.find(R);
-    if (itR != unknown.end())
+    int NR = unknown.find(R);
+    if (NR >= 0)
     {
       typename std::map<Dof, DofAffineConstraint<dataVec> >::iterator itConstraint;
       itConstraint = constraints.find(C);
@@ -590,7 +643,7 @@ class dofManager : public dofManagerBase{
         }
         dataMat tmp2(value);
         dofTraits<T>::gemm(tmp2, value, itConstraint->second.shift, -1, 0);
-        _current->addToRightHandSide(itR->second, tmp2);
+        _current->addToRightHandSide(NR, tmp2);
       }
     }
     else{  // test function ; (no shift ?)
@@ -617,11 +670,7 @@ class dofManager : public dofManagerBase{
 
   virtual int getDofNumber(const Dof& key)
   {
-    std::map<Dof,int>::iterator it = unknown.find(key);
-    if (it == unknown.end()){
-      return -1;
-    }
-    else return it->second;
+    return unknown.find(key);
   }
   
 	virtual void clearAllLineConstraints() {
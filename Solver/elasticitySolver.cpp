@@ -106,9 +106,13 @@ void elasticitySolver::solve()
   linearSystemCSRTaucs<double> *lsys = new linearSystemCSRTaucs<double>;
 #elif defined(HAVE_PETSC)
   linearSystemPETSc<double> *lsys = new linearSystemPETSc<double>;
-#else
+#elif defined(HAVE_GMM) && defined(HAVE_MUMPS)
   linearSystemGmm<double> *lsys = new linearSystemGmm<double>;
   lsys->setNoisy(2);
+#else
+  linearSystemCSRKrylov<double> *lsys = new linearSystemCSRKrylov<double>;
+  // Lagrange multipliers lead to indefinite systems
+  if(LagrangeMultiplierFields.size()) lsys->setGmres(1);
 #endif
 
   assemble(lsys);
@@ -427,6 +431,20 @@ void elasticitySolver::assemble(linearSystem<double> *lsys)
       FixVoidNodalDofs(*LagSpace, elasticFields[i].g->begin(), elasticFields[i].g->end(),
                        *pAssembler);
   }
+  // Sparsity pattern (so that the matrix is allocated once before assembly)
+  for (unsigned int i = 0; i < elasticFields.size(); ++i)
+  {
+    SparsityDofs(*LagSpace, elasticFields[i].g->begin(), elasticFields[i].g->end(),
+                 *pAssembler);
+  }
+  for (unsigned int i = 0; i < LagrangeMultiplierFields.size(); ++i)
+  {
+    SparsityDofs(*LagSpace, *LagrangeMultiplierSpace,
+                 LagrangeMultiplierFields[i].g->begin(),
+                 LagrangeMultiplierFields[i].g->end(), *pAssembler);
+    SparsityDofs(*LagrangeMultiplierSpace, LagrangeMultiplierFields[i].g->begin(),
+                 LagrangeMultiplierFields[i].g->end(), *pAssembler);
+  }
   // Neumann conditions
   GaussQuadrature Integ_Boundary(GaussQuadrature::Val);
 
@@ -461,8 +479,8 @@ void elasticitySolver::assemble(linearSystem<double> *lsys)
   for (unsigned int i = 0; i < elasticFields.size(); i++)
   {
     IsotropicElasticTerm Eterm(*LagSpace,elasticFields[i]._E,elasticFields[i]._nu);
-    Assemble(Eterm,*LagSpace,elasticFields[i].g->begin(),elasticFields[i].g->end(),
-             Integ_Bulk,*pAssembler);
+    AssembleInParallel(Eterm,*LagSpace,elasticFields[i].g->begin(),elasticFields[i].g->end(),
+                       Integ_Bulk,*pAssembler);
   }
 
   /*for (int i=0;i<pAssembler->sizeOfR();i++){
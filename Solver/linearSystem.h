@@ -27,6 +27,9 @@ class linearSystemBase {
   void setParameter (std::string key, std::string value);
   std::string getParameter(std::string key) const;
   virtual void insertInSparsityPattern(int _row, int _col){};
+  // check if values can be added concurrently (from several threads) to the
+  // matrix and the right hand side
+  virtual bool isThreadSafe() const { return false; }
   virtual double normInfRightHandSide() const = 0;
   virtual double normInfSolution() const {return 0;};
 };
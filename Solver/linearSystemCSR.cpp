@@ -6,6 +6,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <math.h>
+#include <algorithm>
 #include "GmshConfig.h"
 #include "GmshMessage.h"
 #include "linearSystemCSR.h"
@@ -339,6 +341,261 @@ void linearSystemCSR<double>::getMatrix(INDEX_TYPE*& jptr,INDEX_TYPE*& ai,double
   sorted = true;
 }
 
+// y = A x
+static void csrMult(int n, const INDEX_TYPE *jptr, const INDEX_TYPE *ai,
+                    const double *a, const double *x, double *y)
+{
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(static, 256)
+#endif
+  for(int i = 0; i < n; i++){
+    double s = 0.;
+    for(INDEX_TYPE k = jptr[i]; k < jptr[i + 1]; k++) s += a[k] * x[ai[k]];
+    y[i] = s;
+  }
+}
+
+static double csrDot(int n, const double *x, const double *y)
+{
+  double s = 0.;
+#if defined(_OPENMP)
+#pragma omp parallel for reduction(+:s)
+#endif
+  for(int i = 0; i < n; i++) s += x[i] * y[i];
+  return s;
+}
+
+// y = y + alpha x
+static void csrAxpy(int n, double alpha, const double *x, double *y)
+{
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+  for(int i = 0; i < n; i++) y[i] += alpha * x[i];
+}
+
+// y = x + beta y
+static void csrXpay(int n, const double *x, double beta, double *y)
+{
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+  for(int i = 0; i < n; i++) y[i] = x[i] + beta * y[i];
+}
+
+// Jacobi, ILU(0) and SSOR preconditioners of a CSR matrix with sorted columns
+class csrPreconditioner {
+ private:
+  int _type, _n;
+  double _omega;
+  const INDEX_TYPE *_jptr, *_ai;
+  const double *_a;
+  // position of the diagonal entries, inverse of the diagonal (of the
+  // matrix, or of U for ILU(0)) and ILU(0) factors
+  std::vector<INDEX_TYPE> _diag;
+  std::vector<double> _invDiag, _lu;
+  static double _inverse(double d)
+  {
+    // zero pivots (e.g. for Lagrange multipliers) are left unscaled
+    return (d == 0.) ? 1. : 1. / d;
+  }
+ public:
+  csrPreconditioner(int type, int n, const INDEX_TYPE *jptr,
+                    const INDEX_TYPE *ai, const double *a, double omega)
+    : _type(type), _n(n), _omega(omega), _jptr(jptr), _ai(ai), _a(a),
+      _diag(n, -1), _invDiag(n)
+  {
+    for(int i = 0; i < n; i++){
+      for(INDEX_TYPE k = jptr[i]; k < jptr[i + 1]; k++){
+        if(ai[k] == i){ _diag[i] = k; break; }
+      }
+      _invDiag[i] = _inverse((_diag[i] < 0) ? 0. : a[_diag[i]]);
+    }
+    if(_type != linearSystemCSRKrylov<double>::ILU0) return;
+    // incomplete LU factorization, with the sparsity of the matrix (L has a
+    // unit diagonal and is stored below the diagonal of _lu)
+    _lu.assign(a, a + jptr[n]);
+    std::vector<INDEX_TYPE> pos(n, -1);
+    for(int i = 0; i < n; i++){
+      for(INDEX_TYPE k = jptr[i]; k < jptr[i + 1]; k++) pos[ai[k]] = k;
+      for(INDEX_TYPE k = jptr[i]; k < jptr[i + 1] && ai[k] < i; k++){
+        int j = ai[k];
+        _lu[k] *= _invDiag[j];
+        for(INDEX_TYPE l = _diag[j] + 1; l < jptr[j + 1]; l++){
+          if(pos[ai[l]] >= 0) _lu[pos[ai[l]]] -= _lu[k] * _lu[l];
+        }
+      }
+      for(INDEX_TYPE k = jptr[i]; k < jptr[i + 1]; k++) pos[ai[k]] = -1;
+      _invDiag[i] = _inverse((_diag[i] < 0) ? 0. : _lu[_diag[i]]);
+      if(_diag[i] < 0) _diag[i] = jptr[i];
+    }
+  }
+  // z = M^-1 r
+  void apply(const double *r, double *z) const
+  {
+    if(_type == linearSystemCSRKrylov<double>::ILU0){
+      for(int i = 0; i < _n; i++){
+        double s = r[i];
+        for(INDEX_TYPE k = _jptr[i]; k < _jptr[i + 1] && _ai[k] < i; k++)
+          s -= _lu[k] * z[_ai[k]];
+        z[i] = s;
+      }
+      for(int i = _n - 1; i >= 0; i--){
+        double s = z[i];
+        for(INDEX_TYPE k = _jptr[i + 1] - 1; k >= _jptr[i] && _ai[k] > i; k--)
+          s -= _lu[k] * z[_ai[k]];
+        z[i] = s * _invDiag[i];
+      }
+    }
+    else if(_type == linearSystemCSRKrylov<double>::SSOR){
+      // z = w (2 - w) (D + w U)^-1 D (D + w L)^-1 r
+      for(int i = 0; i < _n; i++){
+        double s = r[i];
+        for(INDEX_TYPE k = _jptr[i]; k < _jptr[i + 1] && _ai[k] < i; k++)
+          s -= _omega * _a[k] * z[_ai[k]];
+        z[i] = s * _invDiag[i];
+      }
+      for(int i = _n - 1; i >= 0; i--){
+        double s = z[i] / _invDiag[i];
+        for(INDEX_TYPE k = _jptr[i + 1] - 1; k >= _jptr[i] && _ai[k] > i; k--)
+          s -= _omega * _a[k] * z[_ai[k]];
+        z[i] = s * _invDiag[i];
+      }
+      double f = _omega * (2. - _omega);
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+      for(int i = 0; i < _n; i++) z[i] *= f;
+    }
+    else{
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+      for(int i = 0; i < _n; i++) z[i] = r[i] * _invDiag[i];
+    }
+  }
+};
+
+template<>
+int linearSystemCSRKrylov<double>::systemSolve()
+{
+  if(!_a) return 1;
+  INDEX_TYPE *jptr, *ai;
+  double *a;
+  getMatrix(jptr, ai, a);
+  int n = _b->size();
+  double *x = &(*_x)[0];
+  const double *b = &(*_b)[0];
+
+  double t1 = Cpu();
+  csrPreconditioner M(_precond, n, jptr, ai, a, _omega);
+  double normb = sqrt(csrDot(n, b, b));
+  if(normb == 0.){
+    zeroSolution();
+    return 1;
+  }
+
+  std::vector<double> r(n), z(n);
+  double res = 0.;
+  int iter = 0;
+  if(!_gmres){
+    // preconditioned conjugate gradient
+    std::vector<double> p(n), q(n);
+    csrMult(n, jptr, ai, a, x, &q[0]);
+    for(int i = 0; i < n; i++) r[i] = b[i] - q[i];
+    res = sqrt(csrDot(n, &r[0], &r[0])) / normb;
+    M.apply(&r[0], &z[0]);
+    p = z;
+    double rz = csrDot(n, &r[0], &z[0]);
+    while(res > _prec && iter < _maxIter){
+      csrMult(n, jptr, ai, a, &p[0], &q[0]);
+      double alpha = rz / csrDot(n, &p[0], &q[0]);
+      csrAxpy(n, alpha, &p[0], x);
+      csrAxpy(n, -alpha, &q[0], &r[0]);
+      res = sqrt(csrDot(n, &r[0], &r[0])) / normb;
+      iter++;
+      if(_noisy) Msg::Info("CG iteration %d: residual %g", iter, res);
+      if(res <= _prec) break;
+      M.apply(&r[0], &z[0]);
+      double rzNew = csrDot(n, &r[0], &z[0]);
+      csrXpay(n, &z[0], rzNew / rz, &p[0]);
+      rz = rzNew;
+    }
+  }
+  else{
+    // right-preconditioned GMRES, restarted every _restart iterations
+    int m = std::max(1, _restart);
+    std::vector<std::vector<double> > V(m + 1, std::vector<double>(n));
+    std::vector<std::vector<double> > H(m + 1, std::vector<double>(m, 0.));
+    std::vector<double> c(m), s(m), g(m + 1), y(m);
+    while(1){
+      csrMult(n, jptr, ai, a, x, &z[0]);
+      for(int i = 0; i < n; i++) r[i] = b[i] - z[i];
+      double beta = sqrt(csrDot(n, &r[0], &r[0]));
+      res = beta / normb;
+      if(res <= _prec || iter >= _maxIter) break;
+      for(int i = 0; i < n; i++) V[0][i] = r[i] / beta;
+      std::fill(g.begin(), g.end(), 0.);
+      g[0] = beta;
+      int k = 0;
+      while(k < m && iter < _maxIter){
+        M.apply(&V[k][0], &z[0]);
+        double *w = &V[k + 1][0];
+        csrMult(n, jptr, ai, a, &z[0], w);
+        // modified Gram-Schmidt orthogonalization
+        for(int i = 0; i <= k; i++){
+          H[i][k] = csrDot(n, w, &V[i][0]);
+          csrAxpy(n, -H[i][k], &V[i][0], w);
+        }
+        H[k + 1][k] = sqrt(csrDot(n, w, w));
+        if(H[k + 1][k] != 0.){
+          double f = 1. / H[k + 1][k];
+#if defined(_OPENMP)
+#pragma omp parallel for
+#endif
+          for(int i = 0; i < n; i++) w[i] *= f;
+        }
+        // Givens rotations
+        for(int i = 0; i < k; i++){
+          double h = c[i] * H[i][k] + s[i] * H[i + 1][k];
+          H[i + 1][k] = -s[i] * H[i][k] + c[i] * H[i + 1][k];
+          H[i][k] = h;
+        }
+        double d = sqrt(H[k][k] * H[k][k] + H[k + 1][k] * H[k + 1][k]);
+        c[k] = (d == 0.) ? 1. : H[k][k] / d;
+        s[k] = (d == 0.) ? 0. : H[k + 1][k] / d;
+        H[k][k] = d;
+        H[k + 1][k] = 0.;
+        g[k + 1] = -s[k] * g[k];
+        g[k] *= c[k];
+        k++;
+        iter++;
+        res = fabs(g[k]) / normb;
+        if(_noisy) Msg::Info("GMRES iteration %d: residual %g", iter, res);
+        if(res <= _prec || d == 0.) break;
+      }
+      // x = x + M^-1 V y, with H y = g
+      for(int i = k - 1; i >= 0; i--){
+        y[i] = g[i];
+        for(int j = i + 1; j < k; j++) y[i] -= H[i][j] * y[j];
+        y[i] = (H[i][i] == 0.) ? 0. : y[i] / H[i][i];
+      }
+      std::fill(r.begin(), r.end(), 0.);
+      for(int i = 0; i < k; i++) csrAxpy(n, y[i], &V[i][0], &r[0]);
+      M.apply(&r[0], &z[0]);
+      csrAxpy(n, 1., &z[0], x);
+    }
+  }
+  double t2 = Cpu();
+  if(res > _prec)
+    Msg::Warning("%s did not converge in %d iterations (residual %g)",
+                 _gmres ? "GMRES" : "CG", iter, res);
+  else
+    Msg::Debug("%s has solved %d unknowns in %d iterations (%8.3f seconds)",
+               _gmres ? "GMRES" : "CG", n, iter, t2 - t1);
+  return 1;
+}
+
 #if defined(HAVE_GMM)
 
 #include "gmm.h"
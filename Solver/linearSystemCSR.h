@@ -34,6 +34,19 @@ class linearSystemCSR : public linearSystem<scalar> {
   CSRList_T *_a, *_ai, *_ptr, *_jptr;
   std::vector<scalar> *_b, *_x;
   sparsityPattern _sparsity; // only used for pre-allocation, does not store the sparsity once allocated
+  // add a value to an existing entry, atomically if called from several
+  // threads
+  static inline void _addValue(scalar &a, const scalar &val)
+  {
+#if defined(_OPENMP)
+    if(Msg::GetNumThreads() > 1){
+#pragma omp atomic
+      a += val;
+      return;
+    }
+#endif
+    a += val;
+  }
  public:
   linearSystemCSR()
     : sorted(false), _entriesPreAllocated(false), _a(0), _b(0), _x(0) {}
@@ -51,7 +64,13 @@ class linearSystemCSR : public linearSystem<scalar> {
     _sparsity.insertEntry (i,j);
   }
   virtual void preAllocateEntries ();
-  virtual void addToMatrix(int il, int ic, const scalar &val) 
+  // once the entries are sorted (i.e. after preAllocateEntries() if a
+  // sparsity pattern has been given, or after the first solve), the values
+  // of the entries of the pattern are added in place, and can be added
+  // concurrently from several threads: assembling the same system again
+  // (after zeroMatrix()) only requires this numeric pass
+  virtual bool isThreadSafe() const { return _a && sorted; }
+  virtual void addToMatrix(int il, int ic, const scalar &val)
   {
     if (!_entriesPreAllocated)
       preAllocateEntries();
@@ -72,19 +91,31 @@ class linearSystemCSR : public linearSystem<scalar> {
         else  if (ai[position] < ic)
           p0 = position + 1;
         else {
-          a[position] += val;
+          _addValue(a[position], val);
           return;
         }
       }
       for (position = p0; position < p1; position++) {
         if (ai[position] >= ic) {
           if (ai[position] == ic){
-            a[position] += val;
+            _addValue(a[position], val);
             return;
           }
           break;
         }
       }
+      // the entry is not in the sorted pattern: it is appended at the end of
+      // the row, and the columns will be sorted again before solving
+      if (Msg::GetNumThreads() > 1) {
+        Msg::Error("Entry (%d, %d) is not in the sparsity pattern of the matrix",
+                   il, ic);
+        return;
+      }
+      sorted = false;
+      position = jptr[il];
+      if(something[il]) {
+        while (ptr[position] != 0) position = ptr[position];
+      }
     } else if(something[il]) {
       while(1){
         if(ai[position] == ic){
@@ -123,7 +154,7 @@ class linearSystemCSR : public linearSystem<scalar> {
   }
   virtual void addToRightHandSide(int row, const scalar &val)
   {
-    if(val != 0.0) (*_b)[row] += val;
+    if(val != 0.0) _addValue((*_b)[row], val);
   }
   virtual void addToSolution(int row, const scalar &val)
   {
@@ -189,6 +220,36 @@ class linearSystemCSRGmm : public linearSystemCSR<scalar> {
   ;
 };
 
+// Iterative solver for CSR systems without external dependency: conjugate
+// gradient (for symmetric positive definite matrices) or restarted GMRES,
+// with a Jacobi, ILU(0) or SSOR preconditioner. The matrix-vector products,
+// the vector operations and the Jacobi preconditioner are multithreaded with
+// OpenMP; the triangular solves of the ILU(0) and SSOR preconditioners are
+// sequential.
+template <class scalar>
+class linearSystemCSRKrylov : public linearSystemCSR<scalar> {
+ public:
+  enum preconditioner {JACOBI, ILU0, SSOR};
+ private:
+  double _prec, _omega;
+  int _noisy, _gmres, _restart, _maxIter;
+  preconditioner _precond;
+ public:
+  linearSystemCSRKrylov()
+    : _prec(1.e-8), _omega(1.), _noisy(0), _gmres(0), _restart(30),
+      _maxIter(10000), _precond(ILU0) {}
+  virtual ~linearSystemCSRKrylov(){}
+  void setPrec(double p){ _prec = p; }
+  void setNoisy(int n){ _noisy = n; }
+  void setGmres(int n){ _gmres = n; }
+  void setRestart(int n){ _restart = n; }
+  void setMaxIterations(int n){ _maxIter = n; }
+  void setPreconditioner(preconditioner p){ _precond = p; }
+  // relaxation factor of the SSOR preconditioner, in ]0, 2[
+  void setOmega(double w){ _omega = w; }
+  virtual int systemSolve();
+};
+
 template <class scalar>
 class linearSystemCSRTaucs : public linearSystemCSR<scalar> {
  public:
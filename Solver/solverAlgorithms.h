@@ -11,6 +11,7 @@
 #define _SOLVERALGORITHMS_H_
 
 
+#include <set>
 #include "dofManager.h"
 #include "terms.h"
 #include "quadratureRules.h"
@@ -18,6 +19,40 @@
 
 
 
+template<class Iterator, class Assembler> void SparsityDofs(FunctionSpaceBase &space,
+                                                            Iterator itbegin, Iterator itend,
+                                                            Assembler &assembler) // symmetric
+{
+  std::vector<Dof> R;
+  for (Iterator it = itbegin; it != itend; ++it){
+    R.clear();
+    space.getKeys(*it, R);
+    for (unsigned int i = 0; i < R.size(); i++)
+      for (unsigned int j = 0; j < R.size(); j++)
+        assembler.insertInSparsityPattern(R[i], R[j]);
+  }
+}
+
+template<class Iterator, class Assembler> void SparsityDofs(FunctionSpaceBase &shapeFcts,
+                                                            FunctionSpaceBase &testFcts,
+                                                            Iterator itbegin, Iterator itend,
+                                                            Assembler &assembler) // non symmetric
+{
+  std::vector<Dof> R, C;
+  for (Iterator it = itbegin; it != itend; ++it){
+    R.clear();
+    C.clear();
+    shapeFcts.getKeys(*it, R);
+    testFcts.getKeys(*it, C);
+    for (unsigned int i = 0; i < R.size(); i++){
+      for (unsigned int j = 0; j < C.size(); j++){
+        assembler.insertInSparsityPattern(R[i], C[j]);
+        assembler.insertInSparsityPattern(C[j], R[i]);
+      }
+    }
+  }
+}
+
 template<class Iterator, class Assembler> void Assemble(BilinearTermBase &term, FunctionSpaceBase &space,
                                                         Iterator itbegin, Iterator itend,
                                                         QuadratureBase &integrator, Assembler &assembler)
@@ -36,6 +71,53 @@ template<class Iterator, class Assembler> void Assemble(BilinearTermBase &term,
   }
 }
 
+// Assemble the element matrices in parallel: if the sparsity pattern of the
+// linear system has been given beforehand (see SparsityDofs), the matrix is
+// allocated once and only the values are added, concurrently. The first
+// element of each type is assembled serially, which initializes the
+// integration points and the shape functions of the type; the assembly is
+// completely serial if the linear system does not support concurrent
+// additions.
+template<class Iterator, class Assembler> void AssembleInParallel(BilinearTermBase &term,
+                                                                  FunctionSpaceBase &space,
+                                                                  Iterator itbegin, Iterator itend,
+                                                                  QuadratureBase &integrator,
+                                                                  Assembler &assembler)
+  // symmetric
+{
+  std::vector<MElement*> first, others;
+  std::set<int> types;
+  for (Iterator it = itbegin; it != itend; ++it){
+    MElement *e = *it;
+    if (types.insert(e->getTypeForMSH()).second) first.push_back(e);
+    else others.push_back(e);
+  }
+  Assemble(term, space, first.begin(), first.end(), integrator, assembler);
+  if (!assembler.isThreadSafe()){
+    Assemble(term, space, others.begin(), others.end(), integrator, assembler);
+    return;
+  }
+#if defined(_OPENMP)
+#pragma omp parallel
+#endif
+  {
+    fullMatrix<typename Assembler::dataMat> localMatrix;
+    std::vector<Dof> R;
+#if defined(_OPENMP)
+#pragma omp for schedule(dynamic, 64)
+#endif
+    for (int i = 0; i < (int)others.size(); i++){
+      MElement *e = others[i];
+      R.clear();
+      IntPt *GP;
+      int npts = integrator.getIntPoints(e, &GP);
+      term.get(e, npts, GP, localMatrix);
+      space.getKeys(e, R);
+      assembler.assemble(R, localMatrix);
+    }
+  }
+}
+
 template<class Assembler> void Assemble(BilinearTermBase &term, FunctionSpaceBase &space, MElement *e,
                                         QuadratureBase &integrator, Assembler &assembler) // symmetric
 {
@@ -43,7 +43,9 @@
 #include "MPrism.h"
 #include "MLine.h"
 #include "OS.h"
+#include "BasisFactory.h"
 #include <stack>
+#include <algorithm>
 
 #if defined(HAVE_BFGS)
 
@@ -338,6 +340,91 @@ static std::vector<std::pair<std::set<MElement*>, std::set<MVertex*> > > getConn
   return result;
 }
 
+// Color the blobs so that two blobs of the same color share no vertex (in
+// their elements or in their fixed boundary): the blobs of a color can then
+// be optimized concurrently, as each one only moves its own free vertices.
+static int colorBlobs
+  (const std::vector<std::pair<std::set<MElement*>, std::set<MVertex*> > > &blobs,
+   std::vector<std::vector<int> > &blobsByColor)
+{
+  std::map<MVertex*, std::vector<int> > vertex2blobs;
+  for (int iB = 0; iB < blobs.size(); ++iB) {
+    std::set<MVertex*> verts(blobs[iB].second);
+    for (std::set<MElement*>::const_iterator itE = blobs[iB].first.begin();
+         itE != blobs[iB].first.end(); ++itE)
+      for (int j = 0; j < (*itE)->getNumVertices(); ++j)
+        verts.insert((*itE)->getVertex(j));
+    for (std::set<MVertex*>::iterator itV = verts.begin(); itV != verts.end(); ++itV)
+      vertex2blobs[*itV].push_back(iB);
+  }
+
+  std::vector<std::set<int> > neighbours(blobs.size());
+  for (std::map<MVertex*, std::vector<int> >::iterator it = vertex2blobs.begin();
+       it != vertex2blobs.end(); ++it)
+    for (int i = 0; i < it->second.size(); ++i)
+      for (int j = 0; j < it->second.size(); ++j)
+        if (i != j) neighbours[it->second[i]].insert(it->second[j]);
+
+  // greedy coloring, the largest blobs first so that they are spread over the
+  // colors
+  std::vector<std::pair<int, int> > order;
+  for (int iB = 0; iB < blobs.size(); ++iB)
+    order.push_back(std::make_pair(-(int)blobs[iB].first.size(), iB));
+  std::sort(order.begin(), order.end());
+
+  std::vector<int> color(blobs.size(), -1);
+  blobsByColor.clear();
+  for (int k = 0; k < order.size(); ++k) {
+    const int iB = order[k].second;
+    std::set<int> used;
+    for (std::set<int>::iterator it = neighbours[iB].begin();
+         it != neighbours[iB].end(); ++it)
+      if (color[*it] >= 0) used.insert(color[*it]);
+    int c = 0;
+    while (used.count(c)) c++;
+    color[iB] = c;
+    if (c >= blobsByColor.size()) blobsByColor.resize(c + 1);
+    blobsByColor[c].push_back(iB);
+  }
+  return blobsByColor.size();
+}
+
+static int optimizeBlob
+  (const std::map<MElement*,GEntity*> &element2entity,
+   std::pair<std::set<MElement*>, std::set<MVertex*> > &blob, int i,
+   int numBlobs, OptHomParameters &p, int samples, double &minJac,
+   double &maxJac)
+{
+  Msg::Info("Optimizing a blob %i/%i composed of %4d elements", i+1,
+            numBlobs, blob.first.size());
+  fflush(stdout);
+  OptHOM temp(element2entity, blob.first, blob.second, p.fixBndNodes);
+  std::ostringstream ossI1;
+  ossI1 << "initial_blob-" << i << ".msh";
+  temp.mesh.writeMSH(ossI1.str().c_str());
+  int success = -1;
+  if (temp.mesh.nPC() == 0)
+    Msg::Info("Blob %i has no degree of freedom, skipping", i+1);
+  else
+    success = temp.optimize(p.weightFixed, p.weightFree, p.optCADWeight, p.BARRIER_MIN,
+                            p.BARRIER_MAX, false, samples, p.itMax, p.optPassMax, p.optCAD, p.optCADDistMax, p.discrTolerance);
+  if (success >= 0 && p.BARRIER_MIN_METRIC > 0) {
+    Msg::Info("Jacobian optimization succeed, starting svd optimization");
+    success = temp.optimize(p.weightFixed, p.weightFree, p.optCADWeight, p.BARRIER_MIN_METRIC, p.BARRIER_MAX,
+                            true, samples, p.itMax, p.optPassMax, p.optCAD, p.optCADDistMax,p.discrTolerance);
+  }
+  double distMaxBND, distAvgBND;
+  temp.recalcJacDist();
+  temp.getJacDist(minJac, maxJac, distMaxBND, distAvgBND);
+  temp.mesh.updateGEntityPositions();
+  //if (success <= 0) {
+    std::ostringstream ossI2;
+    ossI2 << "final_ITER_" << i << ".msh";
+    temp.mesh.writeMSH(ossI2.str().c_str());
+  //}
+  return success;
+}
+
 static void optimizeConnectedBlobs
   (const std::map<MVertex*, std::vector<MElement *> > &vertex2elements,
    const std::map<MElement*,GEntity*> &element2entity,
@@ -352,42 +439,52 @@ static void optimizeConnectedBlobs
                           getConnectedBlobs(vertex2elements, badasses, p.nbLayers,
                                     p.distanceFactor, weakMerge, p.optPrimSurfMesh);
 
-  //#pragma omp parallel for schedule(dynamic, 1)
-  for (int i = 0; i < toOptimize.size(); ++i) {
-//    if (toOptimize[i].first.size() > 10000) continue;
-    Msg::Info("Optimizing a blob %i/%i composed of %4d elements", i+1,
-              toOptimize.size(), toOptimize[i].first.size());
-    fflush(stdout);
-    OptHOM temp(element2entity, toOptimize[i].first, toOptimize[i].second, p.fixBndNodes);
-    std::ostringstream ossI1;
-    ossI1 << "initial_blob-" << i << ".msh";
-    temp.mesh.writeMSH(ossI1.str().c_str());
-    int success = -1;
-    if (temp.mesh.nPC() == 0)
-      Msg::Info("Blob %i has no degree of freedom, skipping", i+1);
-    else
-      success = temp.optimize(p.weightFixed, p.weightFree, p.optCADWeight, p.BARRIER_MIN,
-                              p.BARRIER_MAX, false, samples, p.itMax, p.optPassMax, p.optCAD, p.optCADDistMax, p.discrTolerance);
-    if (success >= 0 && p.BARRIER_MIN_METRIC > 0) {
-      Msg::Info("Jacobian optimization succeed, starting svd optimization");
-      success = temp.optimize(p.weightFixed, p.weightFree, p.optCADWeight, p.BARRIER_MIN_METRIC, p.BARRIER_MAX,
-                              true, samples, p.itMax, p.optPassMax, p.optCAD, p.optCADDistMax,p.discrTolerance);
+  std::vector<std::vector<int> > blobsByColor;
+  const int numColors = colorBlobs(toOptimize, blobsByColor);
+  Msg::Info("Optimizing %i blobs in %i groups of independent blobs (%i threads)",
+            toOptimize.size(), numColors, Msg::GetMaxThreads());
+
+  // build the bases of all the element types before optimizing the blobs
+  // concurrently, so that the threads never build them at the same time
+  std::set<int> types;
+  for (unsigned int i = 0; i < toOptimize.size(); ++i)
+    for (std::set<MElement*>::const_iterator it = toOptimize[i].first.begin();
+         it != toOptimize[i].first.end(); ++it)
+      if (types.insert((*it)->getTypeForMSH()).second) {
+        BasisFactory::preload((*it)->getTypeForMSH());
+        const int tag1 = ElementType::getTag((*it)->getType(), 1);
+        if (tag1) BasisFactory::preload(tag1);
+      }
+
+  const double t1 = GetTimeInSeconds();
+  for (int c = 0; c < numColors; ++c) {
+    const std::vector<int> &blobs = blobsByColor[c];
+#if defined(_OPENMP)
+#pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (int k = 0; k < blobs.size(); ++k) {
+      const int i = blobs[k];
+//      if (toOptimize[i].first.size() > 10000) continue;
+      const double tb = GetTimeInSeconds();
+      double minJac, maxJac;
+      const int success = optimizeBlob(element2entity, toOptimize[i], i,
+                                       toOptimize.size(), p, samples,
+                                       minJac, maxJac);
+      Msg::Info("Blob %i (%d elements) optimized in %g s by thread %d", i+1,
+                toOptimize[i].first.size(), GetTimeInSeconds() - tb,
+                Msg::GetThreadNum());
+#if defined(_OPENMP)
+#pragma omp critical
+#endif
+      {
+        p.minJac = std::min(p.minJac,minJac);
+        p.maxJac = std::max(p.maxJac,maxJac);
+        p.SUCCESS = std::min(p.SUCCESS, success);
+      }
     }
-    double minJac, maxJac, distMaxBND, distAvgBND;
-    temp.recalcJacDist();
-    temp.getJacDist(minJac, maxJac, distMaxBND, distAvgBND);
-    p.minJac = std::min(p.minJac,minJac);
-    p.maxJac = std::max(p.maxJac,maxJac);
-    temp.mesh.updateGEntityPositions();
-    //if (success <= 0) {
-      std::ostringstream ossI2;
-      ossI2 << "final_ITER_" << i << ".msh";
-      temp.mesh.writeMSH(ossI2.str().c_str());
-    //}
-    //#pragma omp critical
-    p.SUCCESS = std::min(p.SUCCESS, success);
   }
-
+  Msg::Info("Optimized %i blobs in %g s", toOptimize.size(),
+            GetTimeInSeconds() - t1);
 }
 
 static MElement *getWorstElement(std::set<MElement*> &badasses, OptHomParameters &p)
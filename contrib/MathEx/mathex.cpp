@@ -674,6 +674,101 @@
       #endif
          return evalstack[0];
       } // eval()
+
+       void mathex::eval(unsigned n, vector<double const *> const &vars,
+                         double *res) const
+      //  Eval the parsed stack at n points, by blocks of points: each code
+      //  token is applied to a whole block at once
+      {
+         const unsigned BLOCK = 256;
+
+         if(status != parsed) throw error("eval()", "expression not parsed");
+         if(vars.size() < vartable.size()) throw error("eval()", "missing variable values");
+
+         // maximum depth of the evaluation stack
+         int depth = 0, maxdepth = 1;
+         for(unsigned i=0; i<bytecode.size(); i++) {
+            switch(bytecode[i].state) {
+               case CODETOKEN::VALUE:
+               case CODETOKEN::VARIABLE: depth++; break;
+               case CODETOKEN::BINOP: depth--; break;
+               case CODETOKEN::USERFUNC:
+                  depth += (bytecode[i].numargs > 0) ? 1 - (int)bytecode[i].numargs : 1;
+                  break;
+               default: break;
+            }
+            if(depth > maxdepth) maxdepth = depth;
+         }
+
+         vector<double> stack(maxdepth * BLOCK), x;
+         for(unsigned start=0; start<n; start+=BLOCK) {
+            const unsigned m = (n - start < BLOCK) ? n - start : BLOCK;
+            double *top = &stack[0] - BLOCK; // current top of the stack
+            for(unsigned i=0; i<bytecode.size(); i++) {
+               const CODETOKEN &tok = bytecode[i];
+               switch(tok.state) {
+                  case CODETOKEN::VALUE:
+                     top += BLOCK;
+                     for(unsigned k=0; k<m; k++) top[k] = tok.value;
+                     break;
+                  case CODETOKEN::VARIABLE:
+                     {
+                        top += BLOCK;
+                        const double *v = vars[tok.idx] + start;
+                        for(unsigned k=0; k<m; k++) top[k] = v[k];
+                     }
+                     break;
+                  case CODETOKEN::FUNCTION:
+                     if(tok.idx == 0) // unary minus
+                        for(unsigned k=0; k<m; k++) top[k] = -top[k];
+                     else
+                        for(unsigned k=0; k<m; k++) top[k] = cfunctable[tok.idx].f(top[k]);
+                     break;
+                  case CODETOKEN::BINOP:
+                     {
+                        double *a = top - BLOCK, *b = top;
+                        switch(binoptable[tok.idx].name) {
+                           case '+': for(unsigned k=0; k<m; k++) a[k] += b[k]; break;
+                           case '-': for(unsigned k=0; k<m; k++) a[k] -= b[k]; break;
+                           case '*': for(unsigned k=0; k<m; k++) a[k] *= b[k]; break;
+                           case '/':
+                              for(unsigned k=0; k<m; k++) {
+                                 if(b[k] == 0)
+                                    throw error("Error [binary_divide()]: divisin by zero");
+                                 a[k] /= b[k];
+                              }
+                              break;
+                           default:
+                              for(unsigned k=0; k<m; k++)
+                                 a[k] = binoptable[tok.idx].f(a[k], b[k]);
+                        }
+                        top = a;
+                     }
+                     break;
+                  case CODETOKEN::USERFUNC:
+                     if(tok.numargs > 0) {
+                        x.resize(tok.numargs);
+                        double *first = top - (tok.numargs - 1) * BLOCK;
+                        for(unsigned k=0; k<m; k++) {
+                           for(unsigned j=0; j<tok.numargs; j++)
+                              x[j] = first[j * BLOCK + k];
+                           first[k] = functable[tok.idx].f(x);
+                        }
+                        top = first;
+                     }
+                     else {
+                        x.clear();
+                        top += BLOCK;
+                        for(unsigned k=0; k<m; k++) top[k] = functable[tok.idx].f(x);
+                     }
+                     break;
+                  default:
+                     throw error("eval()", "invalid code token");
+               }
+            }
+            for(unsigned k=0; k<m; k++) res[start + k] = stack[k];
+         }
+      } // eval()
    
    /////////////////
    // parser
@@ -255,6 +255,11 @@ using namespace std;
          return pos; }
       void parse(); /// < parse expression 
       double eval(); /// < eval expression
+      /// eval expression at n points: the values of the i-th variable (in the
+      /// order of addvar) are read from vars[i][0..n-1], and the results are
+      /// stored in res[0..n-1]. Does not modify the object, and can thus be
+      /// called concurrently
+      void eval(unsigned n, vector<double const *> const &vars, double *res) const;
       void reset(); /// < reset all
        mathex() /// < default constructor
       {reset();}
@@ -0,0 +1,75 @@
+// Benchmark of the 3D Delaunay refinement of a unit cube, with points
+// inserted one by one and by batches. Usage:
+//
+//   mainBenchmarkDelaunay3D [characteristic length (default: 0.02)]
+//                           [batch size per thread (default: 64)]
+//                           [max number of threads (default: 64)]
+//
+// The points are first inserted one by one, then by batches with 1, 2, 4,
+// ... threads, up to the max number of threads (if Gmsh is compiled with
+// OpenMP; the number of threads can exceed the number of cores, in which case
+// the timings only measure the overhead of the concurrent cavity search).
+
+#include <stdio.h>
+#include <stdlib.h>
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+#include "Gmsh.h"
+#include "GModel.h"
+#include "GmshMessage.h"
+#include "OS.h"
+
+static void writeCube(const char *name, double lc)
+{
+  FILE *fp = fopen(name, "w");
+  fprintf(fp, "lc = %g;\n", lc);
+  fprintf(fp, "Point(1) = {0, 0, 0, lc}; Point(2) = {1, 0, 0, lc};\n");
+  fprintf(fp, "Point(3) = {1, 1, 0, lc}; Point(4) = {0, 1, 0, lc};\n");
+  fprintf(fp, "Line(1) = {1, 2}; Line(2) = {2, 3}; Line(3) = {3, 4};\n");
+  fprintf(fp, "Line(4) = {4, 1};\n");
+  fprintf(fp, "Line Loop(1) = {1, 2, 3, 4}; Plane Surface(1) = {1};\n");
+  fprintf(fp, "Extrude {0, 0, 1} { Surface{1}; }\n");
+  fclose(fp);
+}
+
+static void meshCube(const char *name, int batchSize)
+{
+  GmshSetOption("Mesh", "DelaunayBatchSize3D", (double)batchSize);
+  GModel *m = new GModel();
+  m->readGEO(name);
+  m->mesh(2);
+  double t1 = GetTimeInSeconds();
+  m->mesh(3);
+  double t2 = GetTimeInSeconds();
+  printf("%d thread(s), batch size %4d: %d vertices, %d elements in %g s\n",
+         Msg::GetMaxThreads(), batchSize, m->getNumMeshVertices(),
+         m->getNumMeshElements(), t2 - t1);
+  delete m;
+}
+
+int main(int argc, char **argv)
+{
+  GmshInitialize();
+  GmshSetOption("General", "Verbosity", 2.);
+  GmshSetOption("Mesh", "Algorithm3D", 1.);
+  double lc = (argc > 1) ? atof(argv[1]) : 0.02;
+  int batchSize = (argc > 2) ? atoi(argv[2]) : 64;
+
+  writeCube("bench_cube.geo", lc);
+#if defined(_OPENMP)
+  omp_set_num_threads(1);
+#endif
+  meshCube("bench_cube.geo", 0);
+#if defined(_OPENMP)
+  int maxThreads = (argc > 3) ? atoi(argv[3]) : 64;
+  for(int n = 1; n <= maxThreads; n *= 2){
+    omp_set_num_threads(n);
+    meshCube("bench_cube.geo", batchSize);
+  }
+#else
+  meshCube("bench_cube.geo", batchSize);
+#endif
+
+  GmshFinalize();
+}
@@ -0,0 +1,161 @@
+// Benchmark of the dof numbering and of the assembly of a linear system with
+// the dofManager, on a structured tetrahedral mesh of a cube with 3 dofs per
+// node (as in a linear elasticity problem), with the nodes on one face
+// fixed. Usage:
+//
+//   mainBenchmarkDofManager [number of subdivisions (default: 40)]
+//                           [number of assemblies (default: 5)]
+//
+// The assembly is done sequentially, and in parallel (with the maximum number
+// of threads, controlled by OMP_NUM_THREADS).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "Gmsh.h"
+#include "GModel.h"
+#include "MVertex.h"
+#include "MTetrahedron.h"
+#include "dofManager.h"
+#include "linearSystemCSR.h"
+#include "GmshMessage.h"
+#include "OS.h"
+
+static void getKeys(MElement *e, std::vector<Dof> &R)
+{
+  R.clear();
+  for(int i = 0; i < e->getNumVertices(); i++)
+    for(int j = 0; j < 3; j++)
+      R.push_back(Dof(e->getVertex(i)->getNum(),
+                      Dof::createTypeWithTwoInts(j, 1)));
+}
+
+static void getMatrix(fullMatrix<double> &m)
+{
+  m.resize(12, 12);
+  for(int i = 0; i < 12; i++){
+    for(int j = 0; j < 12; j++) m(i, j) = -1.;
+    m(i, i) = 12.;
+  }
+}
+
+static void assemble(dofManager<double> &dm, linearSystem<double> *lsys,
+                     std::vector<MElement*> &elements, int numAssemblies)
+{
+  fullMatrix<double> m;
+  getMatrix(m);
+  std::vector<Dof> R;
+  for(int k = 0; k < numAssemblies; k++){
+    double t1 = GetTimeInSeconds();
+    lsys->zeroMatrix();
+    lsys->zeroRightHandSide();
+    for(unsigned int i = 0; i < elements.size(); i++){
+      getKeys(elements[i], R);
+      dm.assemble(R, m);
+    }
+    double t2 = GetTimeInSeconds();
+    printf("assembly %d: %g s\n", k + 1, t2 - t1);
+  }
+}
+
+static void assembleInParallel(dofManager<double> &dm, linearSystem<double> *lsys,
+                               std::vector<MElement*> &elements,
+                               int numAssemblies)
+{
+  if(!dm.isThreadSafe()){
+    printf("linear system does not support parallel assembly\n");
+    return;
+  }
+  for(int k = 0; k < numAssemblies; k++){
+    double t1 = GetTimeInSeconds();
+    lsys->zeroMatrix();
+    lsys->zeroRightHandSide();
+#if defined(_OPENMP)
+#pragma omp parallel
+#endif
+    {
+      fullMatrix<double> m;
+      getMatrix(m);
+      std::vector<Dof> R;
+#if defined(_OPENMP)
+#pragma omp for
+#endif
+      for(int i = 0; i < (int)elements.size(); i++){
+        getKeys(elements[i], R);
+        dm.assemble(R, m);
+      }
+    }
+    double t2 = GetTimeInSeconds();
+    printf("assembly %d (%d threads): %g s\n", k + 1, Msg::GetMaxThreads(),
+           t2 - t1);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  GmshInitialize();
+  GmshSetOption("General", "Verbosity", 2.);
+  int n = (argc > 1) ? atoi(argv[1]) : 40;
+  int numAssemblies = (argc > 2) ? atoi(argv[2]) : 5;
+
+  new GModel();
+  std::vector<MVertex*> vertices;
+  for(int k = 0; k <= n; k++)
+    for(int j = 0; j <= n; j++)
+      for(int i = 0; i <= n; i++)
+        vertices.push_back(new MVertex((double)i / n, (double)j / n,
+                                       (double)k / n));
+  std::vector<MElement*> elements;
+  static const int tets[6][4] = {{0, 1, 3, 7}, {0, 1, 7, 5}, {0, 5, 7, 4},
+                                 {0, 3, 2, 7}, {0, 6, 7, 2}, {0, 4, 7, 6}};
+  for(int k = 0; k < n; k++){
+    for(int j = 0; j < n; j++){
+      for(int i = 0; i < n; i++){
+        MVertex *v[8];
+        for(int c = 0; c < 8; c++)
+          v[c] = vertices[(i + (c & 1)) + (n + 1) * ((j + ((c >> 1) & 1)) +
+                                                     (n + 1) * (k + (c >> 2)))];
+        for(int t = 0; t < 6; t++)
+          elements.push_back(new MTetrahedron(v[tets[t][0]], v[tets[t][1]],
+                                              v[tets[t][2]], v[tets[t][3]]));
+      }
+    }
+  }
+  printf("%d nodes, %d tetrahedra\n", (int)vertices.size(), (int)elements.size());
+
+  linearSystemCSRGmm<double> *lsys = new linearSystemCSRGmm<double>;
+  dofManager<double> dm(lsys);
+
+  double t1 = GetTimeInSeconds();
+  for(unsigned int i = 0; i < vertices.size(); i++){
+    if(vertices[i]->z() == 0.){
+      for(int j = 0; j < 3; j++)
+        dm.fixDof(vertices[i]->getNum(), Dof::createTypeWithTwoInts(j, 1), 0.);
+    }
+  }
+  std::vector<Dof> R;
+  for(unsigned int i = 0; i < elements.size(); i++){
+    getKeys(elements[i], R);
+    for(unsigned int j = 0; j < R.size(); j++) dm.numberDof(R[j]);
+  }
+  double t2 = GetTimeInSeconds();
+  printf("numbering: %g s (%d unknowns, %d fixed dofs)\n", t2 - t1,
+         dm.sizeOfR(), dm.sizeOfF());
+
+  for(unsigned int i = 0; i < elements.size(); i++){
+    getKeys(elements[i], R);
+    for(unsigned int j = 0; j < R.size(); j++)
+      for(unsigned int k = 0; k < R.size(); k++)
+        dm.insertInSparsityPattern(R[j], R[k]);
+  }
+  double t3 = GetTimeInSeconds();
+  printf("sparsity pattern: %g s\n", t3 - t2);
+
+  assemble(dm, lsys, elements, numAssemblies);
+  assembleInParallel(dm, lsys, elements, numAssemblies);
+
+  for(unsigned int i = 0; i < elements.size(); i++) delete elements[i];
+  for(unsigned int i = 0; i < vertices.size(); i++) delete vertices[i];
+  delete lsys;
+  GmshFinalize();
+}
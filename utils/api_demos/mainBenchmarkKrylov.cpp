@@ -0,0 +1,104 @@
+// Check of the native Krylov solver of linearSystemCSRKrylov against the
+// direct (LU) solver of linearSystemFull, on finite difference systems on an
+// n x n grid: a Laplacian (symmetric positive definite, solved with CG and
+// GMRES) and a convection-diffusion operator with upwind convection
+// (non-symmetric, solved with GMRES), with each preconditioner. Usage:
+//
+//   mainBenchmarkKrylov [grid size n (default: 30)]
+//
+// The program returns 1 if a Krylov solution differs from the direct solution
+// by more than 1e-6 (relative, in the max norm).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <algorithm>
+#include "Gmsh.h"
+#include "GmshMessage.h"
+#include "OS.h"
+#include "linearSystemCSR.h"
+#include "linearSystemFull.h"
+
+// assemble the system on the n x n grid (with homogeneous Dirichlet
+// conditions outside the grid) and a right-hand side of 1; the convection
+// velocity (cx, cy) makes the system non-symmetric if it is not zero
+static void assemble(linearSystem<double> &sys, int n, double cx, double cy)
+{
+  sys.allocate(n * n);
+  for(int j = 0; j < n; j++){
+    for(int i = 0; i < n; i++){
+      int row = i + n * j;
+      double diag = 4. + fabs(cx) + fabs(cy);
+      sys.addToMatrix(row, row, diag);
+      if(i > 0) sys.addToMatrix(row, row - 1, -1. - (cx > 0. ? cx : 0.));
+      if(i < n - 1) sys.addToMatrix(row, row + 1, -1. + (cx < 0. ? cx : 0.));
+      if(j > 0) sys.addToMatrix(row, row - n, -1. - (cy > 0. ? cy : 0.));
+      if(j < n - 1) sys.addToMatrix(row, row + n, -1. + (cy < 0. ? cy : 0.));
+      sys.addToRightHandSide(row, 1.);
+    }
+  }
+}
+
+static bool check(const char *name, int n, double cx, double cy, int gmres,
+                  linearSystemCSRKrylov<double>::preconditioner precond,
+                  const char *precondName, linearSystemFull<double> &direct)
+{
+  linearSystemCSRKrylov<double> sys;
+  sys.setGmres(gmres);
+  sys.setPreconditioner(precond);
+  sys.setPrec(1.e-10);
+  assemble(sys, n, cx, cy);
+  double t1 = GetTimeInSeconds();
+  sys.systemSolve();
+  double t2 = GetTimeInSeconds();
+  double err = 0., norm = 0.;
+  for(int i = 0; i < n * n; i++){
+    double x, y;
+    sys.getFromSolution(i, x);
+    direct.getFromSolution(i, y);
+    err = std::max(err, fabs(x - y));
+    norm = std::max(norm, fabs(y));
+  }
+  bool ok = (err <= 1.e-6 * norm);
+  printf("%-28s %-5s %-6s: error %9.3e in %g s%s\n", name,
+         gmres ? "GMRES" : "CG", precondName, err / norm, t2 - t1,
+         ok ? "" : " FAILED");
+  return ok;
+}
+
+static bool checkAll(const char *name, int n, double cx, double cy)
+{
+  linearSystemFull<double> direct;
+  assemble(direct, n, cx, cy);
+  double t1 = GetTimeInSeconds();
+  direct.systemSolve();
+  double t2 = GetTimeInSeconds();
+  printf("%-28s direct (LU) : %g s\n", name, t2 - t1);
+
+  linearSystemCSRKrylov<double>::preconditioner p[3] =
+    {linearSystemCSRKrylov<double>::JACOBI, linearSystemCSRKrylov<double>::ILU0,
+     linearSystemCSRKrylov<double>::SSOR};
+  const char *pn[3] = {"Jacobi", "ILU0", "SSOR"};
+  bool ok = true;
+  for(int gmres = 0; gmres < 2; gmres++){
+    // CG requires a symmetric positive definite system
+    if(!gmres && (cx || cy)) continue;
+    for(int i = 0; i < 3; i++)
+      if(!check(name, n, cx, cy, gmres, p[i], pn[i], direct)) ok = false;
+  }
+  return ok;
+}
+
+int main(int argc, char **argv)
+{
+  GmshInitialize();
+  GmshSetOption("General", "Verbosity", 2.);
+  int n = (argc > 1) ? atoi(argv[1]) : 30;
+  printf("%d unknowns, %d thread(s)\n", n * n, Msg::GetMaxThreads());
+
+  bool ok = checkAll("Laplacian (SPD)", n, 0., 0.);
+  if(!checkAll("Convection-diffusion", n, 2., 1.)) ok = false;
+
+  GmshFinalize();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,134 @@
+// Benchmark of the element locator (MElementOctree) against the generic
+// Octree, on the interpolation of a nodal field at random points in a
+// tetrahedral mesh of the unit cube. Usage:
+//
+//   mainBenchmarkLocator [characteristic length (default: 0.03)]
+//                        [number of points (default: 1000000)]
+//
+// The number of threads used by the batch queries is controlled by
+// OMP_NUM_THREADS.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "Gmsh.h"
+#include "GModel.h"
+#include "MElement.h"
+#include "MElementOctree.h"
+#include "Octree.h"
+#include "GmshMessage.h"
+#include "OS.h"
+
+void MElementBB(void *a, double *min, double *max);
+int MElementInEle(void *a, double *x);
+
+static void MElementCentroid(void *a, double *x)
+{
+  MElement *e = (MElement*)a;
+  SPoint3 c = e->barycenter();
+  x[0] = c.x(); x[1] = c.y(); x[2] = c.z();
+}
+
+static void writeCube(const char *name, double lc)
+{
+  FILE *fp = fopen(name, "w");
+  fprintf(fp, "lc = %g;\n", lc);
+  fprintf(fp, "Point(1) = {0, 0, 0, lc}; Point(2) = {1, 0, 0, lc};\n");
+  fprintf(fp, "Point(3) = {1, 1, 0, lc}; Point(4) = {0, 1, 0, lc};\n");
+  fprintf(fp, "Line(1) = {1, 2}; Line(2) = {2, 3}; Line(3) = {3, 4};\n");
+  fprintf(fp, "Line(4) = {4, 1};\n");
+  fprintf(fp, "Line Loop(1) = {1, 2, 3, 4}; Plane Surface(1) = {1};\n");
+  fprintf(fp, "Extrude {0, 0, 1} { Surface{1}; }\n");
+  fclose(fp);
+}
+
+// interpolates f(x,y,z) = x + 2y + 3z, known at the nodes of e
+static double interpolate(MElement *e, const SPoint3 &p)
+{
+  if(!e) return 0.;
+  double xyz[3] = {p.x(), p.y(), p.z()}, uvw[3];
+  e->xyz2uvw(xyz, uvw);
+  double val[256];
+  for(int i = 0; i < e->getNumVertices(); i++){
+    MVertex *v = e->getVertex(i);
+    val[i] = v->x() + 2 * v->y() + 3 * v->z();
+  }
+  return e->interpolate(val, uvw[0], uvw[1], uvw[2]);
+}
+
+int main(int argc, char **argv)
+{
+  GmshInitialize();
+  GmshSetOption("General", "Verbosity", 2.);
+  double lc = (argc > 1) ? atof(argv[1]) : 0.03;
+  int n = (argc > 2) ? atoi(argv[2]) : 1000000;
+
+  writeCube("bench_cube.geo", lc);
+  GModel *m = new GModel();
+  m->readGEO("bench_cube.geo");
+  m->mesh(3);
+  std::vector<MElement*> tets;
+  for(GModel::riter it = m->firstRegion(); it != m->lastRegion(); ++it)
+    for(unsigned int i = 0; i < (*it)->getNumMeshElements(); i++)
+      tets.push_back((*it)->getMeshElement(i));
+  printf("%d tetrahedra, %d points\n", (int)tets.size(), n);
+
+  std::vector<SPoint3> points(n);
+  srand(1234);
+  for(int i = 0; i < n; i++)
+    points[i] = SPoint3((double)rand() / RAND_MAX, (double)rand() / RAND_MAX,
+                        (double)rand() / RAND_MAX);
+
+  // generic octree
+  double t1 = GetTimeInSeconds();
+  double min[3] = {-1e-6, -1e-6, -1e-6}, size[3] = {1 + 2e-6, 1 + 2e-6, 1 + 2e-6};
+  Octree *oct = Octree_Create(100, min, size, MElementBB, MElementCentroid,
+                              MElementInEle);
+  for(unsigned int i = 0; i < tets.size(); i++) Octree_Insert(tets[i], oct);
+  Octree_Arrange(oct);
+  double t2 = GetTimeInSeconds();
+  int found = 0;
+  double sum = 0.;
+  for(int i = 0; i < n; i++){
+    double P[3] = {points[i].x(), points[i].y(), points[i].z()};
+    MElement *e = (MElement*)Octree_Search(P, oct);
+    if(e) found++;
+    sum += interpolate(e, points[i]);
+  }
+  double t3 = GetTimeInSeconds();
+  printf("Octree:                  build %g s, %d found in %g s (sum %g)\n",
+         t2 - t1, found, t3 - t2, sum);
+  Octree_Delete(oct);
+
+  // element locator, one point at a time
+  t1 = GetTimeInSeconds();
+  MElementOctree loc(tets);
+  t2 = GetTimeInSeconds();
+  found = 0;
+  sum = 0.;
+  for(int i = 0; i < n; i++){
+    MElement *e = loc.find(points[i].x(), points[i].y(), points[i].z(), 3, true);
+    if(e) found++;
+    sum += interpolate(e, points[i]);
+  }
+  t3 = GetTimeInSeconds();
+  printf("MElementOctree:          build %g s, %d found in %g s (sum %g)\n",
+         t2 - t1, found, t3 - t2, sum);
+
+  // element locator, batch of points
+  t1 = GetTimeInSeconds();
+  std::vector<MElement*> elements;
+  loc.find(points, elements, 3, true);
+  found = 0;
+  sum = 0.;
+  for(int i = 0; i < n; i++){
+    if(elements[i]) found++;
+    sum += interpolate(elements[i], points[i]);
+  }
+  t2 = GetTimeInSeconds();
+  printf("MElementOctree (batch):  %d thread(s), %d found in %g s (sum %g)\n",
+         Msg::GetMaxThreads(), found, t2 - t1, sum);
+
+  delete m;
+  GmshFinalize();
+}
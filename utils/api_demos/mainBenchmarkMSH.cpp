@@ -0,0 +1,96 @@
+// Benchmark of the MSH file writers and readers on a large generated mesh.
+// Usage:
+//
+//   mainBenchmarkMSH [number of cubes per direction (default: 100)]
+//
+// The structured tetrahedral mesh of the unit cube is saved in ASCII and
+// binary MSH 2.2 and MSH 3 formats, sequentially and with parallel formatting,
+// and each file is read back with the historical number-by-number reader and
+// with the buffered reader (parallel number conversion for ASCII files,
+// memory mapping for binary files).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "Gmsh.h"
+#include "GModel.h"
+#include "MVertex.h"
+#include "MTetrahedron.h"
+#include "discreteRegion.h"
+#include "OS.h"
+
+static GModel *createMesh(int n)
+{
+  GModel *m = new GModel();
+  discreteRegion *gr = new discreteRegion(m, 1);
+  m->add(gr);
+  std::vector<MVertex*> v((n + 1) * (n + 1) * (n + 1));
+  for(int k = 0; k <= n; k++)
+    for(int j = 0; j <= n; j++)
+      for(int i = 0; i <= n; i++){
+        MVertex *mv = new MVertex((double)i / n, (double)j / n, (double)k / n, gr);
+        v[i + (n + 1) * (j + (n + 1) * k)] = mv;
+        gr->mesh_vertices.push_back(mv);
+      }
+  // split each cube into 6 tetrahedra sharing its main diagonal
+  static const int tets[6][4] = {{0, 1, 3, 7}, {0, 1, 5, 7}, {0, 2, 3, 7},
+                                 {0, 2, 6, 7}, {0, 4, 5, 7}, {0, 4, 6, 7}};
+  for(int k = 0; k < n; k++)
+    for(int j = 0; j < n; j++)
+      for(int i = 0; i < n; i++){
+        MVertex *c[8];
+        for(int l = 0; l < 8; l++)
+          c[l] = v[(i + (l & 1)) + (n + 1) * ((j + ((l >> 1) & 1)) +
+                                              (n + 1) * (k + ((l >> 2) & 1)))];
+        for(int l = 0; l < 6; l++)
+          gr->tetrahedra.push_back(new MTetrahedron(c[tets[l][0]], c[tets[l][1]],
+                                                    c[tets[l][2]], c[tets[l][3]]));
+      }
+  return m;
+}
+
+static void writeMesh(GModel *m, const char *name, double version, bool binary,
+                      int parallel)
+{
+  GmshSetOption("Mesh", "MshFileParallelWrite", (double)parallel);
+  double t1 = GetTimeInSeconds();
+  m->writeMSH(name, version, binary);
+  double t2 = GetTimeInSeconds();
+  printf("%-16s %-10s: written in %g s\n", name,
+         parallel ? "parallel" : "sequential", t2 - t1);
+}
+
+static void readMesh(const char *name, int buffered)
+{
+  GmshSetOption("Mesh", "MshFileBufferedRead", (double)buffered);
+  GModel *m = new GModel();
+  double t1 = GetTimeInSeconds();
+  m->readMSH(name);
+  double t2 = GetTimeInSeconds();
+  printf("%-16s %-10s: %d vertices, %d elements read in %g s\n", name,
+         buffered ? "buffered" : "legacy", m->getNumMeshVertices(),
+         m->getNumMeshElements(), t2 - t1);
+  delete m;
+}
+
+int main(int argc, char **argv)
+{
+  GmshInitialize();
+  int n = (argc > 1) ? atoi(argv[1]) : 100;
+
+  const char *files[4] = {"bench2.msh", "bench3.msh", "bench2_bin.msh",
+                          "bench3_bin.msh"};
+  GModel *m = createMesh(n);
+  for(int i = 0; i < 4; i++){
+    writeMesh(m, files[i], (i % 2) ? 3.0 : 2.2, i > 1, 0);
+    writeMesh(m, files[i], (i % 2) ? 3.0 : 2.2, i > 1, 1);
+  }
+  delete m;
+
+  for(int i = 0; i < 4; i++){
+    readMesh(files[i], 0);
+    readMesh(files[i], 1);
+  }
+
+  GmshFinalize();
+}
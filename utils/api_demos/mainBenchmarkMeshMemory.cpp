@@ -0,0 +1,70 @@
+// Benchmark of the memory usage and of the teardown time of a tetrahedral
+// mesh of the unit cube. Usage:
+//
+//   mainBenchmarkMeshMemory [characteristic length (default: 0.02)]
+//
+// Compare the results of Gmsh builds with and without the mesh entity pools
+// (cmake -DENABLE_MESH_POOL=ON/OFF).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "Gmsh.h"
+#include "GmshConfig.h"
+#include "GModel.h"
+#include "MEntityPool.h"
+#include "GmshMessage.h"
+#include "OS.h"
+
+static void writeCube(const char *name, double lc)
+{
+  FILE *fp = fopen(name, "w");
+  fprintf(fp, "lc = %g;\n", lc);
+  fprintf(fp, "Point(1) = {0, 0, 0, lc}; Point(2) = {1, 0, 0, lc};\n");
+  fprintf(fp, "Point(3) = {1, 1, 0, lc}; Point(4) = {0, 1, 0, lc};\n");
+  fprintf(fp, "Line(1) = {1, 2}; Line(2) = {2, 3}; Line(3) = {3, 4};\n");
+  fprintf(fp, "Line(4) = {4, 1};\n");
+  fprintf(fp, "Line Loop(1) = {1, 2, 3, 4}; Plane Surface(1) = {1};\n");
+  fprintf(fp, "Extrude {0, 0, 1} { Surface{1}; }\n");
+  fclose(fp);
+}
+
+int main(int argc, char **argv)
+{
+  GmshInitialize();
+  GmshSetOption("General", "Verbosity", 2.);
+  double lc = (argc > 1) ? atof(argv[1]) : 0.02;
+
+#if defined(HAVE_MESH_POOL)
+  printf("mesh entity pools enabled\n");
+#else
+  printf("mesh entity pools disabled\n");
+#endif
+  writeCube("bench_cube.geo", lc);
+  GModel *m = new GModel();
+  m->readGEO("bench_cube.geo");
+  long mem0 = GetMemoryUsage();
+  double t1 = GetTimeInSeconds();
+  m->mesh(3);
+  double t2 = GetTimeInSeconds();
+  printf("%d vertices, %d elements in %g s, peak RSS %g Mb (+%g Mb)\n",
+         m->getNumMeshVertices(), m->getNumMeshElements(), t2 - t1,
+         GetMemoryUsage() / 1024. / 1024., (GetMemoryUsage() - mem0) / 1024. / 1024.);
+#if defined(HAVE_MESH_POOL)
+  long numObjects;
+  size_t memory;
+  m->getMeshPool()->getStatistics(numObjects, memory);
+  printf("%ld pooled objects in %g Mb\n", numObjects, memory / 1024. / 1024.);
+#endif
+
+  t1 = GetTimeInSeconds();
+  m->deleteMesh();
+  t2 = GetTimeInSeconds();
+  printf("mesh deleted in %g s\n", t2 - t1);
+#if defined(HAVE_MESH_POOL)
+  m->getMeshPool()->getStatistics(numObjects, memory);
+  printf("%ld pooled objects in %g Mb\n", numObjects, memory / 1024. / 1024.);
+#endif
+
+  delete m;
+  GmshFinalize();
+}
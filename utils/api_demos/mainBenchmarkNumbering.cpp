@@ -0,0 +1,72 @@
+// Benchmark of the concurrent construction of mesh vertices and elements,
+// which get their numbers from the current model. Usage:
+//
+//   mainBenchmarkNumbering [number of elements (default: 4000000)]
+//
+// The construction is repeated with 1, 2, 4, ... threads, up to the maximum
+// number of threads (controlled by OMP_NUM_THREADS).
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include "Gmsh.h"
+#include "GModel.h"
+#include "MVertex.h"
+#include "MTetrahedron.h"
+#include "GmshMessage.h"
+#include "OS.h"
+#if defined(_OPENMP)
+#include <omp.h>
+#endif
+
+static void construct(int n, int numThreads)
+{
+  std::vector<MVertex*> vertices(n);
+  std::vector<MElement*> elements(n);
+  double t1 = GetTimeInSeconds();
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(numThreads)
+#endif
+  for(int i = 0; i < n; i++)
+    vertices[i] = new MVertex(i, 0., 0.);
+  double t2 = GetTimeInSeconds();
+#if defined(_OPENMP)
+#pragma omp parallel for num_threads(numThreads)
+#endif
+  for(int i = 0; i < n; i++)
+    elements[i] = new MTetrahedron(vertices[i], vertices[(i + 1) % n],
+                                   vertices[(i + 2) % n], vertices[(i + 3) % n]);
+  double t3 = GetTimeInSeconds();
+
+  // check that all the numbers are distinct
+  GModel *m = GModel::current();
+  std::vector<char> usedv(m->getMaxVertexNumber() + 1, 0);
+  std::vector<char> usede(m->getMaxElementNumber() + 1, 0);
+  int duplicates = 0;
+  for(int i = 0; i < n; i++){
+    if(usedv[vertices[i]->getNum()]++) duplicates++;
+    if(usede[elements[i]->getNum()]++) duplicates++;
+  }
+  printf("%2d thread(s): %g vertices/s, %g elements/s, %d duplicate number(s)\n",
+         numThreads, n / (t2 - t1), n / (t3 - t2), duplicates);
+
+  for(int i = 0; i < n; i++){
+    delete elements[i];
+    delete vertices[i];
+  }
+  m->setMaxVertexNumber(0);
+  m->setMaxElementNumber(0);
+}
+
+int main(int argc, char **argv)
+{
+  GmshInitialize();
+  GmshSetOption("General", "Verbosity", 2.);
+  int n = (argc > 1) ? atoi(argv[1]) : 4000000;
+
+  new GModel();
+  for(int t = 1; t <= Msg::GetMaxThreads(); t *= 2)
+    construct(n, t);
+
+  GmshFinalize();
+}
@@ -0,0 +1,44 @@
+// Converts a mesh to the compact (read-only) representation and saves it.
+// Usage:
+//
+//   mainCompactMesh file.msh [output file (default: compact.msh)]
+//
+// The mesh is saved before and after the conversion, and the memory used by
+// the compact mesh is reported.
+
+#include <stdio.h>
+#include <string>
+#include "Gmsh.h"
+#include "GModel.h"
+#include "compactMesh.h"
+#include "GmshMessage.h"
+#include "OS.h"
+
+int main(int argc, char **argv)
+{
+  if(argc < 2){
+    printf("Usage: %s file.msh [output file]\n", argv[0]);
+    return 1;
+  }
+  GmshInitialize();
+  GmshSetOption("General", "Verbosity", 2.);
+  std::string out = (argc > 2) ? argv[2] : "compact.msh";
+
+  GModel *m = new GModel();
+  m->readMSH(argv[1]);
+  printf("%d vertices, %d elements, peak RSS %g Mb\n", m->getNumMeshVertices(),
+         m->getNumMeshElements(), GetMemoryUsage() / 1024. / 1024.);
+  m->writeMSH("objects_" + out);
+
+  double t1 = GetTimeInSeconds();
+  if(!m->compactifyMesh()) return 1;
+  double t2 = GetTimeInSeconds();
+  compactMesh *cm = m->getCompactMesh();
+  printf("compact mesh: %d nodes, %d elements in %g Mb (%g s)\n",
+         cm->getNumNodes(), cm->getNumElements(),
+         cm->getMemoryUsage() / 1024. / 1024., t2 - t1);
+  m->writeMSH(out);
+
+  delete m;
+  GmshFinalize();
+}